@@ -0,0 +1,312 @@
+/*
+* 
+* Copyright (c) 2011, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/Cinder.h"
+#include "cinder/Thread.h"
+#include "boost/detail/atomic_count.hpp"
+#include "boost/intrusive_ptr.hpp"
+#include <vector>
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Reference counted block of float audio. Copies share 
+// the same samples, so a buffer can be handed from input 
+// to analysis to encoding without duplicating its data.
+class AudioBuffer
+{
+
+public:
+
+	// Sample layout
+	enum Layout
+	{
+		INTERLEAVED, 
+		PLANAR
+	};
+
+	// Read-only view of one channel
+	struct ChannelView
+	{
+
+		ChannelView() : data(0), stride(0), size(0) {}
+		ChannelView(const float * data, int32_t stride, int32_t size) : data(data), stride(stride), size(size) {}
+
+		// First sample, distance between samples and sample count
+		const float * data;
+		int32_t stride;
+		int32_t size;
+
+		// Sample at frame
+		float operator[](int32_t index) const { return data[index * stride]; }
+
+	};
+
+private:
+
+	// The object. Counts its own references, so pooled buffers 
+	// are handed out without allocating a shared count.
+	struct Obj
+	{
+
+		// Constructor
+		Obj() : mChannelCount(0), mFrameCount(0), mLayout(INTERLEAVED), mRecycle(0), mReferences(0), mSampleRate(0), mTimestamp(0.0) {}
+
+		// Reference counting for intrusive_ptr. The last release 
+		// hands pooled storage back instead of deleting it.
+		friend void intrusive_ptr_add_ref(Obj * buffer)
+		{
+			++buffer->mReferences;
+		}
+		friend void intrusive_ptr_release(Obj * buffer)
+		{
+			if (--buffer->mReferences == 0)
+			{
+				if (buffer->mRecycle != 0)
+					buffer->mRecycle(buffer);
+				else
+					delete buffer;
+			}
+		}
+
+		// Sets format and sizes storage
+		void set(int32_t frameCount, int32_t channelCount, int32_t sampleRate, Layout layout, double timestamp)
+		{
+
+			// Set properties
+			mChannelCount = channelCount;
+			mFrameCount = frameCount;
+			mLayout = layout;
+			mSampleRate = sampleRate;
+			mTimestamp = timestamp;
+
+			// Grow storage if needed, never shrinks 
+			// so recycled buffers don't reallocate
+			size_t mSize = (size_t)(frameCount * channelCount);
+			if (mData.size() < mSize)
+				mData.resize(mSize);
+
+		}
+
+		// Samples
+		vector<float> mData;
+
+		// Format
+		int32_t mChannelCount;
+		int32_t mFrameCount;
+		Layout mLayout;
+		int32_t mSampleRate;
+
+		// Time of first frame, in seconds
+		double mTimestamp;
+
+		// Pool which owns storage, and how to return it there
+		std::shared_ptr<void> mPool;
+		void (* mRecycle)(Obj * buffer);
+		boost::detail::atomic_count mReferences;
+
+	};
+
+	// Pointer to object
+	boost::intrusive_ptr<Obj> mObj;
+
+	// Constructor for pooled storage
+	AudioBuffer(Obj * obj) : mObj(obj) {}
+
+	// Pool needs access to storage
+	friend class AudioBufferPool;
+
+public:
+
+	// Constructors
+	AudioBuffer() {}
+	AudioBuffer(int32_t frameCount, int32_t channelCount, int32_t sampleRate, Layout layout = INTERLEAVED, double timestamp = 0.0)
+		: mObj(new Obj())
+	{
+		mObj->set(frameCount, channelCount, sampleRate, layout, timestamp);
+	}
+
+	// True if buffer has storage
+	operator bool() const { return mObj.get() != 0; }
+
+	// Returns view of one channel, regardless of layout
+	ChannelView getChannel(int32_t channel) const
+	{
+
+		// Bail if channel isn't available
+		if (!mObj || channel < 0 || channel >= mObj->mChannelCount)
+			return ChannelView();
+
+		// Interleaved samples are one frame apart, planar 
+		// channels are one channel length apart
+		const float * mData = &mObj->mData[0];
+		if (mObj->mLayout == INTERLEAVED)
+			return ChannelView(mData + channel, mObj->mChannelCount, mObj->mFrameCount);
+		return ChannelView(mData + channel * mObj->mFrameCount, 1, mObj->mFrameCount);
+
+	}
+
+	// Getters
+	int32_t getChannelCount() const { return mObj ? mObj->mChannelCount : 0; }
+	float * getData() const { return mObj && !mObj->mData.empty() ? &mObj->mData[0] : 0; }
+	double getDuration() const { return mObj && mObj->mSampleRate > 0 ? (double)mObj->mFrameCount / (double)mObj->mSampleRate : 0.0; }
+	int32_t getFrameCount() const { return mObj ? mObj->mFrameCount : 0; }
+	Layout getLayout() const { return mObj ? mObj->mLayout : INTERLEAVED; }
+	int32_t getSampleRate() const { return mObj ? mObj->mSampleRate : 0; }
+	int32_t getSize() const { return mObj ? mObj->mFrameCount * mObj->mChannelCount : 0; }
+	double getTimestamp() const { return mObj ? mObj->mTimestamp : 0.0; }
+
+	// Setters
+	void setTimestamp(double timestamp) { if (mObj) mObj->mTimestamp = timestamp; }
+
+};
+
+// Recycles AudioBuffer storage. Buffers created here return 
+// their samples to the pool when the last copy goes away, so 
+// steady state capture never touches the heap once the pool 
+// holds as many buffers as are in flight.
+class AudioBufferPool
+{
+
+private:
+
+	// The object
+	struct Obj
+	{
+
+		// Constructor
+		Obj(int32_t capacity, int32_t count)
+			: mCapacity(capacity)
+		{
+
+			// Preallocate storage, and room to return every buffer
+			mFree.reserve((size_t)count);
+			for (int32_t i = 0; i < count; i++)
+			{
+				AudioBuffer::Obj * mBuffer = new AudioBuffer::Obj();
+				mBuffer->mData.resize((size_t)mCapacity);
+				mFree.push_back(mBuffer);
+			}
+
+		}
+
+		// Destructor
+		~Obj()
+		{
+
+			// Free storage
+			for (vector<AudioBuffer::Obj *>::iterator mBuffer = mFree.begin(); mBuffer != mFree.end(); ++mBuffer)
+				delete * mBuffer;
+			mFree.clear();
+
+		}
+
+		// Samples per buffer
+		int32_t mCapacity;
+
+		// Storage not in use
+		vector<AudioBuffer::Obj *> mFree;
+		mutex mMutex;
+
+	};
+
+	// Returns storage to the pool. Buffers in use hold the pool 
+	// so they may safely outlive it. Free ones let go of it, so 
+	// the last buffer back may delete the pool and everything in it.
+	static void recycle(AudioBuffer::Obj * buffer)
+	{
+		std::shared_ptr<Obj> mPool = std::static_pointer_cast<Obj>(buffer->mPool);
+		buffer->mPool.reset();
+		lock_guard<mutex> mLock(mPool->mMutex);
+		mPool->mFree.push_back(buffer);
+	}
+
+	// Pointer to object
+	std::shared_ptr<Obj> mObj;
+
+public:
+
+	// Constructors
+	AudioBufferPool() {}
+	AudioBufferPool(int32_t capacity, int32_t count = 8) : mObj(std::shared_ptr<Obj>(new Obj(capacity, count))) {}
+
+	// Returns a buffer, reusing free storage when available
+	AudioBuffer create(int32_t frameCount, int32_t channelCount, int32_t sampleRate, AudioBuffer::Layout layout = AudioBuffer::INTERLEAVED, double timestamp = 0.0)
+	{
+
+		// Not pooled
+		if (!mObj)
+			return AudioBuffer(frameCount, channelCount, sampleRate, layout, timestamp);
+
+		// Take free storage, allocating if none is left
+		AudioBuffer::Obj * mBuffer = 0;
+		{
+			lock_guard<mutex> mLock(mObj->mMutex);
+			if (!mObj->mFree.empty())
+			{
+				mBuffer = mObj->mFree.back();
+				mObj->mFree.pop_back();
+			}
+		}
+		if (mBuffer == 0)
+		{
+			mBuffer = new AudioBuffer::Obj();
+			mBuffer->mData.resize((size_t)mObj->mCapacity);
+		}
+
+		// Set format and hand out, tied to the pool
+		mBuffer->set(frameCount, channelCount, sampleRate, layout, timestamp);
+		mBuffer->mPool = mObj;
+		mBuffer->mRecycle = &AudioBufferPool::recycle;
+		return AudioBuffer(mBuffer);
+
+	}
+
+	// Getters
+	int32_t getCapacity() const { return mObj ? mObj->mCapacity : 0; }
+	int32_t getFreeCount() const 
+	{ 
+		if (!mObj)
+			return 0;
+		lock_guard<mutex> mLock(mObj->mMutex);
+		return (int32_t)mObj->mFree.size(); 
+	}
+
+};
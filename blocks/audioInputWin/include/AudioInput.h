@@ -38,6 +38,7 @@
 
 // Includes
 #include <algorithm>
+#include "AudioBuffer.h"
 #include "boost/bind.hpp"
 #include "boost/signals2.hpp"
 #include "cinder/app/AppBasic.h"
@@ -113,6 +114,11 @@ private:
 			// Initialize flag
 			mReceiving = false;
 
+			// Initialize buffers
+			mBuffer = 0;
+			mBufferSize = 0;
+			mFramesReceived = 0;
+
 			// Set parameters
 			mBitsPerSample = bitsPerSample;
 			mChannelCount = channelCount;
@@ -127,6 +133,10 @@ private:
 			mWavFormat.wBitsPerSample = mBitsPerSample;
 			mWavFormat.cbSize = 0;
 
+			// Recycle normalized buffers. Keep enough storage for
+			// every buffer the device can have in flight.
+			mPool = AudioBufferPool(BUFFER_LENGTH, BUFFER_COUNT);
+
 			// Initialize device list
 			mDeviceId = 0;
 			mDeviceCount = -1;
@@ -151,8 +161,6 @@ private:
 			// Free resoures
 			if (mBuffer != 0)
 				delete [] mBuffer;
-			if (mNormalBuffer != 0)
-				delete [] mNormalBuffer;
 
 		}
 
@@ -224,44 +232,59 @@ private:
 
 		}
 
-		// Returns data as -1 to 1 float
-		float * getNormalizedData()
+		// Returns copy of current buffer
+		AudioBuffer getBuffer()
+		{
+
+			// DO IT!
+			lock_guard<mutex> mLock(mNormalMutex);
+			return mNormalBuffer;
+
+		}
+
+		// Converts data to -1 to 1 float in a pooled buffer, 
+		// which becomes the current buffer
+		AudioBuffer normalize()
 		{
 
 			// Bail if there's no data to convert
 			if (mBuffer == 0) 
-				return 0;
-
-			// Delete buffer if it's the wrong size
-			if (mNormalBuffer != 0 && sizeof(mNormalBuffer) != mBufferSize)
-			{
-				delete [] mNormalBuffer;
-				mNormalBuffer = 0;
-			}
+				return AudioBuffer();
 
-			// Create buffer, if needed
-			if (mNormalBuffer == 0)
-				mNormalBuffer = new float[mBufferSize];
+			// Take a buffer from the pool, stamped with 
+			// the time of its first frame
+			int32_t mFrameCount = mBufferSize / mChannelCount;
+			AudioBuffer mNormal = mPool.create(mFrameCount, mChannelCount, mSampleRate, AudioBuffer::INTERLEAVED, (double)mFramesReceived / (double)mSampleRate);
+			float * mData = mNormal.getData();
+			int32_t mSize = mNormal.getSize();
 
 			// Normalize data for analysis
 			switch (mBitsPerSample)
 			{
 			case 8: 
-				for (int32_t i = 0; i < mBufferSize; i++)
-					mNormalBuffer[i] = (float)(mBuffer[i] / (1.0 * 0x80) - 1.0);
+				for (int32_t i = 0; i < mSize; i++)
+					mData[i] = (float)(mBuffer[i] / (1.0 * 0x80) - 1.0);
 				break;
 			case 16: 
-				for (int32_t i = 0; i < mBufferSize; i++)
-					mNormalBuffer[i] = (float)(mBuffer[i] / (1.0 * 0x8000));
+				for (int32_t i = 0; i < mSize; i++)
+					mData[i] = (float)(mBuffer[i] / (1.0 * 0x8000));
 				break;
 			case 32: 
-				for (int32_t i = 0; i < mBufferSize; i++)
-					mNormalBuffer[i] = (float)(mBuffer[i] / (8.0 * 0x10000000));
+				for (int32_t i = 0; i < mSize; i++)
+					mData[i] = (float)(mBuffer[i] / (8.0 * 0x10000000));
 				break;
 			}
 
+			// Replace current buffer. The old one goes back to 
+			// the pool once every holder has released it.
+			{
+				lock_guard<mutex> mLock(mNormalMutex);
+				mNormalBuffer = mNormal;
+			}
+			mFramesReceived += mFrameCount;
+
 			// Return normalized buffer
-			return mNormalBuffer;
+			return mNormal;
 
 		}
 
@@ -287,8 +310,10 @@ private:
 						mBufferSize = (int32_t)((unsigned long)((WAVEHDR *)message.lParam)->dwBytesRecorded / sizeof(T));
 						mBuffer = (T *)((WAVEHDR *)message.lParam)->lpData;
 
-						// Execute callbacks
-						mSignal(getNormalizedData(), mBufferSize);
+						// Execute callbacks, holding the buffer until they're done
+						AudioBuffer mNormal = normalize();
+						mSignal(mNormal.getData(), mBufferSize);
+						mBufferSignal(mNormal);
 
 					}
 
@@ -358,7 +383,11 @@ private:
 
 				// Initialize buffers
 				mBuffer = 0;
-				mNormalBuffer = 0;
+				mFramesReceived = 0;
+				{
+					lock_guard<mutex> mLock(mNormalMutex);
+					mNormalBuffer = AudioBuffer();
+				}
 
 				// Start callback thread
 				DWORD threadID;
@@ -469,8 +498,11 @@ private:
 		uint_least8_t mBuffersComplete;
 		int32_t mBufferSize;
 
-		// Buffer for analyzing audio
-		float * mNormalBuffer;
+		// Buffer for analyzing audio, shared with callbacks
+		AudioBuffer mNormalBuffer;
+		AudioBufferPool mPool;
+		mutex mNormalMutex;
+		uint64_t mFramesReceived;
 
 		// Windows multimedia API
 		HANDLE mWaveInThread;
@@ -486,6 +518,7 @@ private:
 
 		// Callback list
 		boost::signals2::signal<void (float *, int32_t)> mSignal;
+		boost::signals2::signal<void (const AudioBuffer &)> mBufferSignal;
 		CallbackList mCallbacks;
 
 		// Device list
@@ -513,12 +546,12 @@ public:
 
 	// Methods
 	int32_t getBitsPerSample() { return mObj->mBitsPerSample; }
+	AudioBuffer getBuffer() { return mObj->getBuffer(); }
 	int32_t getChannelCount() { return mObj->mChannelCount; }
 	T * getData() { return mObj->mBuffer; }
 	int32_t getDataSize() { return mObj->mBufferSize; }
 	int32_t getDeviceCount() { return mObj->mDeviceCount; }
 	DeviceList getDeviceList() { return mObj->getDeviceList(); }
-	float * getNormalizedData() { return mObj->mNormalBuffer; }
 	int32_t getSampleRate() { return mObj->mSampleRate; }
 	bool isReceiving() { return mObj->mReceiving; }
 	void setDevice(int32_t deviceID) { mObj->setDevice(deviceID); }
@@ -541,6 +574,23 @@ public:
 
 	}
 
+	// Add callback which receives the normalized buffer itself. Keep 
+	// a copy of the buffer to hold on to it past the callback.
+	template<typename U>
+	int32_t addBufferCallback(void (U::* callbackFunction)(const AudioBuffer & buffer), U * callbackObject) 
+	{
+
+		// Determine return ID
+		int32_t mCallbackID = mObj->mCallbacks.empty() ? 0 : mObj->mCallbacks.rbegin()->first + 1;
+
+		// Create callback and add it to the list
+		mObj->mCallbacks.insert(make_pair(mCallbackID, CallbackRef(new Callback(mObj->mBufferSignal.connect(boost::function<void (const AudioBuffer &)>(boost::bind(callbackFunction, callbackObject, ::_1)))))));
+
+		// Return callback ID
+		return mCallbackID;
+
+	}
+
 	// Removes callback
 	void removeCallback(int32_t callbackID) 
 	{
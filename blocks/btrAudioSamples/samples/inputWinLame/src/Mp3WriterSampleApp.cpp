@@ -42,7 +42,7 @@ public:
 	void update();
 
 	// Audio input handler
-	void onData(float * data, int32_t size);
+	void onData(const AudioBuffer & buffer);
 
 private:
 
@@ -54,12 +54,10 @@ private:
 	uint32_t mState;
 
 	// Files
-	string mFileWav;
 	string mFileMp3;
 
 	// Audio input
 	AudioInput mAudioInput;
-	float * mInputData;
 	double mTestPause;
 	double mTestStartTime;
 	double mTestDuration;
@@ -73,26 +71,11 @@ private:
 	float * mOutputData;
 	audio::TrackRef mTrack;
 
-	// File writing
-	ofstream mFile;
-	AudioInput::WAVFILEHEADER mFileHeader;
-	int16_t * mPcmBuffer;
-	int32_t mPcmBufferPosition;
-	int32_t mPcmBufferSize;
-	uint32_t mPcmTotalSize;
+	// Recording flag
 	bool mRecording;
 
-	// WAV format
-	int32_t mBitsPerSample;
-	int32_t mChannelCount;
-	int32_t mSampleRate;
-
-	// Writes PCM buffer to file
-	void writeData();
-
 	// MP3 encoding
 	Lame mEncoder;
-	void encode();
 
 	// Drawing
 	Area mAreaEncoder;
@@ -142,15 +125,17 @@ void Mp3WriterSampleApp::draw()
 	gl::draw(mTextFieldOutput.getTexture(), mTextFieldOutput.getBounds());
 
 	// Input
-	if (mState == TestState::INPUT && mInputData != 0)
+	AudioBuffer mInputBuffer = mAudioInput.getBuffer();
+	if (mState == TestState::INPUT && mInputBuffer)
 	{
 
 		// Update color
 		setColor(TestState::INPUT);
 		gl::color(mColor);
 
-		// Get size of data
-		int32_t mDataSize = mAudioInput.getDataSize();
+		// Get data and its size
+		float * mInputData = mInputBuffer.getData();
+		int32_t mDataSize = mInputBuffer.getSize();
 
 		// Get dimensions
 		float mScale = (float)mAreaInput.getWidth() / (float)mDataSize;
@@ -229,28 +214,13 @@ void Mp3WriterSampleApp::keyUp(KeyEvent event)
 }
 
 // Called when buffer is full
-void Mp3WriterSampleApp::onData(float * data, int32_t size)
+void Mp3WriterSampleApp::onData(const AudioBuffer & buffer)
 {
 
-	// Get data
-	mInputData = data;
-
-	// Check recording flag and buffer size
+	// Pass buffer straight to encoder, which 
+	// converts it on its own thread
 	if (mRecording)
-	{
-
-		// Save the PCM data to file and reset the array if we 
-		// don't have room for this buffer
-		if (mPcmBufferPosition + size >= mPcmBufferSize) 
-			writeData();
-
-		// Copy PCM data to file buffer
-		copy(mAudioInput.getData(), mAudioInput.getData() + size, mPcmBuffer + mPcmBufferPosition);
-
-		// Update PCM position
-		mPcmBufferPosition += size;
-
-	}
+		mEncoder.write(buffer);
 
 }
 
@@ -265,13 +235,8 @@ void Mp3WriterSampleApp::quit()
 		mAudioInput.stop();
 	}
 
-	// Free resources
-	if (mInputData != 0)
-		delete [] mInputData;
-	if (mOutputData != 0)
-		delete [] mOutputData;
-	if (mPcmBuffer != 0)
-		delete [] mPcmBuffer;
+	// Finish encoding
+	mEncoder.stop();
 
 }
 
@@ -319,37 +284,12 @@ void Mp3WriterSampleApp::setup()
 	mTestPause = 1.0;
 	mTestStartTime = 0.0;
 
-	// Set file names
+	// Set file name
 	mFileMp3 = getAppPath() + "test.mp3";
-	mFileWav = getAppPath() + "test.wav";
 
-	// Define audio settings
-	mBitsPerSample = sizeof(int16_t) * 8;
-	mChannelCount = 2;
-	mSampleRate = 44100;
-
-	// Set up file stream
+	// Initialize flag and buffers
 	mRecording = false;
-	mPcmBufferSize = (BUFFER_COUNT * BUFFER_LENGTH) / sizeof(int16_t); // Defined in AudioInput.h
-	mPcmBuffer = new int16_t[mPcmBufferSize];
-	memset(mPcmBuffer, (int16_t)0, mPcmBufferSize);
-
-	// Set up output file header
-	mFileHeader.siz_wf = mBitsPerSample;
-	mFileHeader.wFormatTag = WAVE_FORMAT_PCM;
-	mFileHeader.nChannels = mChannelCount;
-	mFileHeader.nSamplesPerSec = mSampleRate;
-	mFileHeader.nAvgBytesPerSec = mSampleRate * mChannelCount * sizeof(int16_t);
-	mFileHeader.nBlockAlign = mChannelCount * sizeof(int16_t);
-	mFileHeader.wBitsPerSample = mBitsPerSample;
-	memcpy(mFileHeader.RIFF, "RIFF", 4);
-	memcpy(mFileHeader.WAVE, "WAVE", 4);
-	memcpy(mFileHeader.fmt, "fmt ", 4);
-	memcpy(mFileHeader.data, "data", 4);
-
-	// Initialize buffers
 	mFftInit = false;
-	mInputData = 0;
 	mOutputData = 0;
 
 	// Set color and font
@@ -358,7 +298,7 @@ void Mp3WriterSampleApp::setup()
 
 	// Set up instructions text
 	mTextFieldInstructions = TextField(Vec2i(10, 10), mFont);
-	mTextFieldInstructions.str("Press SPACE to start test\nRecords WAV for five seconds, then encodes and plays back MP3");
+	mTextFieldInstructions.str("Press SPACE to start test\nEncodes input to MP3 for five seconds, then plays it back");
 
 	// Input
 	mTextFieldInput = TextField(Vec2i(mTextFieldInstructions.getBounds().getX1(), mTextFieldInstructions.getBounds().getY2() + mTextFieldInstructions.getBounds().getY1()), mFont);
@@ -393,28 +333,13 @@ void Mp3WriterSampleApp::update()
 			if (getElapsedSeconds() - mTestStartTime >= mTestDuration)
 			{
 
-				// Save remaining data
-				if (mPcmBufferSize > 0) 
-					writeData();
-
-				// Close file
-				if (mFile.is_open())
-				{
-					mFile.flush();
-					mFile.close();
-				}
-
 				// Stop input
 				mAudioInput.removeCallback(mCallbackId);
 				mAudioInput.stop();
 				mRecording = false;
-				
-				// Pause
-				mTestStartTime = getElapsedSeconds();
-				while (getElapsedSeconds() - mTestStartTime >= mTestPause);
 
-				// Encode
-				mEncoder.encode(mFileWav, mFileMp3);
+				// Encode what's queued and close file
+				mEncoder.stop();
 				mState = TestState::ENCODE;
 
 			}
@@ -423,16 +348,12 @@ void Mp3WriterSampleApp::update()
 		else
 		{
 
+			// Start encoder
+			mEncoder.start(mFileMp3, mAudioInput.getSampleRate(), mAudioInput.getChannelCount());
+
 			// Start receiving audio
 			mAudioInput.start();
-			mCallbackId = mAudioInput.addCallback<Mp3WriterSampleApp>(&Mp3WriterSampleApp::onData, this);
-
-			// Set size values
-			mPcmBufferPosition = 0;
-			mPcmTotalSize = 0;
-
-			// Open file for streaming
-			mFile.open(mFileWav, ios::binary|ios::trunc);
+			mCallbackId = mAudioInput.addBufferCallback<Mp3WriterSampleApp>(&Mp3WriterSampleApp::onData, this);
 
 			// Start recording
 			mTestStartTime = getElapsedSeconds();
@@ -529,26 +450,5 @@ void Mp3WriterSampleApp::update()
 
 }
 
-// Append file buffer to output WAV
-void Mp3WriterSampleApp::writeData()
-{
-
-	// Update header with new PCM length
-	mPcmBufferPosition *= sizeof(int16_t);
-	mPcmTotalSize += mPcmBufferPosition;
-	mFileHeader.bytes = mPcmTotalSize + sizeof(AudioInput::WAVFILEHEADER);
-	mFileHeader.pcmbytes = mPcmTotalSize;
-	mFile.seekp(0);
-	mFile.write(reinterpret_cast<char *>(&mFileHeader), sizeof(mFileHeader));
-
-	// Append PCM data
-	mFile.seekp(mPcmTotalSize - mPcmBufferPosition + sizeof(AudioInput::WAVFILEHEADER));
-	mFile.write(reinterpret_cast<char *>(mPcmBuffer), mPcmBufferPosition);
-
-	// Reset file buffer position
-	mPcmBufferPosition = 0;
-
-}
-
 // Start application
 CINDER_APP_BASIC(Mp3WriterSampleApp, RendererGl)
@@ -21,7 +21,7 @@ public:
 	void setup();
 	
 	// Receives input
-	void onData(float * data, int32_t size);
+	void onData(const AudioBuffer & buffer);
 
 	// Writes PCM buffer to file
 	void writeData();
@@ -30,13 +30,16 @@ private:
 
 	// Audio input
 	AudioInput mInput;
-	float * mData;
+
+	// Buffers waiting to be written
+	vector<AudioBuffer> mPending;
+	int32_t mPendingSize;
+	mutex mPendingMutex;
 
 	// File writing
 	ofstream mFile;
 	AudioInput::WAVFILEHEADER mFileHeader;
 	int16_t * mPcmBuffer;
-	int32_t mPcmBufferPosition;
 	int32_t mPcmBufferSize;
 	uint32_t mPcmTotalSize;
 	bool mRecording;
@@ -56,11 +59,13 @@ void WavWriterSampleApp::draw()
 	gl::clear(Color(0.0f, 0.0f, 0.0f));
 
 	// Get data
-	if (mData != 0)
+	AudioBuffer mBuffer = mInput.getBuffer();
+	if (mBuffer)
 	{
 
-		// Get size of data
-		int32_t mDataSize = mInput.getDataSize();
+		// Get data and its size
+		float * mData = mBuffer.getData();
+		int32_t mDataSize = mBuffer.getSize();
 
 		// Get dimensions
 		float mScale = ((float)getWindowWidth() - 20.0f) / (float)mDataSize;
@@ -99,8 +104,8 @@ void WavWriterSampleApp::keyUp(KeyEvent event)
 		{
 
 			// Save remaining data
-			if (mPcmBufferSize > 0) 
-				writeData();
+			lock_guard<mutex> mLock(mPendingMutex);
+			writeData();
 
 			// Close file
 			if (mFile.is_open())
@@ -114,7 +119,9 @@ void WavWriterSampleApp::keyUp(KeyEvent event)
 		{
 
 			// Set size values
-			mPcmBufferPosition = 0;
+			lock_guard<mutex> mLock(mPendingMutex);
+			mPending.clear();
+			mPendingSize = 0;
 			mPcmTotalSize = 0;
 
 			// Open file for streaming
@@ -130,26 +137,21 @@ void WavWriterSampleApp::keyUp(KeyEvent event)
 }
 
 // Called when buffer is full
-void WavWriterSampleApp::onData(float * data, int32_t size)
+void WavWriterSampleApp::onData(const AudioBuffer & buffer)
 {
 
-	// Get float data
-	mData = data;
-
 	// Check recording flag and buffer size
-	if (mRecording && size <= BUFFER_LENGTH)
+	if (mRecording && buffer.getSize() <= BUFFER_LENGTH)
 	{
 
-		// Save the PCM data to file and reset the array if we 
-		// don't have room for this buffer
-		if (mPcmBufferPosition + size >= mPcmBufferSize) 
+		// Save the pending data to file if we don't have room for this buffer
+		lock_guard<mutex> mLock(mPendingMutex);
+		if (mPendingSize + buffer.getSize() >= mPcmBufferSize) 
 			writeData();
 
-		// Copy PCM data to file buffer
-		copy(mInput.getData(), mInput.getData() + size, mPcmBuffer + mPcmBufferPosition);
-
-		// Update PCM position
-		mPcmBufferPosition += size;
+		// Hold on to buffer until it's written. No copy is made here.
+		mPending.push_back(buffer);
+		mPendingSize += buffer.getSize();
 
 	}
 
@@ -163,17 +165,29 @@ void WavWriterSampleApp::quit()
 	mInput.stop();
 
 	// Free resources
-	if (mData != 0)
-		delete [] mData;
+	mPending.clear();
 	if (mPcmBuffer != 0)
 		delete [] mPcmBuffer;
 
 }
 
-// Append file buffer to output WAV
+// Append pending buffers to output WAV
 void WavWriterSampleApp::writeData()
 {
 
+	// Convert pending buffers to 16-bit PCM, then release 
+	// them back to the input's pool
+	int32_t mPcmBufferPosition = 0;
+	for (vector<AudioBuffer>::const_iterator mBuffer = mPending.begin(); mBuffer != mPending.end(); ++mBuffer)
+	{
+		const float * mData = mBuffer->getData();
+		int32_t mSize = math<int32_t>::min(mBuffer->getSize(), mPcmBufferSize - mPcmBufferPosition);
+		for (int32_t i = 0; i < mSize; i++)
+			mPcmBuffer[mPcmBufferPosition++] = (int16_t)(math<float>::clamp(mData[i], -1.0f, 1.0f) * 32767.0f);
+	}
+	mPending.clear();
+	mPendingSize = 0;
+
 	// Update header with new PCM length
 	mPcmBufferPosition *= sizeof(int16_t);
 	mPcmTotalSize += mPcmBufferPosition;
@@ -189,9 +203,6 @@ void WavWriterSampleApp::writeData()
 		mFile.write(reinterpret_cast<char *>(mPcmBuffer), mPcmBufferPosition);
 	}
 
-	// Reset file buffer position
-	mPcmBufferPosition = 0;
-
 }
 
 // Set up
@@ -219,6 +230,8 @@ void WavWriterSampleApp::setup()
 	mPcmBufferSize = (BUFFER_COUNT * BUFFER_LENGTH) / sizeof(int16_t); // Defined in AudioInput.h
 	mPcmBuffer = new int16_t[mPcmBufferSize];
 	memset(mPcmBuffer, (int16_t)0, mPcmBufferSize);
+	mPending.reserve(BUFFER_COUNT);
+	mPendingSize = 0;
 
 	// Set up output file header
 	mFileHeader.siz_wf = mBitsPerSample;
@@ -233,11 +246,8 @@ void WavWriterSampleApp::setup()
 	memcpy(mFileHeader.fmt, "fmt ", 4);
 	memcpy(mFileHeader.data, "data", 4);
 
-	// Initialize buffer
-	mData = 0;
-
 	// Start receiving audio
-	mInput.addCallback<WavWriterSampleApp>(&WavWriterSampleApp::onData, this);
+	mInput.addBufferCallback<WavWriterSampleApp>(&WavWriterSampleApp::onData, this);
 	mInput.start();
 
 	// List devices -- setting device other than 0 not yet implemented
@@ -0,0 +1,230 @@
+// Includes
+#include "cinder/app/AppBasic.h"
+#include "cinder/CinderMath.h"
+#include "cinder/Rand.h"
+#include "cinder/Timer.h"
+#include "cinder/Utilities.h"
+#include "ChannelMixer.h"
+#include "Resampler.h"
+
+// Imports
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Times 48k to 44.1k resampling and stereo to mono mixing
+class ResamplerBenchmarkApp : public AppBasic 
+{
+
+public:
+
+	// Cinder callbacks
+	void draw();
+	void keyDown(KeyEvent event);
+	void setup();
+
+private:
+
+	// Audio length and block size
+	static const int32_t kBlockFrames = 512;
+	static const int32_t kSeconds = 60;
+
+	// Runs all benchmarks
+	void run();
+
+	// Benchmarks, each returning seconds of audio per second of CPU
+	double benchLinear(const vector<float> & input, int32_t channelCount);
+	double benchMixer(const vector<float> & input);
+	double benchMixLoop(const vector<float> & input);
+	double benchResampler(const vector<float> & input, int32_t channelCount, int32_t tapCount);
+
+	// Adds result line
+	void report(const string & name, double speed);
+
+	// Results
+	vector<string> mResults;
+
+};
+
+// Resample with linear interpolation, for comparison
+double ResamplerBenchmarkApp::benchLinear(const vector<float> & input, int32_t channelCount)
+{
+
+	// Step through input in fractional frames
+	int32_t mFrames = (int32_t)input.size() / channelCount;
+	double mStep = 48000.0 / 44100.0;
+	vector<float> mOutput(kBlockFrames * channelCount);
+	float mSum = 0.0f;
+	Timer mTimer(true);
+	double mPosition = 0.0;
+	while (mPosition < (double)(mFrames - 1))
+	{
+		int32_t mCount = 0;
+		for (; mCount < kBlockFrames && mPosition < (double)(mFrames - 1); mCount++, mPosition += mStep)
+		{
+			int32_t mIndex = (int32_t)mPosition;
+			float mFraction = (float)(mPosition - (double)mIndex);
+			for (int32_t i = 0; i < channelCount; i++)
+			{
+				float mA = input[mIndex * channelCount + i];
+				float mB = input[(mIndex + 1) * channelCount + i];
+				mOutput[mCount * channelCount + i] = mA + (mB - mA) * mFraction;
+			}
+		}
+		mSum += mOutput[0];
+	}
+	mTimer.stop();
+
+	// Keep result so the loop isn't optimized out
+	if (mSum == 12345.0f)
+		console() << mSum;
+	return (double)kSeconds / mTimer.getSeconds();
+
+}
+
+// Mix stereo to mono with ChannelMixer
+double ResamplerBenchmarkApp::benchMixer(const vector<float> & input)
+{
+
+	// Mix in blocks
+	ChannelMixer mMixer(2, 1, kBlockFrames);
+	int32_t mFrames = (int32_t)input.size() / 2;
+	float mSum = 0.0f;
+	Timer mTimer(true);
+	for (int32_t i = 0; i + kBlockFrames <= mFrames; i += kBlockFrames)
+	{
+		mMixer.process(&input[i * 2], kBlockFrames);
+		mSum += mMixer.getData()[0];
+	}
+	mTimer.stop();
+
+	// Keep result so the loop isn't optimized out
+	if (mSum == 12345.0f)
+		console() << mSum;
+	return (double)kSeconds / mTimer.getSeconds();
+
+}
+
+// Mix stereo to mono with a plain loop, for comparison
+double ResamplerBenchmarkApp::benchMixLoop(const vector<float> & input)
+{
+
+	// Mix in blocks
+	vector<float> mOutput(kBlockFrames);
+	int32_t mFrames = (int32_t)input.size() / 2;
+	float mSum = 0.0f;
+	Timer mTimer(true);
+	for (int32_t i = 0; i + kBlockFrames <= mFrames; i += kBlockFrames)
+	{
+		for (int32_t j = 0; j < kBlockFrames; j++)
+			mOutput[j] = (input[(i + j) * 2] + input[(i + j) * 2 + 1]) * 0.5f;
+		mSum += mOutput[0];
+	}
+	mTimer.stop();
+
+	// Keep result so the loop isn't optimized out
+	if (mSum == 12345.0f)
+		console() << mSum;
+	return (double)kSeconds / mTimer.getSeconds();
+
+}
+
+// Resample 48k to 44.1k with Resampler
+double ResamplerBenchmarkApp::benchResampler(const vector<float> & input, int32_t channelCount, int32_t tapCount)
+{
+
+	// Convert in blocks
+	Resampler mResampler(48000, 44100, channelCount, kBlockFrames, tapCount);
+	int32_t mFrames = (int32_t)input.size() / channelCount;
+	float mSum = 0.0f;
+	Timer mTimer(true);
+	for (int32_t i = 0; i + kBlockFrames <= mFrames; i += kBlockFrames)
+		if (mResampler.process(&input[i * channelCount], kBlockFrames) > 0)
+			mSum += mResampler.getData()[0];
+	mTimer.stop();
+
+	// Keep result so the loop isn't optimized out
+	if (mSum == 12345.0f)
+		console() << mSum;
+	return (double)kSeconds / mTimer.getSeconds();
+
+}
+
+// Render
+void ResamplerBenchmarkApp::draw()
+{
+
+	// Clear screen
+	gl::clear(Color(0.0f, 0.0f, 0.0f));
+
+	// Draw results
+	for (size_t i = 0; i < mResults.size(); i++)
+		gl::drawString(mResults[i], Vec2f(20.0f, 20.0f + (float)i * 20.0f));
+
+}
+
+// Handles key press
+void ResamplerBenchmarkApp::keyDown(KeyEvent event)
+{
+
+	// Run again on space
+	if (event.getCode() == KeyEvent::KEY_SPACE)
+		run();
+
+}
+
+// Adds result line
+void ResamplerBenchmarkApp::report(const string & name, double speed)
+{
+
+	// Print and keep line
+	string mLine = name + ": " + toString((int32_t)speed) + "x realtime";
+	console() << mLine << "\n";
+	mResults.push_back(mLine);
+
+}
+
+// Runs all benchmarks
+void ResamplerBenchmarkApp::run()
+{
+
+	// Make a minute of noise at 48k in mono and stereo
+	mResults.clear();
+	Rand mRand(1);
+	vector<float> mMono(48000 * kSeconds);
+	vector<float> mStereo(48000 * kSeconds * 2);
+	for (size_t i = 0; i < mMono.size(); i++)
+		mMono[i] = mRand.nextFloat(-1.0f, 1.0f);
+	for (size_t i = 0; i < mStereo.size(); i++)
+		mStereo[i] = mRand.nextFloat(-1.0f, 1.0f);
+
+	// Resample
+	report("48k to 44.1k mono, linear", benchLinear(mMono, 1));
+	report("48k to 44.1k mono, 16 taps", benchResampler(mMono, 1, 16));
+	report("48k to 44.1k mono, 32 taps", benchResampler(mMono, 1, 32));
+	report("48k to 44.1k mono, 64 taps", benchResampler(mMono, 1, 64));
+	report("48k to 44.1k stereo, linear", benchLinear(mStereo, 2));
+	report("48k to 44.1k stereo, 32 taps", benchResampler(mStereo, 2, 32));
+
+	// Mix
+	report("Stereo to mono, loop", benchMixLoop(mStereo));
+	report("Stereo to mono, ChannelMixer", benchMixer(mStereo));
+	mResults.push_back("Press space to run again");
+
+}
+
+// Set up
+void ResamplerBenchmarkApp::setup()
+{
+
+	// Set up window
+	setFrameRate(60);
+	setWindowSize(600, 240);
+
+	// DO IT!
+	run();
+
+}
+
+// Start application
+CINDER_APP_BASIC(ResamplerBenchmarkApp, RendererGl)
@@ -0,0 +1,103 @@
+/*
+* 
+* Copyright (c) 2011, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include <ciTri.h>
+#include <vector>
+
+// Follows triangles from frame to frame. Each triangle is matched 
+// to the nearest one from the last frame by centroid, through a 
+// spatial hash, and takes its id and centroid as prevCentroid. 
+// Triangles with no match nearby get new ids.
+class TriangleTracker
+{
+
+public:
+
+	// Con/de-structor. Triangles match if their centroids are 
+	// within maxDistance of each other.
+	TriangleTracker(float maxDistance = 10.0f);
+	~TriangleTracker();
+
+	// Triangulates outline and tracks the result. If no point 
+	// has moved further than the reuse tolerance and the count 
+	// is the same, last frame's triangles are moved instead.
+	const std::vector<Triangle> & update(const std::vector<ci::Vec2f> & points);
+
+	// Matches triangles to last frame's, setting ids and 
+	// previous centroids
+	void track(std::vector<Triangle> & triangles);
+
+	// Forgets last frame
+	void reset();
+
+	// Get/set settings
+	float getMaxDistance();
+	float getReuseTolerance();
+	void setMaxDistance(float maxDistance);
+	void setReuseTolerance(float tolerance);
+
+private:
+
+	// Cell coordinates of point
+	int32_t getBucket(int32_t x, int32_t y);
+	int32_t toCell(float value);
+
+	// Rebuilds hash from last frame's triangles
+	void hash();
+
+	// Moves last frame's triangles to new outline, if it's close
+	bool reuse(const std::vector<ci::Vec2f> & points);
+
+	// Last frame's triangles, hashed by centroid
+	std::vector<std::vector<int32_t> > mBuckets;
+	int32_t mBucketMask;
+	std::vector<bool> mClaimed;
+	std::vector<Triangle> mTriangles;
+
+	// Outline as last triangulated and the points each triangle 
+	// was made from, or -1 for points added where it crosses itself
+	std::vector<int32_t> mCorners;
+	std::vector<ci::Vec2f> mPoints;
+
+	// Settings
+	float mMaxDistance;
+	int32_t mNextId;
+	float mReuseTolerance;
+
+};
@@ -39,6 +39,8 @@
 // Includes
 #include <cinder/Cinder.h>
 #include <cinder/Shape2d.h>
+#include <cinder/Thread.h>
+#include <cinder/TriMesh.h>
 #include <cinder/Vector.h>
 #include <lib/del_interface.hpp>
 #include <vector>
@@ -69,7 +71,126 @@ class ciTri
 
 public:
 
-	// Triangulate a shape
+	// Rules for filling overlapping outlines, by how many times 
+	// they wind around a point. Counterclockwise outlines count 
+	// up and clockwise ones count down.
+	enum Winding
+	{
+		WINDING_ODD, 
+		WINDING_NONZERO, 
+		WINDING_POSITIVE, 
+		WINDING_NEGATIVE, 
+		WINDING_ABS_GEQ_TWO
+	};
+
+	// Targets for quality meshing. Angles are in degrees, and 
+	// angles above about 33 may not finish without a limit on 
+	// added points. Zero area and a negative limit are off.
+	struct Quality
+	{
+		Quality(float minAngle = 20.0f, float maxArea = 0.0f, int32_t maxSteinerPoints = -1)
+			: maxArea(maxArea), maxSteinerPoints(maxSteinerPoints), minAngle(minAngle) {}
+		float maxArea;
+		int32_t maxSteinerPoints;
+		float minAngle;
+	};
+
+	// Triangulate a shape, simplified to at most resolution points
 	static std::vector<Triangle> triangulate(const std::vector<ci::Vec2f> & points, float resolution = 50.0f);
 
+	// Simplify a closed outline before triangulating. Points are 
+	// kept in order of how far they stand out of the outline, 
+	// until none is further than tolerance from it or max count 
+	// is reached, so corners stay. A max count of zero is none.
+	static std::vector<ci::Vec2f> simplify(const std::vector<ci::Vec2f> & points, float tolerance, size_t maxCount = 0);
+
+	// Triangulate a shape at full resolution. The outline is kept 
+	// as constrained edges, so only triangles inside it are made 
+	// and no inside test is needed. Runs in about O(N log N).
+	static std::vector<Triangle> triangulateContour(const std::vector<ci::Vec2f> & points);
+
+	// Triangulate a shape at full resolution into shared vertices 
+	// and three indices per triangle, ready to draw in one call. 
+	// Per triangle areas and centroids are written in triangle 
+	// order when asked for. Output is cleared first.
+	static void triangulateContour(const std::vector<ci::Vec2f> & points, ci::TriMesh2d & mesh, std::vector<float> * areas = 0, std::vector<ci::Vec2f> * centroids = 0);
+	static void triangulateContour(const std::vector<ci::Vec2f> & points, std::vector<ci::Vec2f> & positions, std::vector<uint32_t> & indices, std::vector<float> * areas = 0, std::vector<ci::Vec2f> * centroids = 0);
+
+	// Triangulate outlines with holes and islands in one pass, 
+	// filling regions by winding rule. Shapes are subdivided 
+	// into outlines first.
+	static ci::TriMesh2d triangulateShape(const std::vector<std::vector<ci::Vec2f> > & contours, Winding winding = WINDING_ODD);
+	static ci::TriMesh2d triangulateShape(const ci::Shape2d & shape, Winding winding = WINDING_ODD, float approximationScale = 1.0f);
+	static void triangulateShape(const std::vector<std::vector<ci::Vec2f> > & contours, std::vector<ci::Vec2f> & positions, std::vector<uint32_t> & indices, Winding winding = WINDING_ODD, std::vector<float> * areas = 0, std::vector<ci::Vec2f> * centroids = 0);
+
+	// Triangulate outlines as above, adding points inside until 
+	// triangles meet quality targets. Neighbors of each vertex 
+	// are written to one list, with vertex i's running from 
+	// offset i to offset i + 1, when asked for.
+	static void triangulateQuality(const std::vector<std::vector<ci::Vec2f> > & contours, const Quality & quality, std::vector<ci::Vec2f> & positions, std::vector<uint32_t> & indices, 
+		std::vector<uint32_t> * adjacencyOffsets = 0, std::vector<uint32_t> * adjacency = 0, Winding winding = WINDING_ODD);
+
+	// Triangulate many outlines or shapes across threads, each 
+	// into its own mesh in input order. Keep the mesh list from 
+	// frame to frame to reuse its memory. A thread count of zero 
+	// uses one per core.
+	static void triangulateBatch(const std::vector<std::vector<ci::Vec2f> > & contours, std::vector<ci::TriMesh2d> & meshes, int32_t threadCount = 0);
+	static void triangulateBatch(const std::vector<ci::Shape2d> & shapes, std::vector<ci::TriMesh2d> & meshes, Winding winding = WINDING_ODD, float approximationScale = 1.0f, int32_t threadCount = 0);
+
+private:
+
+	// Work shared by batch threads
+	struct Batch
+	{
+		float mApproximationScale;
+		const std::vector<std::vector<ci::Vec2f> > * mContours;
+		size_t mCount;
+		std::vector<ci::TriMesh2d> * mMeshes;
+		std::mutex mMutex;
+		size_t mNext;
+		const std::vector<ci::Shape2d> * mShapes;
+		Winding mWinding;
+	};
+
+	// Run of outline points between two kept ones, and the point 
+	// standing furthest out of it
+	struct Span
+	{
+		float mError;
+		size_t mFarthest;
+		size_t mFirst;
+		size_t mLast;
+		bool operator<(const Span & rhs) const { return mError < rhs.mError; }
+	};
+
+	// Finds the point between first and last standing furthest 
+	// out of the line between them. Last may be one past the end 
+	// of the outline, which closes it.
+	static Span findFarthest(const std::vector<ci::Vec2f> & points, size_t first, size_t last);
+
+	// Runs batch on threads, and takes items until none are left
+	static void runBatch(Batch & batch, int32_t threadCount);
+	static void workBatch(Batch * batch);
+
+	// Adds outline points and segments linking them, skipping 
+	// repeats and the closing point
+	static void addContour(const std::vector<ci::Vec2f> & points, std::vector<tpp::Delaunay::Point> & vertices, std::vector<int32_t> & segments);
+
+	// Triangulates outlines by winding rule, refining for 
+	// quality if targets are given
+	static void fillShape(const std::vector<std::vector<ci::Vec2f> > & contours, const Quality * quality, std::vector<ci::Vec2f> & positions, std::vector<uint32_t> & indices, 
+		Winding winding, std::vector<float> * areas, std::vector<ci::Vec2f> * centroids);
+
+	// Copies indexed triangles into mesh. TriMesh2d keeps its 
+	// own index type, so it's filled a triangle at a time.
+	static void appendMesh(const std::vector<ci::Vec2f> & positions, const std::vector<uint32_t> & indices, ci::TriMesh2d & mesh);
+
+	// Writes neighbors of each vertex from triangle indices
+	static void writeAdjacency(size_t vertexCount, const std::vector<uint32_t> & indices, std::vector<uint32_t> & offsets, std::vector<uint32_t> & adjacency);
+
+	// Writes triangles to indexed arrays, leaving out those not 
+	// filled, if a fill list is given, and unused vertices
+	static void writeMesh(const std::vector<tpp::Delaunay::Point> & vertices, const std::vector<int32_t> & corners, const std::vector<bool> & filled, 
+		std::vector<ci::Vec2f> & positions, std::vector<uint32_t> & indices, std::vector<float> * areas, std::vector<ci::Vec2f> * centroids);
+
 };
@@ -132,6 +132,7 @@ public:
 	typedef  reviver::dpoint <double, 2> Point; 
 	
 	std::vector< Point >  PList;/*! Stores the input point list. */
+	std::vector< int >    SList;/*! Stores segment end point index pairs. */
 	void *in;					/*! Used for intput to triangle  */
 	void *delclass;				/*! triangle is wrapped in this pointer. */
 	void *pmesh;				/*! pointer to triangle mesh */
@@ -151,6 +152,18 @@ public:
 		Triangulated = false;
 	}
 
+	//! Constructor for a planar straight line graph.
+    /*!
+      Takes points as above, plus segments as pairs of indices
+	  into them. Segments are kept as edges of the triangulation
+	  when triangulating with the 'p' switch.
+    */
+	Delaunay(std::vector< Point >& v, std::vector< int >& s){
+		PList.assign(v.begin(), v.end());
+		SList.assign(s.begin(), s.end());
+		Triangulated = false;
+	}
+
 	//! Delaunay Triangulate the input points
     /*!
       This function calls triangle to delaunay triangulate
@@ -158,6 +171,23 @@ public:
     */
 	void Triangulate() { std::string s = "vzQ"; Triangulate( s ); } ;
 
+	//! Constrained Delaunay triangulate the input points and segments
+    /*!
+      Segments are forced into the triangulation, and triangles
+	  outside the region they enclose are removed, so no inside
+	  test is needed afterwards.
+    */
+	void TriangulateConstrained() { std::string s = "pzQ"; Triangulate( s ); } ;
+
+	//! Constrained Delaunay triangulate, then refine for quality
+    /*!
+      Adds Steiner points until no angle is below minAngle degrees
+	  and no triangle is larger than maxArea, if it is positive.
+	  Angles above about 33 degrees may not finish, so a limit
+	  on added points can be given. A limit below zero is none.
+    */
+	void TriangulateQuality(double minAngle, double maxArea = 0.0, int maxSteinerPoints = -1);
+
 	//! Output a geomview .off file containing the delaunay triangulation
     /*!
       \param fname output file name.
@@ -242,6 +272,28 @@ public:
 	//! Given an index, return the actual double Point
 	const Point& point_at_vertex_id(int i) {return PList[i];};
 
+	//! Get every triangle with its neighbors and constrained edges.
+	/*!
+	  \param corners Returns three vertex ids per triangle, in
+	  counterclockwise order.
+	  \param neighbors Returns, for each triangle edge from
+	  corner k to corner k + 1, the index of the triangle across
+	  it, or -1 if there is none.
+	  \param segments Returns, for each triangle edge, the index
+	  of the input segment lying on it, or -1 if there is none.
+	  Remember to call Triangulate before using this function.
+	*/
+	void triangleList(std::vector< int >& corners, std::vector< int >& neighbors,
+		std::vector< int >& segments);
+
+	//! Get every vertex of the triangulation, indexed by vertex id.
+	/*!
+	  \param points Returns input points followed by any vertices
+	  Triangle added, such as where segments cross.
+	  Remember to call Triangulate before using this function.
+	*/
+	void vertexPoints(std::vector< Point >& points);
+
 
 	friend class vIterator; 
 
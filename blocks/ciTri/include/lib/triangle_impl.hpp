@@ -254,7 +254,8 @@
 /*   symbol.                                                                 */
 
 #define REDUCED
-#define CDT_ONLY
+/* CDT_ONLY is left undefined so quality meshing (-q, -a, -S) is available. */
+/* #define CDT_ONLY */
 
 /* On some machines, my exact arithmetic routines might be defeated by the   */
 /*   use of internal extended precision floating-point registers.  The best  */
@@ -3326,7 +3327,10 @@ struct behavior *b;
 #endif /* not TRILIBRARY */
   int i, j;
 
-  /* int k; char workstring[FILENAMESIZE]; */
+#ifndef CDT_ONLY
+  int k;
+  char workstring[FILENAMESIZE];
+#endif /* not CDT_ONLY */
 
   b->poly = b->refine = b->quality = 0;
   b->vararea = b->fixedarea = b->usertest = 0;
@@ -8452,11 +8456,9 @@ int triflaws;
       poolrestart(&m->flipstackers);
       m->lastflip = (struct flipstacker *) poolalloc(&m->flipstackers);
       m->lastflip->flippedtri = encode(horiz);
-      printf("Fatal Error: Contact piyush\n");
-      exit(1);
-      /* 
-      m->lastflip->prevflip = (struct flipstacker *) &insertvertex; 
-      */
+      /* Mark the split with the mesh's address, as a member */
+      /*   function's address can't stand in for a pointer.  */
+      m->lastflip->prevflip = (struct flipstacker *) m;
     }
 
 #ifdef SELF_CHECK
@@ -9143,7 +9145,7 @@ struct behavior *b;
       /* Delete the two spliced-out triangles. */
       triangledealloc(m, botleft.tri);
       triangledealloc(m, botright.tri);
-    } else if (m->lastflip->prevflip == (struct flipstacker *) &insertvertex) {
+    } else if (m->lastflip->prevflip == (struct flipstacker *) m) {
       /* Restore two triangles that were split into four triangles, */
       /*   so they are again two triangles.                         */
       lprev(fliptri, gluetri);
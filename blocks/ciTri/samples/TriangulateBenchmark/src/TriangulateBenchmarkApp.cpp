@@ -0,0 +1,179 @@
+// Includes
+#include "cinder/app/AppBasic.h"
+#include "cinder/CinderMath.h"
+#include "cinder/Timer.h"
+#include "cinder/Utilities.h"
+#include "ciTri.h"
+
+// Imports
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Times constrained triangulation of a closed outline against
+// triangulate(), run at full resolution so both keep every point
+class TriangulateBenchmarkApp : public AppBasic
+{
+
+public:
+
+	// Cinder callbacks
+	void draw();
+	void keyDown(KeyEvent event);
+	void setup();
+
+private:
+
+	// Largest outline the old path is timed on. It tests every 
+	// triangle against every point, so its cost grows with both.
+	static const int32_t kMaxOldPoints = 10000;
+
+	// Makes a closed wavy outline
+	vector<Vec2f> makeOutline(int32_t pointCount);
+
+	// Runs all benchmarks
+	void run();
+
+	// Benchmarks, each returning milliseconds per triangulation
+	double benchContour(const vector<Vec2f> & points, size_t & triangleCount);
+	double benchTriangulate(const vector<Vec2f> & points, size_t & triangleCount);
+
+	// Adds result line
+	void report(const string & name, double milliseconds, size_t triangleCount);
+
+	// Results
+	vector<string> mResults;
+
+};
+
+// Time triangulateContour(), best of a few runs
+double TriangulateBenchmarkApp::benchContour(const vector<Vec2f> & points, size_t & triangleCount)
+{
+
+	// DO IT!
+	double mBest = 0.0;
+	int32_t mRuns = points.size() > 10000 ? 1 : 5;
+	for (int32_t i = 0; i < mRuns; i++)
+	{
+		Timer mTimer(true);
+		triangleCount = ciTri::triangulateContour(points).size();
+		mTimer.stop();
+		if (i == 0 || mTimer.getSeconds() < mBest)
+			mBest = mTimer.getSeconds();
+	}
+	return mBest * 1000.0;
+
+}
+
+// Time triangulate() at full resolution, best of a few runs
+double TriangulateBenchmarkApp::benchTriangulate(const vector<Vec2f> & points, size_t & triangleCount)
+{
+
+	// DO IT!
+	double mBest = 0.0;
+	int32_t mRuns = points.size() > 1000 ? 1 : 5;
+	for (int32_t i = 0; i < mRuns; i++)
+	{
+		Timer mTimer(true);
+		triangleCount = ciTri::triangulate(points, (float)points.size()).size();
+		mTimer.stop();
+		if (i == 0 || mTimer.getSeconds() < mBest)
+			mBest = mTimer.getSeconds();
+	}
+	return mBest * 1000.0;
+
+}
+
+// Render
+void TriangulateBenchmarkApp::draw()
+{
+
+	// Clear screen
+	gl::clear(Color(0.0f, 0.0f, 0.0f));
+
+	// Draw results
+	for (size_t i = 0; i < mResults.size(); i++)
+		gl::drawString(mResults[i], Vec2f(20.0f, 20.0f + (float)i * 20.0f));
+
+}
+
+// Handles key press
+void TriangulateBenchmarkApp::keyDown(KeyEvent event)
+{
+
+	// Run again on space
+	if (event.getCode() == KeyEvent::KEY_SPACE)
+		run();
+
+}
+
+// Makes a closed wavy outline
+vector<Vec2f> TriangulateBenchmarkApp::makeOutline(int32_t pointCount)
+{
+
+	// Ripple a circle so most points shape the outline
+	vector<Vec2f> mPoints((size_t)pointCount);
+	for (int32_t i = 0; i < pointCount; i++)
+	{
+		float mAngle = (float)i / (float)pointCount * (float)M_PI * 2.0f;
+		float mRadius = 200.0f + 40.0f * math<float>::sin(mAngle * 12.0f) + 10.0f * math<float>::sin(mAngle * 97.0f);
+		mPoints[i] = Vec2f(math<float>::cos(mAngle), math<float>::sin(mAngle)) * mRadius;
+	}
+	return mPoints;
+
+}
+
+// Adds result line
+void TriangulateBenchmarkApp::report(const string & name, double milliseconds, size_t triangleCount)
+{
+
+	// Print and keep line
+	string mLine = name + ": " + toString(milliseconds) + "ms, " + toString(triangleCount) + " triangles";
+	console() << mLine << "\n";
+	mResults.push_back(mLine);
+
+}
+
+// Runs all benchmarks
+void TriangulateBenchmarkApp::run()
+{
+
+	// Time each size on both paths
+	mResults.clear();
+	int32_t mCounts[] = { 1000, 10000, 100000 };
+	for (int32_t i = 0; i < 3; i++)
+	{
+		vector<Vec2f> mPoints = makeOutline(mCounts[i]);
+		string mName = toString(mCounts[i]) + " points, ";
+		size_t mTriangleCount = 0;
+		double mMilliseconds = benchContour(mPoints, mTriangleCount);
+		report(mName + "triangulateContour", mMilliseconds, mTriangleCount);
+		if (mCounts[i] <= kMaxOldPoints)
+		{
+			mMilliseconds = benchTriangulate(mPoints, mTriangleCount);
+			report(mName + "triangulate", mMilliseconds, mTriangleCount);
+		}
+		else
+		{
+			mResults.push_back(mName + "triangulate: skipped, too slow");
+		}
+	}
+	mResults.push_back("Press space to run again");
+
+}
+
+// Set up
+void TriangulateBenchmarkApp::setup()
+{
+
+	// Set up window
+	setFrameRate(60);
+	setWindowSize(600, 200);
+
+	// DO IT!
+	run();
+
+}
+
+// Start application
+CINDER_APP_BASIC(TriangulateBenchmarkApp, RendererGl)
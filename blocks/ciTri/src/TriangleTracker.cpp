@@ -0,0 +1,246 @@
+/*
+* 
+* Copyright (c) 2011, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+// Include header
+#include <TriangleTracker.h>
+#include <algorithm>
+#include <map>
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Constructor
+TriangleTracker::TriangleTracker(float maxDistance)
+	: mBucketMask(0), mMaxDistance(math<float>::max(maxDistance, 0.001f)), mNextId(0), mReuseTolerance(0.0f)
+{
+}
+
+// Destructor
+TriangleTracker::~TriangleTracker()
+{
+	reset();
+}
+
+// Get bucket for cell
+int32_t TriangleTracker::getBucket(int32_t x, int32_t y)
+{
+	return (int32_t)(((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u)) & mBucketMask;
+}
+
+// Get settings
+float TriangleTracker::getMaxDistance()
+{
+	return mMaxDistance;
+}
+float TriangleTracker::getReuseTolerance()
+{
+	return mReuseTolerance;
+}
+
+// Forget last frame
+void TriangleTracker::reset()
+{
+	mBuckets.clear();
+	mClaimed.clear();
+	mCorners.clear();
+	mPoints.clear();
+	mTriangles.clear();
+}
+
+// Move last frame's triangles to new outline
+bool TriangleTracker::reuse(const vector<Vec2f> & points)
+{
+
+	// Bail if outline has changed shape or moved too far from 
+	// where it was last triangulated. Measuring from last frame 
+	// instead would let slow drift pile up unchecked.
+	if (mReuseTolerance <= 0.0f || mTriangles.empty() || points.size() != mPoints.size() || mCorners.size() != mTriangles.size() * 3)
+		return false;
+	float mTolerance = mReuseTolerance * mReuseTolerance;
+	for (size_t i = 0; i < points.size(); i++)
+		if (points[i].distanceSquared(mPoints[i]) > mTolerance)
+			return false;
+
+	// Move corners, bailing if any triangle would flip
+	vector<Triangle> mMoved(mTriangles);
+	for (size_t i = 0; i < mMoved.size(); i++)
+	{
+		Triangle & mTriangle = mMoved[i];
+		const Triangle & mLast = mTriangles[i];
+		Vec2f mA = points[mCorners[i * 3]];
+		Vec2f mB = points[mCorners[i * 3 + 1]];
+		Vec2f mC = points[mCorners[i * 3 + 2]];
+		float mCross = (mB - mA).cross(mC - mA);
+		if ((mCross > 0.0f) != ((mLast.b - mLast.a).cross(mLast.c - mLast.a) > 0.0f))
+			return false;
+		mTriangle.a = mA;
+		mTriangle.b = mB;
+		mTriangle.c = mC;
+		mTriangle.area = math<float>::abs(mCross) * 0.5f;
+		mTriangle.prevCentroid = mLast.centroid;
+		mTriangle.centroid = (mA + mB + mC) / 3.0f;
+	}
+
+	// Keep triangles for next frame
+	mTriangles.swap(mMoved);
+	hash();
+	return true;
+
+}
+
+// Set settings
+void TriangleTracker::setMaxDistance(float maxDistance)
+{
+	mMaxDistance = math<float>::max(maxDistance, 0.001f);
+}
+void TriangleTracker::setReuseTolerance(float tolerance)
+{
+	mReuseTolerance = tolerance;
+}
+
+// Get cell for coordinate
+int32_t TriangleTracker::toCell(float value)
+{
+	return (int32_t)math<float>::floor(value / mMaxDistance);
+}
+
+// Match triangles to last frame's
+void TriangleTracker::track(vector<Triangle> & triangles)
+{
+
+	// Claim the nearest unclaimed triangle within range, 
+	// looking in the cells around each centroid
+	float mRange = mMaxDistance * mMaxDistance;
+	mClaimed.assign(mTriangles.size(), false);
+	for (vector<Triangle>::iterator mTriangle = triangles.begin(); mTriangle != triangles.end(); ++mTriangle)
+	{
+		int32_t mMatch = -1;
+		if (!mBuckets.empty())
+		{
+			float mDistance = mRange;
+			int32_t mX = toCell(mTriangle->centroid.x);
+			int32_t mY = toCell(mTriangle->centroid.y);
+			for (int32_t y = mY - 1; y <= mY + 1; y++)
+				for (int32_t x = mX - 1; x <= mX + 1; x++)
+				{
+					const vector<int32_t> & mBucket = mBuckets[getBucket(x, y)];
+					for (vector<int32_t>::const_iterator mIndex = mBucket.begin(); mIndex != mBucket.end(); ++mIndex)
+					{
+						float mCandidate = mTriangle->centroid.distanceSquared(mTriangles[* mIndex].centroid);
+						if (!mClaimed[* mIndex] && mCandidate <= mDistance)
+						{
+							mDistance = mCandidate;
+							mMatch = * mIndex;
+						}
+					}
+				}
+		}
+
+		// Take id and position from match, or start fresh
+		if (mMatch >= 0)
+		{
+			mClaimed[mMatch] = true;
+			mTriangle->id = mTriangles[mMatch].id;
+			mTriangle->prevCentroid = mTriangles[mMatch].centroid;
+		}
+		else
+		{
+			mTriangle->id = mNextId++;
+			mTriangle->prevCentroid = mTriangle->centroid;
+		}
+	}
+
+	// Keep these triangles for next frame
+	mTriangles = triangles;
+	hash();
+
+}
+
+// Hash triangles by centroid
+void TriangleTracker::hash()
+{
+
+	// Use about two buckets per triangle
+	int32_t mCount = 1;
+	while (mCount < (int32_t)mTriangles.size() * 2)
+		mCount <<= 1;
+	mBucketMask = mCount - 1;
+	mBuckets.resize((size_t)mCount);
+	for (vector<vector<int32_t> >::iterator mBucket = mBuckets.begin(); mBucket != mBuckets.end(); ++mBucket)
+		mBucket->clear();
+	for (int32_t i = 0; i < (int32_t)mTriangles.size(); i++)
+		mBuckets[getBucket(toCell(mTriangles[i].centroid.x), toCell(mTriangles[i].centroid.y))].push_back(i);
+
+}
+
+// Triangulate and track outline
+const vector<Triangle> & TriangleTracker::update(const vector<Vec2f> & points)
+{
+
+	// Move last frame's triangles if outline has barely changed
+	if (reuse(points))
+		return mTriangles;
+
+	// Triangulate
+	vector<Triangle> mNew = ciTri::triangulateContour(points);
+
+	// Note which outline point each corner came from, 
+	// so the triangles can be moved next frame
+	map<pair<float, float>, int32_t> mIndices;
+	for (int32_t i = (int32_t)points.size() - 1; i >= 0; i--)
+		mIndices[make_pair(points[i].x, points[i].y)] = i;
+	mCorners.resize(mNew.size() * 3);
+	for (size_t i = 0; i < mNew.size(); i++)
+	{
+		const Vec2f * mCorner[3] = { &mNew[i].a, &mNew[i].b, &mNew[i].c };
+		for (size_t j = 0; j < 3; j++)
+		{
+			map<pair<float, float>, int32_t>::const_iterator mIndex = mIndices.find(make_pair(mCorner[j]->x, mCorner[j]->y));
+			mCorners[i * 3 + j] = mIndex == mIndices.end() ? -1 : mIndex->second;
+		}
+	}
+
+	// Only outlines that don't cross themselves can be moved
+	if (find(mCorners.begin(), mCorners.end(), -1) != mCorners.end())
+		mCorners.clear();
+	mPoints = points;
+
+	// Match to last frame
+	track(mNew);
+	return mTriangles;
+
+}
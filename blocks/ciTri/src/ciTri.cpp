@@ -36,12 +36,50 @@
 
 // Include header
 #include <ciTri.h>
+#include <algorithm>
+#include <limits>
+#include <queue>
 
 // Imports
 using namespace ci;
 using namespace tpp;
 using namespace std;
 
+// Add outline to point and segment lists
+void ciTri::addContour(const vector<Vec2f> & points, vector<Delaunay::Point> & vertices, vector<int32_t> & segments)
+{
+
+	// Convert list of points, skipping repeats and closing point
+	size_t mFirst = vertices.size();
+	Delaunay::Point mPoint;
+	for (vector<Vec2f>::const_iterator mPointIt = points.begin(); mPointIt != points.end(); ++mPointIt)
+	{
+		if (vertices.size() > mFirst && vertices.back()[0] == mPointIt->x && vertices.back()[1] == mPointIt->y)
+			continue;
+		mPoint[0] = mPointIt->x;
+		mPoint[1] = mPointIt->y;
+		vertices.push_back(mPoint);
+	}
+	if (vertices.size() > mFirst + 1 && vertices[mFirst] == vertices.back())
+		vertices.pop_back();
+
+	// Drop outlines with no area to fill
+	int32_t mCount = (int32_t)(vertices.size() - mFirst);
+	if (mCount < 3)
+	{
+		vertices.resize(mFirst);
+		return;
+	}
+
+	// Connect each point to the next
+	for (int32_t i = 0; i < mCount; i++)
+	{
+		segments.push_back((int32_t)mFirst + i);
+		segments.push_back((int32_t)mFirst + (i + 1) % mCount);
+	}
+
+}
+
 // Convert point list into delaunay triangles
 vector<Triangle> ciTri::triangulate(const vector<Vec2f> & points, float resolution)
 {
@@ -49,17 +87,19 @@ vector<Triangle> ciTri::triangulate(const vector<Vec2f> & points, float resoluti
 	// Initialize output list
     vector<Triangle> mTriangles;
 
+	// Keep the points which shape the outline most
+	vector<Vec2f> mPoints = simplify(points, 0.0f, (size_t)math<float>::max(resolution, 3.0f));
+	int32_t mSize = (int32_t)mPoints.size();
+	if (mSize < 3)
+		return mTriangles;
+
 	// Convert list of points
-	vector<Vec2f> mPoints = points;
-    float mSize = (float)mPoints.size();
-    float mCount = math<float>::min(resolution, mSize);
     Delaunay::Point mPoint;
     vector<Delaunay::Point> mVertices;
-    for (int32_t i = 0; i< mCount; i++)
+    for (int32_t i = 0; i < mSize; i++)
     {
-        int32_t mId = (int32_t)((float)i / mCount * mSize);
-		mPoint[0] = mPoints[mId].x;
-        mPoint[1] = mPoints[mId].y;
+		mPoint[0] = mPoints[i].x;
+        mPoint[1] = mPoints[i].y;
         mVertices.push_back(mPoint);
     }
 
@@ -75,15 +115,12 @@ vector<Triangle> ciTri::triangulate(const vector<Vec2f> & points, float resoluti
         int32_t mA = mDelaunay.Org(mTriIt);
         int32_t mB = mDelaunay.Dest(mTriIt);
         int32_t mC = mDelaunay.Apex(mTriIt);
-        int32_t mAId = (int32_t)(((float)mA / resolution) * mSize);
-        int32_t mBId = (int32_t)(((float)mB / resolution) * mSize);
-        int32_t mCId = (int32_t)(((float)mC / resolution) * mSize);
 
 		// Set positions in triangles
         Vec2f mTriangle[3];
-        mTriangle[0] = Vec2f(mPoints[mAId].x, mPoints[mAId].y);
-        mTriangle[1] = Vec2f(mPoints[mBId].x, mPoints[mBId].y);
-        mTriangle[2] = Vec2f(mPoints[mCId].x, mPoints[mCId].y);
+        mTriangle[0] = mPoints[mA];
+        mTriangle[1] = mPoints[mB];
+        mTriangle[2] = mPoints[mC];
 
 		// Find center of triangle
 		Vec2f mCentroid = Vec2f(
@@ -93,11 +130,11 @@ vector<Triangle> ciTri::triangulate(const vector<Vec2f> & points, float resoluti
 
 		// Initialize properties to test triangle position
 		int32_t mCounter = 0;
-		Vec2f mPointA = mPoints[0];
+		Vec2f mPointA = mPoints[mSize - 1];
 		Vec2f mPointB;
 
 		// Iterate through points
-		for (int32_t i = 1; i < (int32_t)mSize; i++)
+		for (int32_t i = 0; i < mSize; i++)
 		{
 
 			// Get test point
@@ -139,3 +176,563 @@ vector<Triangle> ciTri::triangulate(const vector<Vec2f> & points, float resoluti
 	return mTriangles;
 
 }
+
+// Simplify outline
+vector<Vec2f> ciTri::simplify(const vector<Vec2f> & points, float tolerance, size_t maxCount)
+{
+
+	// Copy outline without closing point
+	vector<Vec2f> mPoints(points);
+	if (mPoints.size() > 1 && mPoints.front() == mPoints.back())
+		mPoints.pop_back();
+	size_t mSize = mPoints.size();
+	if (mSize <= 3)
+		return mPoints;
+
+	// Split the outline at its first point and the point furthest 
+	// from it, which are both on its hull
+	size_t mFar = 0;
+	float mFarDistance = -1.0f;
+	for (size_t i = 1; i < mSize; i++)
+	{
+		float mDistance = mPoints[i].distanceSquared(mPoints[0]);
+		if (mDistance > mFarDistance)
+		{
+			mFar = i;
+			mFarDistance = mDistance;
+		}
+	}
+	vector<bool> mKeep(mSize, false);
+	mKeep[0] = true;
+	mKeep[mFar] = true;
+	size_t mKept = 2;
+
+	// Keep the point standing furthest out of any span, then split 
+	// that span in two, until every point is close enough
+	float mTolerance = tolerance * tolerance;
+	priority_queue<Span> mSpans;
+	mSpans.push(findFarthest(mPoints, 0, mFar));
+	mSpans.push(findFarthest(mPoints, mFar, mSize));
+	while (!mSpans.empty() && (maxCount == 0 || mKept < maxCount))
+	{
+		Span mSpan = mSpans.top();
+		if (mSpan.mError <= mTolerance)
+			break;
+		mSpans.pop();
+		mKeep[mSpan.mFarthest] = true;
+		mKept++;
+		mSpans.push(findFarthest(mPoints, mSpan.mFirst, mSpan.mFarthest));
+		mSpans.push(findFarthest(mPoints, mSpan.mFarthest, mSpan.mLast));
+	}
+
+	// Return kept points in order
+	vector<Vec2f> mSimplified;
+	mSimplified.reserve(mKept);
+	for (size_t i = 0; i < mSize; i++)
+		if (mKeep[i])
+			mSimplified.push_back(mPoints[i]);
+	return mSimplified;
+
+}
+
+// Find point furthest out of span
+ciTri::Span ciTri::findFarthest(const vector<Vec2f> & points, size_t first, size_t last)
+{
+
+	// Initialize span with no points in it
+	Span mSpan;
+	mSpan.mError = -1.0f;
+	mSpan.mFarthest = first;
+	mSpan.mFirst = first;
+	mSpan.mLast = last;
+	if (last <= first + 1)
+		return mSpan;
+
+	// Distance to the line is the cross product over its length. 
+	// Find the largest in a loop with no branches, so the compiler 
+	// can vectorize it, then find which point it was.
+	const Vec2f & mA = points[first];
+	const Vec2f & mB = points[last % points.size()];
+	Vec2f mDelta = mB - mA;
+	float mLength = mDelta.lengthSquared();
+	float mMax = 0.0f;
+	mSpan.mFarthest = first + 1;
+	if (mLength > 0.0f)
+	{
+		for (size_t i = first + 1; i < last; i++)
+		{
+			float mCross = (points[i].x - mA.x) * mDelta.y - (points[i].y - mA.y) * mDelta.x;
+			mMax = math<float>::max(mMax, mCross * mCross);
+		}
+		for (size_t i = first + 1; i < last; i++)
+		{
+			float mCross = (points[i].x - mA.x) * mDelta.y - (points[i].y - mA.y) * mDelta.x;
+			if (mCross * mCross >= mMax)
+			{
+				mSpan.mFarthest = i;
+				break;
+			}
+		}
+		mSpan.mError = mMax / mLength;
+	}
+	else
+	{
+
+		// Span ends meet, so use distance to that point
+		for (size_t i = first + 1; i < last; i++)
+		{
+			float mDistance = points[i].distanceSquared(mA);
+			if (mDistance > mMax)
+			{
+				mMax = mDistance;
+				mSpan.mFarthest = i;
+			}
+		}
+		mSpan.mError = mMax;
+
+	}
+
+	// Return span
+	return mSpan;
+
+}
+
+// Convert outline into constrained delaunay triangles
+vector<Triangle> ciTri::triangulateContour(const vector<Vec2f> & points)
+{
+
+	// Triangulate into shared vertices
+	vector<Vec2f> mPositions;
+	vector<uint32_t> mIndices;
+	vector<float> mAreas;
+	vector<Vec2f> mCentroids;
+	triangulateContour(points, mPositions, mIndices, &mAreas, &mCentroids);
+
+	// Copy out each triangle
+	vector<Triangle> mTriangles(mAreas.size());
+	for (size_t i = 0; i < mTriangles.size(); i++)
+	{
+		Triangle & mTriData = mTriangles[i];
+		mTriData.a = mPositions[mIndices[i * 3]];
+		mTriData.b = mPositions[mIndices[i * 3 + 1]];
+		mTriData.c = mPositions[mIndices[i * 3 + 2]];
+		mTriData.id = (int32_t)i;
+		mTriData.area = mAreas[i];
+		mTriData.centroid = mCentroids[i];
+		mTriData.prevCentroid = mCentroids[i];
+	}
+
+	// Return triangles
+	return mTriangles;
+
+}
+
+// Convert outline into mesh
+void ciTri::triangulateContour(const vector<Vec2f> & points, TriMesh2d & mesh, vector<float> * areas, vector<Vec2f> * centroids)
+{
+
+	// Triangulate, then copy into mesh
+	vector<Vec2f> mPositions;
+	vector<uint32_t> mIndices;
+	triangulateContour(points, mPositions, mIndices, areas, centroids);
+	mesh.clear();
+	appendMesh(mPositions, mIndices, mesh);
+
+}
+
+// Convert outline into indexed triangles
+void ciTri::triangulateContour(const vector<Vec2f> & points, vector<Vec2f> & positions, vector<uint32_t> & indices, vector<float> * areas, vector<Vec2f> * centroids)
+{
+
+	// Clear output
+	positions.clear();
+	indices.clear();
+	if (areas != 0)
+		areas->clear();
+	if (centroids != 0)
+		centroids->clear();
+
+	// Convert outline to points and segments
+	vector<Delaunay::Point> mVertices;
+	vector<int32_t> mSegments;
+	mVertices.reserve(points.size());
+	mSegments.reserve(points.size() * 2);
+	addContour(points, mVertices, mSegments);
+
+	// Bail if there's no area to fill
+	if (mVertices.empty())
+		return;
+
+	// Triangulate points and segments
+	Delaunay mDelaunay(mVertices, mSegments);
+	mDelaunay.TriangulateConstrained();
+
+	// Get positions, including points added where the outline crosses itself
+	mDelaunay.vertexPoints(mVertices);
+
+	// Every triangle left is inside the outline
+	vector<int32_t> mCorners;
+	mCorners.reserve(mDelaunay.ntriangles() * 3);
+	for (Delaunay::fIterator mTriIt = mDelaunay.fbegin(); mTriIt != mDelaunay.fend(); ++mTriIt)
+	{
+		mCorners.push_back(mDelaunay.Org(mTriIt));
+		mCorners.push_back(mDelaunay.Dest(mTriIt));
+		mCorners.push_back(mDelaunay.Apex(mTriIt));
+	}
+	writeMesh(mVertices, mCorners, vector<bool>(), positions, indices, areas, centroids);
+
+}
+
+// Convert shape outlines into mesh
+TriMesh2d ciTri::triangulateShape(const Shape2d & shape, Winding winding, float approximationScale)
+{
+
+	// Subdivide curves into outlines
+	vector<vector<Vec2f> > mContours;
+	const vector<Path2d> & mPaths = shape.getContours();
+	for (vector<Path2d>::const_iterator mPathIt = mPaths.begin(); mPathIt != mPaths.end(); ++mPathIt)
+		mContours.push_back(mPathIt->subdivide(approximationScale));
+
+	// DO IT!
+	return triangulateShape(mContours, winding);
+
+}
+
+// Convert outlines into mesh
+TriMesh2d ciTri::triangulateShape(const vector<vector<Vec2f> > & contours, Winding winding)
+{
+
+	// DO IT!
+	vector<Vec2f> mPositions;
+	vector<uint32_t> mIndices;
+	triangulateShape(contours, mPositions, mIndices, winding);
+	TriMesh2d mMesh;
+	appendMesh(mPositions, mIndices, mMesh);
+	return mMesh;
+
+}
+
+// Convert outlines into indexed triangles, filling by winding rule
+void ciTri::triangulateShape(const vector<vector<Vec2f> > & contours, vector<Vec2f> & positions, vector<uint32_t> & indices, Winding winding, vector<float> * areas, vector<Vec2f> * centroids)
+{
+
+	// DO IT!
+	fillShape(contours, 0, positions, indices, winding, areas, centroids);
+
+}
+
+// Triangulate shape with quality targets
+void ciTri::triangulateQuality(const vector<vector<Vec2f> > & contours, const Quality & quality, vector<Vec2f> & positions, vector<uint32_t> & indices, 
+	vector<uint32_t> * adjacencyOffsets, vector<uint32_t> * adjacency, Winding winding)
+{
+
+	// Triangulate
+	fillShape(contours, & quality, positions, indices, winding, 0, 0);
+
+	// Find neighbors
+	if (adjacencyOffsets != 0 && adjacency != 0)
+		writeAdjacency(positions.size(), indices, * adjacencyOffsets, * adjacency);
+
+}
+
+// Triangulate shape by winding rule
+void ciTri::fillShape(const vector<vector<Vec2f> > & contours, const Quality * quality, vector<Vec2f> & positions, vector<uint32_t> & indices, 
+	Winding winding, vector<float> * areas, vector<Vec2f> * centroids)
+{
+
+	// Clear output
+	positions.clear();
+	indices.clear();
+	if (areas != 0)
+		areas->clear();
+	if (centroids != 0)
+		centroids->clear();
+
+	// Convert all outlines to points and segments
+	vector<Delaunay::Point> mVertices;
+	vector<int32_t> mSegments;
+	for (vector<vector<Vec2f> >::const_iterator mContourIt = contours.begin(); mContourIt != contours.end(); ++mContourIt)
+		addContour(* mContourIt, mVertices, mSegments);
+	if (mVertices.empty())
+		return;
+
+	// Triangulate everything inside the outermost outlines at once. 
+	// Points added for quality split segments, so they keep their 
+	// segment and don't change winding numbers.
+	Delaunay mDelaunay(mVertices, mSegments);
+	if (quality == 0)
+		mDelaunay.TriangulateConstrained();
+	else
+		mDelaunay.TriangulateQuality(quality->minAngle, quality->maxArea, quality->maxSteinerPoints);
+	vector<Delaunay::Point> mSegmentPoints(mVertices);
+	mDelaunay.vertexPoints(mVertices);
+	vector<int32_t> mCorners;
+	vector<int32_t> mNeighbors;
+	vector<int32_t> mEdgeSegments;
+	mDelaunay.triangleList(mCorners, mNeighbors, mEdgeSegments);
+	int32_t mCount = (int32_t)mCorners.size() / 3;
+
+	// Find how crossing each triangle edge outward changes the 
+	// winding number. Triangles sit left of their edges, so an 
+	// outline running the same way winds one more around them.
+	vector<int32_t> mSteps(mCorners.size(), 0);
+	for (size_t i = 0; i < mCorners.size(); i++)
+	{
+		int32_t mSegment = mEdgeSegments[i];
+		if (mSegment < 0)
+			continue;
+		const Delaunay::Point & mFrom = mVertices[mCorners[i]];
+		const Delaunay::Point & mTo = mVertices[mCorners[i - i % 3 + (i + 1) % 3]];
+		const Delaunay::Point & mStart = mSegmentPoints[mSegments[mSegment * 2]];
+		const Delaunay::Point & mEnd = mSegmentPoints[mSegments[mSegment * 2 + 1]];
+		double mDot = (mTo[0] - mFrom[0]) * (mEnd[0] - mStart[0]) + (mTo[1] - mFrom[1]) * (mEnd[1] - mStart[1]);
+		mSteps[i] = mDot > 0.0 ? -1 : 1;
+	}
+
+	// Flood winding numbers in from the outside, which is zero
+	const int32_t kUnset = numeric_limits<int32_t>::min();
+	vector<int32_t> mWindings(mCount, kUnset);
+	vector<int32_t> mQueue;
+	mQueue.reserve(mCount);
+	for (int32_t i = 0; i < mCount; i++)
+		for (int32_t j = 0; j < 3; j++)
+			if (mWindings[i] == kUnset && mNeighbors[i * 3 + j] < 0)
+			{
+				mWindings[i] = -mSteps[i * 3 + j];
+				mQueue.push_back(i);
+			}
+	for (size_t i = 0; i < mQueue.size(); i++)
+	{
+		int32_t mTriangle = mQueue[i];
+		for (int32_t j = 0; j < 3; j++)
+		{
+			int32_t mNeighbor = mNeighbors[mTriangle * 3 + j];
+			if (mNeighbor >= 0 && mWindings[mNeighbor] == kUnset)
+			{
+				mWindings[mNeighbor] = mWindings[mTriangle] + mSteps[mTriangle * 3 + j];
+				mQueue.push_back(mNeighbor);
+			}
+		}
+	}
+
+	// Apply winding rule
+	vector<bool> mFilled(mCount, false);
+	for (int32_t i = 0; i < mCount; i++)
+	{
+		int32_t mWinding = mWindings[i] == kUnset ? 0 : mWindings[i];
+		switch (winding)
+		{
+		case WINDING_ODD:
+			mFilled[i] = mWinding % 2 != 0;
+			break;
+		case WINDING_NONZERO:
+			mFilled[i] = mWinding != 0;
+			break;
+		case WINDING_POSITIVE:
+			mFilled[i] = mWinding > 0;
+			break;
+		case WINDING_NEGATIVE:
+			mFilled[i] = mWinding < 0;
+			break;
+		case WINDING_ABS_GEQ_TWO:
+			mFilled[i] = math<int32_t>::abs(mWinding) >= 2;
+			break;
+		}
+	}
+
+	// DO IT!
+	writeMesh(mVertices, mCorners, mFilled, positions, indices, areas, centroids);
+
+}
+
+// Triangulate outlines across threads
+void ciTri::triangulateBatch(const vector<vector<Vec2f> > & contours, vector<TriMesh2d> & meshes, int32_t threadCount)
+{
+
+	// DO IT!
+	Batch mBatch;
+	mBatch.mContours = &contours;
+	mBatch.mCount = contours.size();
+	mBatch.mMeshes = &meshes;
+	mBatch.mShapes = 0;
+	runBatch(mBatch, threadCount);
+
+}
+
+// Triangulate shapes across threads
+void ciTri::triangulateBatch(const vector<Shape2d> & shapes, vector<TriMesh2d> & meshes, Winding winding, float approximationScale, int32_t threadCount)
+{
+
+	// DO IT!
+	Batch mBatch;
+	mBatch.mApproximationScale = approximationScale;
+	mBatch.mContours = 0;
+	mBatch.mCount = shapes.size();
+	mBatch.mMeshes = &meshes;
+	mBatch.mShapes = &shapes;
+	mBatch.mWinding = winding;
+	runBatch(mBatch, threadCount);
+
+}
+
+// Run batch on threads
+void ciTri::runBatch(Batch & batch, int32_t threadCount)
+{
+
+	// One mesh per item, keeping old ones for their memory
+	batch.mMeshes->resize(batch.mCount);
+	batch.mNext = 0;
+
+	// Start helper threads, working on this one too
+	if (threadCount <= 0)
+		threadCount = math<int32_t>::max((int32_t)thread::hardware_concurrency(), 1);
+	threadCount = math<int32_t>::min(threadCount, (int32_t)batch.mCount);
+	vector<std::shared_ptr<thread> > mThreads;
+	for (int32_t i = 1; i < threadCount; i++)
+		mThreads.push_back(std::shared_ptr<thread>(new thread(&ciTri::workBatch, &batch)));
+	workBatch(&batch);
+
+	// Wait for helpers
+	for (vector<std::shared_ptr<thread> >::iterator mThread = mThreads.begin(); mThread != mThreads.end(); ++mThread)
+		(* mThread)->join();
+
+}
+
+// Take batch items until none are left
+void ciTri::workBatch(Batch * batch)
+{
+
+	while (true)
+	{
+
+		// Take next item
+		size_t mIndex = 0;
+		{
+			lock_guard<mutex> mLock(batch->mMutex);
+			if (batch->mNext >= batch->mCount)
+				return;
+			mIndex = batch->mNext++;
+		}
+
+		// Triangulate into its mesh. Triangle keeps all its 
+		// state in the Delaunay object, so threads don't share any.
+		TriMesh2d & mMesh = (* batch->mMeshes)[mIndex];
+		if (batch->mContours != 0)
+		{
+			triangulateContour((* batch->mContours)[mIndex], mMesh);
+		}
+		else
+		{
+			vector<vector<Vec2f> > mContours;
+			const vector<Path2d> & mPaths = (* batch->mShapes)[mIndex].getContours();
+			for (vector<Path2d>::const_iterator mPathIt = mPaths.begin(); mPathIt != mPaths.end(); ++mPathIt)
+				mContours.push_back(mPathIt->subdivide(batch->mApproximationScale));
+			vector<Vec2f> mPositions;
+			vector<uint32_t> mIndices;
+			triangulateShape(mContours, mPositions, mIndices, batch->mWinding);
+			mMesh.clear();
+			appendMesh(mPositions, mIndices, mMesh);
+		}
+
+	}
+
+}
+
+// Copy indexed triangles into mesh
+void ciTri::appendMesh(const vector<Vec2f> & positions, const vector<uint32_t> & indices, TriMesh2d & mesh)
+{
+
+	// DO IT!
+	for (vector<Vec2f>::const_iterator mPosition = positions.begin(); mPosition != positions.end(); ++mPosition)
+		mesh.appendVertex(* mPosition);
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		mesh.appendTriangle(indices[i], indices[i + 1], indices[i + 2]);
+
+}
+
+// Write vertex neighbors
+void ciTri::writeAdjacency(size_t vertexCount, const vector<uint32_t> & indices, vector<uint32_t> & offsets, vector<uint32_t> & adjacency)
+{
+
+	// Each corner links to two others, so count those as slots
+	offsets.assign(vertexCount + 1, 0);
+	for (size_t i = 0; i < indices.size(); i++)
+		offsets[indices[i] + 1] += 2;
+	for (size_t i = 0; i < vertexCount; i++)
+		offsets[i + 1] += offsets[i];
+
+	// Fill slots with both other corners of each triangle
+	adjacency.resize(indices.size() * 2);
+	vector<uint32_t> mEnds(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		for (size_t j = 0; j < 3; j++)
+		{
+			uint32_t mVertex = indices[i + j];
+			adjacency[mEnds[mVertex]++] = indices[i + (j + 1) % 3];
+			adjacency[mEnds[mVertex]++] = indices[i + (j + 2) % 3];
+		}
+
+	// Edges are shared by triangles, so drop repeats and close 
+	// the gaps left in place
+	uint32_t mSize = 0;
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		vector<uint32_t>::iterator mBegin = adjacency.begin() + offsets[i];
+		vector<uint32_t>::iterator mEnd = adjacency.begin() + offsets[i + 1];
+		sort(mBegin, mEnd);
+		mEnd = unique(mBegin, mEnd);
+		offsets[i] = mSize;
+		mSize = (uint32_t)(copy(mBegin, mEnd, adjacency.begin() + mSize) - adjacency.begin());
+	}
+	offsets[vertexCount] = mSize;
+	adjacency.resize(mSize);
+
+}
+
+// Write triangles to indexed arrays
+void ciTri::writeMesh(const vector<Delaunay::Point> & vertices, const vector<int32_t> & corners, const vector<bool> & filled, 
+	vector<Vec2f> & positions, vector<uint32_t> & indices, vector<float> * areas, vector<Vec2f> * centroids)
+{
+
+	// Reserve for every triangle
+	size_t mCount = corners.size() / 3;
+	positions.reserve(vertices.size());
+	indices.reserve(corners.size());
+	if (areas != 0)
+		areas->reserve(mCount);
+	if (centroids != 0)
+		centroids->reserve(mCount);
+
+	// Add triangles, numbering vertices as they're first used
+	vector<int32_t> mIndices(vertices.size(), -1);
+	for (size_t i = 0; i < mCount; i++)
+	{
+
+		// Skip unfilled triangles
+		if (!filled.empty() && !filled[i])
+			continue;
+
+		// Add corners
+		for (size_t j = 0; j < 3; j++)
+		{
+			int32_t mCorner = corners[i * 3 + j];
+			if (mIndices[mCorner] < 0)
+			{
+				mIndices[mCorner] = (int32_t)positions.size();
+				positions.push_back(Vec2f((float)vertices[mCorner][0], (float)vertices[mCorner][1]));
+			}
+			indices.push_back((uint32_t)mIndices[mCorner]);
+		}
+
+		// Add properties
+		const Vec2f & mA = positions[indices[indices.size() - 3]];
+		const Vec2f & mB = positions[indices[indices.size() - 2]];
+		const Vec2f & mC = positions[indices[indices.size() - 1]];
+		if (areas != 0)
+			areas->push_back(math<float>::abs((mB.x - mA.x) * (mC.y - mA.y) - (mC.x - mA.x) * (mB.y - mA.y)) * 0.5f);
+		if (centroids != 0)
+			centroids->push_back((mA + mB + mC) / 3.0f);
+
+	}
+
+}
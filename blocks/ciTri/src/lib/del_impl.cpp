@@ -6,7 +6,9 @@
 #include <iostream>
 #include <lib/triangle_impl.hpp>
 #include <lib/del_interface.hpp>
+#include <algorithm>
 #include <new>
+#include <sstream>
 
 #define REAL double
 
@@ -32,7 +34,14 @@ void Delaunay::Triangulate(std::string & triswitches){
 	pin->pointlist = static_cast<double *> ((void *)(&PList[0])) ;
   	pin->pointattributelist = NULL;
   	pin->pointmarkerlist = (int *) NULL;
- 	pin->numberofsegments = 0;
+	/* Mark segments with their index, offset past Triangle's */
+	/*   own markers of zero and one.                          */
+	std::vector<int> SMarkers(SList.size() / 2);
+	for (size_t i = 0; i < SMarkers.size(); i++)
+		SMarkers[i] = (int)i + 2;
+	pin->segmentlist = SList.empty() ? (int *) NULL : &SList[0];
+	pin->segmentmarkerlist = SMarkers.empty() ? (int *) NULL : &SMarkers[0];
+ 	pin->numberofsegments = (int)SList.size() / 2;
   	pin->numberofholes = 0;
   	pin->numberofregions = 0;
   	pin->regionlist = (REAL *) NULL;
@@ -50,6 +59,7 @@ void Delaunay::Triangulate(std::string & triswitches){
 
 	pdelclass->triangleinit(tpmesh);
 	pdelclass->parsecommandline(1, &ptris, tpbehavior);
+	tpmesh->steinerleft = tpbehavior->steiner;
 
 	pdelclass->transfernodes(tpmesh, tpbehavior, pin->pointlist, 
 		pin->pointattributelist,
@@ -63,6 +73,24 @@ void Delaunay::Triangulate(std::string & triswitches){
   	tpmesh->infvertex2 = (piyush::vertex) NULL;
   	tpmesh->infvertex3 = (piyush::vertex) NULL;
 
+  /* Insert segments, then eat triangles outside them. */
+	if (tpbehavior->usesegments) {
+		tpmesh->checksegments = 1;
+		pdelclass->formskeleton(tpmesh, tpbehavior, pin->segmentlist,
+			pin->segmentmarkerlist, pin->numberofsegments);
+	}
+	tpmesh->holes = 0;
+	tpmesh->regions = 0;
+	if (tpbehavior->poly && (tpmesh->triangles.items > 0)) {
+		pdelclass->carveholes(tpmesh, tpbehavior, (REAL *) NULL, 0, 
+			(REAL *) NULL, 0);
+	}
+
+  /* Split bad triangles and encroached segments. */
+	if (tpbehavior->quality && (tpmesh->triangles.items > 0)) {
+		pdelclass->enforcequality(tpmesh, tpbehavior);
+	}
+
 	/* Calculate the number of edges. */
 	tpmesh->edges = (3l * tpmesh->triangles.items + tpmesh->hullsize) / 2l;
 	pdelclass->numbernodes(tpmesh, tpbehavior);
@@ -72,6 +100,20 @@ void Delaunay::Triangulate(std::string & triswitches){
 }
 
 
+void Delaunay::TriangulateQuality(double minAngle, double maxArea, int maxSteinerPoints){
+	/* Triangle reads plain decimals only, so no exponents. */
+	std::ostringstream switches;
+	switches.setf(std::ios::fixed);
+	switches.precision(12);
+	switches << "pzQq" << (minAngle > 0.0 ? minAngle : 0.0);
+	if (maxArea > 0.0)
+		switches << "a" << maxArea;
+	if (maxSteinerPoints >= 0)
+		switches << "S" << maxSteinerPoints;
+	std::string s = switches.str();
+	Triangulate(s);
+}
+
 Delaunay::~Delaunay(){
         struct triangulateio *pin = (struct triangulateio *)in;
 
@@ -132,6 +174,86 @@ int Delaunay::hull_size(){
 	return  tpmesh->hullsize;	
 }
 
+void Delaunay::triangleList(std::vector< int >& corners, std::vector< int >& neighbors,
+	std::vector< int >& segments){
+	typedef piyush::vertex      vertex;
+	typedef piyush::triangle    triangle;
+	typedef piyush::subseg      subseg;
+	typedef piyush::__otriangle trianglelooptype;
+	typedef piyush::osub        subseglooptype;
+
+	piyush::__pmesh     * tpmesh     = (piyush::__pmesh *)     pmesh;
+	piyush::__pbehavior * tpbehavior = (piyush::__pbehavior *) pbehavior;
+	piyush *pdelclass =  (piyush *)delclass;
+
+	/* Sort triangles by address, to number neighbors by lookup. */
+	std::vector<triangle *> tris;
+	tris.reserve(tpmesh->triangles.items);
+	pdelclass->traversalinit(&( tpmesh->triangles ));
+	triangle *triloop = pdelclass->triangletraverse(tpmesh);
+	while (triloop != (triangle *) NULL) {
+		tris.push_back(triloop);
+		triloop = pdelclass->triangletraverse(tpmesh);
+	}
+	std::vector<triangle *> sorted(tris);
+	std::sort(sorted.begin(), sorted.end());
+	std::vector<int> order(sorted.size());
+	for (size_t i = 0; i < tris.size(); i++)
+		order[std::lower_bound(sorted.begin(), sorted.end(), tris[i]) - sorted.begin()] = (int)i;
+
+	corners.resize(tris.size() * 3);
+	neighbors.resize(tris.size() * 3);
+	segments.resize(tris.size() * 3);
+	for (size_t i = 0; i < tris.size(); i++) {
+		trianglelooptype tri;
+		tri.tri = tris[i];
+		for (tri.orient = 0; tri.orient < 3; tri.orient++) {
+			triangle ptr;
+			subseg sptr;
+			vertex vertexptr;
+			trianglelooptype top;
+			subseglooptype sub;
+
+			/* Edge k runs from corner k to corner k + 1. */
+			size_t k = i * 3 + tri.orient;
+			org(tri, vertexptr);
+			corners[k] = ((int *)vertexptr)[tpmesh->vertexmarkindex] - tpbehavior->firstnumber;
+
+			sym(tri, top);
+			neighbors[k] = -1;
+			if (top.tri != tpmesh->dummytri)
+				neighbors[k] = order[std::lower_bound(sorted.begin(), sorted.end(), top.tri) - sorted.begin()];
+
+			segments[k] = -1;
+			if (tpbehavior->usesegments) {
+				tspivot(tri, sub);
+				if (sub.ss != tpmesh->dummysub && mark(sub) >= 2)
+					segments[k] = mark(sub) - 2;
+			}
+		}
+	}
+}
+
+void Delaunay::vertexPoints(std::vector< Point >& points){
+	typedef piyush::vertex vertex;
+
+	piyush::__pmesh     * tpmesh     = (piyush::__pmesh *)     pmesh;
+	piyush::__pbehavior * tpbehavior = (piyush::__pbehavior *) pbehavior;
+	piyush *pdelclass =  (piyush *)delclass;
+
+	points.resize(tpmesh->vertices.items);
+	pdelclass->traversalinit(&( tpmesh->vertices ));
+	vertex vertexloop = pdelclass->vertextraverse(tpmesh);
+	while (vertexloop != (vertex) NULL) {
+		int id = ((int *)vertexloop)[tpmesh->vertexmarkindex] - tpbehavior->firstnumber;
+		if (id >= 0 && id < (int)points.size()) {
+			points[id][0] = vertexloop[0];
+			points[id][1] = vertexloop[1];
+		}
+		vertexloop = pdelclass->vertextraverse(tpmesh);
+	}
+}
+
 int Delaunay::vertexId(vIterator const &vit){
  piyush::__pmesh     * tpmesh     = (piyush::__pmesh *) vit.MyDelaunay->pmesh;
  return ((int *)vit.vloop)[tpmesh->vertexmarkindex];
@@ -37,6 +37,7 @@
 #pragma once
 
 // Includes
+#include "AudioBuffer.h"
 #include "cinder/Cinder.h"
 #include "cinder/CinderMath.h"
 #include "kiss/kiss_fftr.h"
@@ -75,6 +76,7 @@ private:
 
 		// Setters
 		void setData(float * data);
+		void setData(const AudioBuffer & buffer, int32_t channel);
 		void setDataSize(int32_t dataSize);
 		void setFilter(float frequency, Filter filter);
 		void setFilter(float lowFrequency, float highFrequency);
@@ -96,6 +98,9 @@ private:
 		// Clean up
 		void dispose();
 
+		// Copies source buffer into data array
+		void readSource();
+
 		// Arrays
 		float * mAmplitude;
 		float * mData;
@@ -106,6 +111,11 @@ private:
 		float * mWindow;
 		float * mWindowedData;
 
+		// Buffer passed to setData, read in place until 
+		// time domain data is requested
+		AudioBuffer mSource;
+		int32_t mSourceChannel;
+
 		// Dimensions
 		int32_t mDataSize;
 		int32_t mBinSize;
@@ -155,6 +165,7 @@ public:
 	// Setters
 	void removeFilter() { mObj->setFilter(0.0f, Filter::NONE); }
 	void setData(float * data) { mObj->setData(data); }
+	void setData(const AudioBuffer & buffer, int32_t channel = 0) { mObj->setData(buffer, channel); }
 	void setDataSize(int32_t dataSize) { mObj->setDataSize(dataSize); }
 	void setFilter(float lowFrequency, float highFrequency) { mObj->setFilter(lowFrequency, highFrequency); }
 	void setFilter(float frequency, Filter filter = Filter::LOW_PASS) { mObj->setFilter(frequency, filter); }
@@ -44,6 +44,9 @@ Kiss::Obj::Obj(int32_t dataSize)
 	// Set running flag
 	mRunning = true;
 
+	// No source buffer
+	mSourceChannel = 0;
+
 	// Set data size
 	mDataSize = dataSize;
 	setDataSize(dataSize);
@@ -142,6 +145,10 @@ int32_t Kiss::Obj::getBinSize()
 float * Kiss::Obj::getData()
 {
 
+	// Copy source buffer, if we're still referencing one
+	if (mSource)
+		readSource();
+
 	// Data has not been updated
     if (!mDataUpdated)
     {
@@ -224,10 +231,30 @@ float * Kiss::Obj::getImaginary()
 
 }
 
+// Copy source buffer into data array
+void Kiss::Obj::readSource()
+{
+
+	// Copy channel, padding with silence if buffer is short
+	AudioBuffer::ChannelView mView = mSource.getChannel(mSourceChannel);
+	int32_t mCount = math<int32_t>::min(mView.size, mDataSize);
+	for (int32_t i = 0; i < mCount; i++)
+		mData[i] = mView[i];
+	for (int32_t i = mCount; i < mDataSize; i++)
+		mData[i] = 0.0f;
+
+	// Release buffer
+	mSource = AudioBuffer();
+
+}
+
 // Send signal to KISS
 void Kiss::Obj::setData(float * data)
 {
 
+	// Drop source buffer
+	mSource = AudioBuffer();
+
     // Set all flags to false
     mCartesianUpdated = false;
     mPolarUpdated = false;
@@ -245,6 +272,27 @@ void Kiss::Obj::setData(float * data)
 
 }
 
+// Send signal to KISS without copying it
+void Kiss::Obj::setData(const AudioBuffer & buffer, int32_t channel)
+{
+
+    // Set all flags to false
+    mCartesianUpdated = false;
+    mPolarUpdated = false;
+    mCartesianNormalized = false;
+    mPolarNormalized = false;
+
+	// Hold on to buffer. It's windowed in place by the 
+	// next transform and only copied if data is requested.
+	mSource = buffer;
+	mSourceChannel = channel;
+
+	// Set data flag
+    mDataUpdated = true;
+    mDataNormalized = true;
+
+}
+
 // Set data size
 void Kiss::Obj::setDataSize(int32_t dataSize)
 {
@@ -253,6 +301,9 @@ void Kiss::Obj::setDataSize(int32_t dataSize)
 	if (dataSize != mDataSize)
 		dispose();
 
+	// Drop source buffer
+	mSource = AudioBuffer();
+
 	// Set dimensions
     mDataSize = dataSize;
     mBinSize = (mDataSize / 2) + 1;
@@ -358,10 +409,24 @@ void Kiss::Obj::transform()
         if (!mPolarUpdated)
         {
 
-			// Copy data to windowed array
-            memcpy(mWindowedData, mData, sizeof(float) * mDataSize);
-            for (int32_t i = 0; i < mDataSize; i++)
-                mWindowedData[i] *= mWindow[i];
+			// Window source buffer in place, padding with silence if it's short
+			if (mSource)
+			{
+				AudioBuffer::ChannelView mView = mSource.getChannel(mSourceChannel);
+				int32_t mCount = math<int32_t>::min(mView.size, mDataSize);
+				for (int32_t i = 0; i < mCount; i++)
+					mWindowedData[i] = mView[i] * mWindow[i];
+				for (int32_t i = mCount; i < mDataSize; i++)
+					mWindowedData[i] = 0.0f;
+			}
+			else
+			{
+
+				// Window data array
+				for (int32_t i = 0; i < mDataSize; i++)
+					mWindowedData[i] = mData[i] * mWindow[i];
+
+			}
 
 			// Perform FFT
             kiss_fftr(mFftCfg, mWindowedData, mCxOut);
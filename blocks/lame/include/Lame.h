@@ -37,22 +37,64 @@
 #pragma once
 
 // Includes
+#include "AudioBuffer.h"
 #include "BladeMP3EncDLL.h"
 #include "cinder/app/App.h"
 #include "cinder/Thread.h"
+#include "cinder/Timer.h"
 #include "boost/filesystem.hpp"
+#include <deque>
 #include <iostream>
 #include <fstream>
+#include <vector>
 
 // Imports
 using namespace ci;
 using namespace ci::app;
 using namespace std;
 
-// Encodes WAV to MP3
+// Encodes WAV files or live audio buffers to MP3
 class Lame
 {
 
+public:
+
+	// Snapshot of an encoding job, safe to read from any thread
+	struct Status
+	{
+
+		Status() : bytesIn(0), bytesOut(0), bytesTotal(0), framesEncoded(0), buffersDropped(0), 
+			audioSeconds(0.0), wallSeconds(0.0), encoding(false), error(false) {}
+
+		// PCM bytes read, MP3 bytes written and PCM bytes in 
+		// source (or queued so far, when encoding buffers)
+		uint64_t bytesIn;
+		uint64_t bytesOut;
+		uint64_t bytesTotal;
+
+		// Chunks passed to the encoder (one MP3 frame each)
+		uint32_t framesEncoded;
+
+		// Live buffers turned away because the queue was full
+		uint32_t buffersDropped;
+
+		// Seconds of audio encoded and seconds spent encoding it
+		double audioSeconds;
+		double wallSeconds;
+
+		// Flags
+		bool encoding;
+		bool error;
+		string errorMessage;
+
+		// Fraction of PCM data encoded (0 - 1)
+		float getProgress() const { return bytesTotal > 0 ? (float)((double)bytesIn / (double)bytesTotal) : 0.0f; }
+
+		// Audio seconds encoded per wall second
+		double getRealtimeFactor() const { return wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0; }
+
+	};
+
 private:
 
 	// The object
@@ -90,21 +132,74 @@ private:
 
 		// Encode methods
 		void encode(const string & source, const string & destination, int32_t bitRate = 192);
+		bool start(const string & destination, int32_t sampleRate, int32_t channelCount, int32_t bitRate = 192);
+		void stop();
+		bool write(const AudioBuffer & buffer);
 		float getProgress();
+		int32_t getMaxQueueSize();
+		void setMaxQueueSize(int32_t maxQueueSize);
+		Status getStatus();
 		bool isEncoding();
 
 	private:
 
-		// Just the one sample rate for now
+		// Format assumed when a WAV header doesn't specify one
 		static const int32_t SAMPLE_RATE = 44100;
 
 		// File paths
 		string mSource;
 		string mDestination;
 
-		// Encoding flag
-		volatile bool mEncoding;
-		float mProgress;
+		// Encodes source to destination, returns false on error
+		bool run();
+
+		// Encodes queued buffers until stopped, returns false on error
+		bool runStream();
+
+		// Encoder thread for live buffers
+		void stream();
+
+		// Wraps up job after encoding
+		void finish(bool success);
+
+		// Releases stream, buffers and files
+		void release();
+
+		// Sets PCM format of current job, returns false if unsupported
+		bool setFormat(int32_t sampleRate, int32_t channelCount);
+
+		// Encoding stream helpers, return false on error
+		bool initStream();
+		bool encodeChunk(DWORD sampleCount);
+		bool deinitStream();
+
+		// Records error for status
+		void setError(const string & message);
+
+		// Job status, guarded by mutex
+		Status mStatus;
+		mutex mStatusMutex;
+		Timer mTimer;
+
+		// Open files and buffers for current job
+		FILE * mFileIn;
+		FILE * mFileOut;
+		vector<BYTE> mMp3Buffer;
+		vector<SHORT> mWavBuffer;
+
+		// PCM format of current job
+		int32_t mChannelCount;
+		int32_t mSampleRate;
+		double mBytesPerSecond;
+
+		// Live buffers waiting for encoder thread, guarded by mutex. 
+		// Capped so a slow encoder can't grow memory without bound.
+		deque<AudioBuffer> mQueue;
+		int32_t mMaxQueueSize;
+		mutex mQueueMutex;
+		condition_variable mQueueCondition;
+		bool mStopping;
+		bool mStreaming;
 
 		// LAME objects
 		HINSTANCE mBlade;
@@ -136,11 +231,25 @@ public:
 	Lame() { mObj = std::shared_ptr<Obj>(new Obj()); }
 	~Lame() { mObj.reset(); }
 
-	// Encode
+	// Encode WAV file
 	void encode(const string & source, const string & destination, int32_t bitRate = 192) { mObj->encode(source, destination, bitRate); }
 
+	// Encode live buffers. Buffers passed to write() are queued by 
+	// reference and converted on the encoder thread, so the caller 
+	// never blocks. If the encoder falls behind by more than the 
+	// max queue size, write() drops the buffer and returns false. 
+	// stop() encodes what's queued and closes the file.
+	bool start(const string & destination, int32_t sampleRate, int32_t channelCount, int32_t bitRate = 192) { return mObj->start(destination, sampleRate, channelCount, bitRate); }
+	void stop() { mObj->stop(); }
+	bool write(const AudioBuffer & buffer) { return mObj->write(buffer); }
+
+	// Buffers allowed in queue (default 256)
+	int32_t getMaxQueueSize() { return mObj->getMaxQueueSize(); }
+	void setMaxQueueSize(int32_t maxQueueSize) { mObj->setMaxQueueSize(maxQueueSize); }
+
 	// Getters
 	float getProgress() { return mObj->getProgress(); };
+	Status getStatus() { return mObj->getStatus(); }
 	bool isEncoding() { return mObj->isEncoding(); };
 
 };
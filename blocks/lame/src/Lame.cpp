@@ -41,9 +41,13 @@
 Lame::Obj::Obj()
 {
 
-	// Set encoding flag
-	mEncoding = false;
-	mProgress = 0.0f;
+	// Initialize job resources
+	mFileIn = NULL;
+	mFileOut = NULL;
+	mHbeStream = 0;
+	mMaxQueueSize = 256;
+	mStopping = false;
+	mStreaming = false;
 
 	// Load LAME DLL
 	mBlade = LoadLibraryA("lame_enc.dll");
@@ -94,6 +98,9 @@ Lame::Obj::Obj()
     mConfig.format.LHV1.bNoRes = TRUE;
     mConfig.format.LHV1.bCRC = TRUE;
 
+	// Default format
+	setFormat(SAMPLE_RATE, 2);
+
 }
 
 // Destructor
@@ -101,8 +108,196 @@ Lame::Obj::~Obj()
 {
 }
 
+// Release stream, buffers and files
+void Lame::Obj::release()
+{
+
+	// Close stream
+	if (mHbeStream != 0)
+	{
+		mBeCloseStream(mHbeStream);
+		mHbeStream = 0;
+	}
+
+	// Close files
+	if (mFileIn != NULL)
+	{
+		fclose(mFileIn);
+		mFileIn = NULL;
+	}
+	if (mFileOut != NULL)
+	{
+		fclose(mFileOut);
+		mFileOut = NULL;
+	}
+
+	// Free buffers
+	mMp3Buffer.clear();
+	mWavBuffer.clear();
+
+}
+
 // Thread callback
 void Lame::Obj::operator()()
+{
+
+	// DO IT!
+	finish(run());
+
+}
+
+// Uninitialize encoding stream
+bool Lame::Obj::deinitStream()
+{
+
+	// Flush encoder
+	DWORD mWrite = 0;
+	mError = mBeDeinitStream(mHbeStream, &mMp3Buffer[0], &mWrite);
+	if (mError != BE_ERR_SUCCESSFUL)
+	{
+		setError("Exit stream failed");
+		return false;
+	}
+
+	// Write any remaining bytes to disk
+	if (mWrite && fwrite(&mMp3Buffer[0], 1, mWrite, mFileOut) != mWrite)
+	{
+		setError("Unable to save MP3");
+		return false;
+	}
+
+	// Update status
+	lock_guard<mutex> mLock(mStatusMutex);
+	mStatus.bytesOut += mWrite;
+	return true;
+
+}
+
+// Encode start of WAV buffer
+bool Lame::Obj::encodeChunk(DWORD sampleCount)
+{
+
+	// Encode samples
+	DWORD mWrite = 0;
+	mError = mBeEncodeChunk(mHbeStream, sampleCount, &mWavBuffer[0], &mMp3Buffer[0], &mWrite);
+	if (mError != BE_ERR_SUCCESSFUL)
+	{
+		setError("Unable to encode file");
+		return false;
+	}
+
+	// Write mWrite bytes that are returned in the MP3 buffer to disk
+	if (fwrite(&mMp3Buffer[0], 1, mWrite, mFileOut) != mWrite)
+	{
+		setError("Unable to save MP3");
+		return false;
+	}
+
+	// Update status
+	lock_guard<mutex> mLock(mStatusMutex);
+	mStatus.bytesIn += sampleCount * sizeof(SHORT);
+	mStatus.bytesOut += mWrite;
+	mStatus.framesEncoded++;
+	mStatus.audioSeconds = (double)mStatus.bytesIn / mBytesPerSecond;
+	mStatus.wallSeconds = mTimer.getSeconds();
+	return true;
+
+}
+
+// Encode MP3
+void Lame::Obj::encode(const string & source, const string & destination, int32_t bitRate)
+{
+
+	// Check if file exists
+	if (!boost::filesystem::exists(boost::filesystem::path(source)))
+	{
+		console() << "Input file does not exist";
+		return;
+	}
+
+	// Check DLL
+	if (mBlade == NULL)
+	{
+		console() << "LAME not initialized";
+		return;
+	}
+
+	// Check encoding flag
+	lock_guard<mutex> mLock(mStatusMutex);
+	if (!mStatus.encoding)
+	{
+
+		// Record path for thread
+		mDestination = destination;
+		mSource = source;
+
+		// Set bit rate
+		mConfig.format.LHV1.dwBitrate = bitRate;
+
+		// Reset status
+		mStatus = Status();
+		mStatus.encoding = true;
+		mTimer.start();
+
+		// Run encoding in separate thread
+		thread(&Lame::Obj::operator(), this);
+
+	}
+
+}
+
+// Wrap up job
+void Lame::Obj::finish(bool success)
+{
+
+	// Release everything the job opened, 
+	// whether it succeeded or not
+	release();
+
+	// Write the VBR tag
+	if (success)
+		mBeWriteVBRHeader(mDestination.c_str());
+
+	// Encoding complete
+	mTimer.stop();
+	lock_guard<mutex> mLock(mStatusMutex);
+	mStatus.wallSeconds = mTimer.getSeconds();
+	mStatus.encoding = false;
+
+}
+
+// Return encode progress
+float Lame::Obj::getProgress()
+{
+
+	// DO IT!
+	lock_guard<mutex> mLock(mStatusMutex);
+	return mStatus.getProgress();
+
+}
+
+// Return queue limit
+int32_t Lame::Obj::getMaxQueueSize()
+{
+
+	// DO IT!
+	lock_guard<mutex> mLock(mQueueMutex);
+	return mMaxQueueSize;
+
+}
+
+// Return copy of job status
+Lame::Status Lame::Obj::getStatus()
+{
+
+	// DO IT!
+	lock_guard<mutex> mLock(mStatusMutex);
+	return mStatus;
+
+}
+
+// Initialize encoding stream and buffers
+bool Lame::Obj::initStream()
 {
 
 	// Reset some properties
@@ -115,159 +310,313 @@ void Lame::Obj::operator()()
 	DWORD mWavBufferSize = 0;
 	mError = mBeInitStream(&mConfig, &mWavBufferSize, &mMp3BufferSize, &mHbeStream);
 	if (mError != BE_ERR_SUCCESSFUL)
-    {
-        console() << "Error opening encoding stream\n";
-        return;
-    }
-
-	// Allocate MP3 and WAV buffers
-	PBYTE mMp3Buffer = NULL;
-	PSHORT mWavBuffer = NULL;
-    mMp3Buffer = new BYTE[mMp3BufferSize];
-	mWavBuffer = new SHORT[mWavBufferSize];
-	if (!mMp3Buffer || !mWavBuffer)
 	{
-        console() << "Out of memory:\n";
-        return;
+		mHbeStream = 0;
+		setError("Error opening encoding stream");
+		return false;
 	}
 
-	// Declare properties to keep track of encoding chunks
-	DWORD mComplete = 0;
-	DWORD mRead = 0;
-	DWORD mSize = 0;
-	DWORD mWrite = 0;
+	// Allocate MP3 and WAV buffers
+	mMp3Buffer.resize(mMp3BufferSize);
+	mWavBuffer.resize(mWavBufferSize);
+	return true;
+
+}
+
+// Return encoding flag
+bool Lame::Obj::isEncoding()
+{
+
+	// DO IT!
+	lock_guard<mutex> mLock(mStatusMutex);
+	return mStatus.encoding;
+
+}
+
+// Encode source to destination
+bool Lame::Obj::run()
+{
 
 	// Open files
-	FILE * mFileIn = NULL;
-	FILE * mFileOut = NULL;
 	mFileIn = fopen(mSource.c_str(), "rb");
-	mFileOut= fopen(mDestination.c_str(), "wb+");
+	mFileOut = fopen(mDestination.c_str(), "wb+");
 	if (mFileIn == NULL || mFileOut == NULL)
 	{
-        console() << "Unable to open file";
-        return;
+		setError("Unable to open file");
+		return false;
 	}
 
 	// Get file size
-    fseek(mFileIn, 0, SEEK_END);
-	mSize = ftell(mFileIn);
+	fseek(mFileIn, 0, SEEK_END);
+	uint64_t mSize = (uint64_t)ftell(mFileIn);
+	fseek(mFileIn, 0, SEEK_SET);
+
+	// Read header
+	WAVFILEHEADER mHeader;
+	memset(&mHeader, 0, sizeof(WAVFILEHEADER));
+	if (mSize < sizeof(WAVFILEHEADER) || fread(&mHeader, sizeof(WAVFILEHEADER), 1, mFileIn) != 1)
+	{
+		setError("Invalid WAV file");
+		return false;
+	}
 
-	// Seek past header to PCM data
-	fseek(mFileIn, sizeof(WAVFILEHEADER), SEEK_SET);
+	// Encode at the file's rate and channel count
+	if (!setFormat(mHeader.nSamplesPerSec > 0 ? (int32_t)mHeader.nSamplesPerSec : SAMPLE_RATE, mHeader.nChannels > 0 ? (int32_t)mHeader.nChannels : 2))
+	{
+		setError("Unsupported WAV format");
+		return false;
+	}
+
+	// Initialize encoding stream
+	if (!initStream())
+		return false;
+
+	// Measure progress against PCM data only, preferring the 
+	// length in the header so trailing chunks are not encoded
+	uint64_t mPcmSize = mSize - sizeof(WAVFILEHEADER);
+	if (mHeader.pcmbytes > 0 && mHeader.pcmbytes < mPcmSize)
+		mPcmSize = mHeader.pcmbytes;
+	{
+		lock_guard<mutex> mLock(mStatusMutex);
+		mStatus.bytesTotal = mPcmSize;
+	}
 
 	// Iterate through PCM data
-	while ((mRead = fread(mWavBuffer, sizeof(SHORT), mWavBufferSize, mFileIn)) > 0)
+	DWORD mRead = 0;
+	uint64_t mRemaining = mPcmSize;
+	while (mRemaining > 0 && (mRead = (DWORD)fread(&mWavBuffer[0], sizeof(SHORT), (size_t)math<uint64_t>::min(mWavBuffer.size(), mRemaining / sizeof(SHORT)), mFileIn)) > 0)
 	{
 
 		// Encode samples
-		mError = mBeEncodeChunk(mHbeStream, mRead, mWavBuffer, mMp3Buffer, &mWrite);
-		if (mError != BE_ERR_SUCCESSFUL)
-		{
-			console() << "Unable to encode file";
-			return;
-		}
-
-		// Write mWrite bytes that are returned in the pMP3Buffer to disk
-		if (fwrite(mMp3Buffer, 1, mWrite, mFileOut) != mWrite)
-		{
-			console() << "Unable to save MP3";
-			return;
-		}
-
-        // Update progress
-        mComplete += mRead * sizeof(SHORT);
-        mProgress = (float)mComplete / (float)(mSize);
+		if (!encodeChunk(mRead))
+			return false;
+		mRemaining -= mRead * sizeof(SHORT);
 
 	}
 
 	// Uninitialize the stream
-	mError = mBeDeinitStream(mHbeStream, mMp3Buffer, &mWrite);
-	if (mError != BE_ERR_SUCCESSFUL)
+	return deinitStream();
+
+}
+
+// Encode live buffers
+bool Lame::Obj::runStream()
+{
+
+	// Open file
+	mFileOut = fopen(mDestination.c_str(), "wb+");
+	if (mFileOut == NULL)
 	{
-		mBeCloseStream(mHbeStream);
-		console() << "Exit stream failed";
-		return;
+		setError("Unable to open file");
+		return false;
 	}
 
-	// Write any remaining bytes to disk
-	if (mWrite && fwrite(mMp3Buffer, 1, mWrite, mFileOut) != mWrite)
+	// Initialize encoding stream
+	if (!initStream())
+		return false;
+
+	// Iterate through buffers as they arrive
+	DWORD mPosition = 0;
+	DWORD mWavBufferSize = (DWORD)mWavBuffer.size();
+	vector<AudioBuffer::ChannelView> mChannels(mChannelCount);
+	while (true)
 	{
-		console() << "Unable to save MP3";
-		return;
+
+		// Wait for a buffer, bailing when stopped and drained
+		AudioBuffer mBuffer;
+		{
+			unique_lock<mutex> mLock(mQueueMutex);
+			while (mQueue.empty() && !mStopping)
+				mQueueCondition.wait(mLock);
+			if (mQueue.empty())
+				break;
+			mBuffer = mQueue.front();
+			mQueue.pop_front();
+		}
+
+		// Convert to interleaved 16-bit PCM, encoding 
+		// each time the WAV buffer fills up
+		for (int32_t c = 0; c < mChannelCount; c++)
+			mChannels[c] = mBuffer.getChannel(c);
+		int32_t mFrameCount = mBuffer.getFrameCount();
+		for (int32_t i = 0; i < mFrameCount; i++)
+		{
+			for (int32_t c = 0; c < mChannelCount; c++)
+				mWavBuffer[mPosition++] = (SHORT)(math<float>::clamp(mChannels[c][i], -1.0f, 1.0f) * 32767.0f);
+			if (mPosition == mWavBufferSize)
+			{
+				if (!encodeChunk(mPosition))
+					return false;
+				mPosition = 0;
+			}
+		}
+
 	}
 
-	// Clean up
-	mBeCloseStream(mHbeStream);
-	delete [] mWavBuffer;
-	delete [] mMp3Buffer;
-	fclose(mFileIn);
-	fclose(mFileOut);
+	// Encode what's left and uninitialize the stream
+	if (mPosition > 0 && !encodeChunk(mPosition))
+		return false;
+	return deinitStream();
 
-	// Write the VBR tag
-	mBeWriteVBRHeader(mDestination.c_str());
+}
 
-	// Encoding complete
-	mEncoding = false;
+// Set PCM format
+bool Lame::Obj::setFormat(int32_t sampleRate, int32_t channelCount)
+{
 
-	// Return to stop thread
-	return;
+	// LAME takes mono or stereo
+	if (sampleRate <= 0 || channelCount < 1 || channelCount > 2)
+		return false;
+
+	// Set properties
+	mChannelCount = channelCount;
+	mSampleRate = sampleRate;
+	mBytesPerSecond = (double)(mSampleRate * mChannelCount * sizeof(SHORT));
+
+	// Configure encoder. Rates below 32kHz are MPEG-2.
+	mConfig.format.LHV1.dwSampleRate = mSampleRate;
+	mConfig.format.LHV1.nMode = mChannelCount == 1 ? BE_MP3_MODE_MONO : BE_MP3_MODE_JSTEREO;
+	mConfig.format.LHV1.dwMpegVersion = mSampleRate >= 32000 ? MPEG1 : MPEG2;
+	return true;
 
 }
 
-// Encode MP3
-void Lame::Obj::encode(const string & source, const string & destination, int32_t bitRate)
+// Record error
+void Lame::Obj::setError(const string & message)
 {
 
-	// Record path for thread
-	mDestination = destination;
-	mSource = source;
+	// Report error
+	console() << message << "\n";
 
-	// Set bit rate
-	mConfig.format.LHV1.dwBitrate = bitRate;
+	// Flag job as failed
+	lock_guard<mutex> mLock(mStatusMutex);
+	mStatus.error = true;
+	mStatus.errorMessage = message;
 
-	// Check if file exists
-	if (!boost::filesystem::exists(boost::filesystem::path(source)))
-	{
-		console() << "Input file does not exist";
-		return;
-	}
+}
+
+// Start encoding live buffers
+bool Lame::Obj::start(const string & destination, int32_t sampleRate, int32_t channelCount, int32_t bitRate)
+{
 
 	// Check DLL
 	if (mBlade == NULL)
 	{
 		console() << "LAME not initialized";
-		return;
+		return false;
 	}
 
 	// Check encoding flag
-	if (!mEncoding)
+	lock_guard<mutex> mLock(mStatusMutex);
+	if (mStatus.encoding)
+		return false;
+
+	// Set format and bit rate
+	lock_guard<mutex> mQueueLock(mQueueMutex);
+	if (!setFormat(sampleRate, channelCount))
 	{
+		console() << "Unsupported format";
+		return false;
+	}
+	mConfig.format.LHV1.dwBitrate = bitRate;
 
-		// Set encoding flag
-		mEncoding = true;
-		mProgress = 0.0f;
+	// Record path for thread
+	mDestination = destination;
+	mSource.clear();
 
-		// Run encoding in separate thread
-		thread(&Lame::Obj::operator(), this);
+	// Reset queue and status
+	mQueue.clear();
+	mStopping = false;
+	mStreaming = true;
+	mStatus = Status();
+	mStatus.encoding = true;
+	mTimer.start();
 
-	}
+	// Run encoding in separate thread
+	thread(&Lame::Obj::stream, this);
+	return true;
 
 }
 
-// Return encode progress
-float Lame::Obj::getProgress()
+// Set queue limit
+void Lame::Obj::setMaxQueueSize(int32_t maxQueueSize)
 {
 
 	// DO IT!
-	return mProgress;
+	lock_guard<mutex> mLock(mQueueMutex);
+	mMaxQueueSize = math<int32_t>::max(maxQueueSize, 1);
 
 }
 
-// Return encoding flag
-bool Lame::Obj::isEncoding()
+// Stop encoding live buffers
+void Lame::Obj::stop()
 {
 
-	// DO IT!
-	return mEncoding;
+	// Flag thread to finish queued buffers and close
+	{
+		lock_guard<mutex> mLock(mQueueMutex);
+		mStopping = true;
+	}
+	mQueueCondition.notify_all();
+
+}
+
+// Live encoding thread
+void Lame::Obj::stream()
+{
+
+	// Encode until stopped
+	bool mSuccess = runStream();
+
+	// Stop accepting buffers and drop any left on error
+	{
+		lock_guard<mutex> mLock(mQueueMutex);
+		mStreaming = false;
+		mQueue.clear();
+	}
+
+	// Wrap up
+	finish(mSuccess);
+
+}
+
+// Queue buffer for live encoding
+bool Lame::Obj::write(const AudioBuffer & buffer)
+{
+
+	// Skip empty buffers
+	if (!buffer || buffer.getFrameCount() == 0)
+		return false;
+
+	// Queue a reference for the encoder thread, unless it's too 
+	// far behind
+	bool mFull = false;
+	{
+		lock_guard<mutex> mLock(mQueueMutex);
+		if (!mStreaming || mStopping)
+			return false;
+		if (buffer.getSampleRate() != mSampleRate || buffer.getChannelCount() != mChannelCount)
+		{
+			console() << "Buffer format does not match stream\n";
+			return false;
+		}
+		mFull = (int32_t)mQueue.size() >= mMaxQueueSize;
+		if (!mFull)
+			mQueue.push_back(buffer);
+	}
+
+	// Count dropped buffer
+	if (mFull)
+	{
+		lock_guard<mutex> mLock(mStatusMutex);
+		mStatus.buffersDropped++;
+		return false;
+	}
+	mQueueCondition.notify_one();
+
+	// Count queued audio toward progress
+	lock_guard<mutex> mLock(mStatusMutex);
+	mStatus.bytesTotal += (uint64_t)buffer.getSize() * sizeof(SHORT);
+	return true;
 
 }
@@ -0,0 +1,222 @@
+/*
+* 
+* Copyright (c) 2011, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/Cinder.h"
+#include "cinder/CinderMath.h"
+#include "cinder/Thread.h"
+#include <vector>
+
+// Use SSE where available
+#if !defined(METER_SSE) && (defined(_M_IX86) || defined(_M_X64) || defined(__SSE__))
+#define METER_SSE
+#endif
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Level and loudness meter for interleaved float audio
+class Meter
+{
+
+public:
+
+	// Meter values, published once per 100 ms block
+	struct Snapshot
+	{
+
+		Snapshot() : momentaryLoudness(MIN_DECIBELS), shortTermLoudness(MIN_DECIBELS), waveformSize(0), frameCount(0) {}
+
+		// Per channel peak and RMS over the level window (linear)
+		vector<float> peak;
+		vector<float> rms;
+
+		// Per channel K-weighted loudness over 400 ms (LUFS)
+		vector<float> loudness;
+
+		// Loudness of all channels over 400 ms and 3 s (LUFS)
+		float momentaryLoudness;
+		float shortTermLoudness;
+
+		// Min/max per bucket, one row of waveformSize buckets 
+		// per channel, oldest first
+		vector<float> waveformMin;
+		vector<float> waveformMax;
+		int32_t waveformSize;
+
+		// Frames metered since start
+		uint64_t frameCount;
+
+	};
+
+	// Floor for decibel values
+	static const int32_t MIN_DECIBELS = -100;
+
+	// Converts linear level to dBFS
+	static float toDecibels(float value) { return value > 0.0f ? math<float>::max(20.0f * math<float>::log10(value), (float)MIN_DECIBELS) : (float)MIN_DECIBELS; }
+
+private:
+
+	// Biquad filter state
+	struct Biquad
+	{
+		double b0, b1, b2, a1, a2;
+		double z1, z2;
+		inline double process(double value)
+		{
+			double mOut = b0 * value + z1;
+			z1 = b1 * value - a1 * mOut + z2;
+			z2 = b2 * value - a2 * mOut;
+			return mOut;
+		}
+	};
+
+	// Block totals for one channel
+	struct Accumulator
+	{
+		double sum;
+		double weightedSum;
+		float peak;
+	};
+
+	// The object
+	class Obj
+	{
+
+	public:
+
+		// Con/de-structor
+		Obj(int32_t sampleRate, int32_t channelCount, float windowSeconds, int32_t waveformSize, int32_t framesPerBucket);
+		~Obj();
+
+		// Meters interleaved samples
+		void process(const float * data, int32_t size);
+
+		// Clears windows and waveform
+		void reset();
+
+		// Getters
+		int32_t getChannelCount();
+		void getSnapshot(Snapshot & snapshot);
+
+	private:
+
+		// Accumulates a run of frames that doesn't cross a block or bucket
+		void accumulate(const float * data, int32_t frameCount);
+
+		// Closes current block and publishes snapshot
+		void endBlock();
+
+		// Closes current waveform bucket
+		void endBucket();
+
+		// Sets up K-weighting filters for sample rate
+		void createFilters();
+
+		// Format
+		int32_t mChannelCount;
+		int32_t mSampleRate;
+
+		// Blocks are 100 ms. Totals for the last BLOCK_COUNT 
+		// blocks are kept in a ring, one row per block.
+		static const int32_t BLOCK_COUNT = 30;
+		int32_t mBlockFrames;
+		int32_t mBlockPosition;
+		int32_t mBlockId;
+		int32_t mBlocksFilled;
+		int32_t mWindowBlocks;
+		vector<Accumulator> mBlocks;
+		vector<Accumulator> mCurrent;
+
+		// K-weighting, two stages per channel
+		vector<Biquad> mFilters;
+
+		// Min/max of current run and bucket, per channel
+		vector<float> mRunMin;
+		vector<float> mRunMax;
+		vector<float> mBucketMin;
+		vector<float> mBucketMax;
+
+		// Waveform ring, one row per channel
+		int32_t mBucketFrames;
+		int32_t mBucketPosition;
+		int32_t mBucketId;
+		int32_t mWaveformSize;
+		vector<float> mWaveformMin;
+		vector<float> mWaveformMax;
+
+		// Frames metered
+		uint64_t mFrameCount;
+
+		// Published values, guarded by mutex
+		Snapshot mSnapshot;
+		mutex mSnapshotMutex;
+
+	};
+
+	// Pointer to object
+	std::shared_ptr<Obj> mObj;
+
+public:
+
+	// Constructors
+	Meter() {}
+	Meter(int32_t sampleRate, int32_t channelCount, float windowSeconds = 0.3f, int32_t waveformSize = 512, int32_t framesPerBucket = 256) 
+		: mObj(std::shared_ptr<Obj>(new Obj(sampleRate, channelCount, windowSeconds, waveformSize, framesPerBucket))) {}
+	~Meter() { mObj.reset(); }
+
+	// Meters interleaved samples. Signature matches AudioInput 
+	// callbacks so a meter can be attached to input directly.
+	void process(float * data, int32_t size) { mObj->process(data, size); }
+	void process(const float * data, int32_t size) { mObj->process(data, size); }
+
+	// Clears windows and waveform
+	void reset() { mObj->reset(); }
+
+	// Getters
+	int32_t getChannelCount() { return mObj->getChannelCount(); }
+	Snapshot getSnapshot() 
+	{ 
+		Snapshot mSnapshot;
+		mObj->getSnapshot(mSnapshot);
+		return mSnapshot;
+	}
+	void getSnapshot(Snapshot & snapshot) { mObj->getSnapshot(snapshot); }
+
+};
@@ -0,0 +1,412 @@
+/*
+ * 
+ * Copyright (c) 2011, Ban the Rewind
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or 
+ * without modification, are permitted provided that the following 
+ * conditions are met:
+ * 
+ * Redistributions of source code must retain the above copyright 
+ * notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright 
+ * notice, this list of conditions and the following disclaimer in 
+ * the documentation and/or other materials provided with the 
+ * distribution.
+ * 
+ * Neither the name of the Ban the Rewind nor the names of its 
+ * contributors may be used to endorse or promote products 
+ * derived from this software without specific prior written 
+ * permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+
+// Include header
+#include "Meter.h"
+
+// Include SSE
+#ifdef METER_SSE
+#include <xmmintrin.h>
+#endif
+
+// Converts mean square to LUFS
+static float toLoudness(double meanSquare)
+{
+	return meanSquare > 0.0 ? math<float>::max((float)(-0.691 + 10.0 * log10(meanSquare)), (float)Meter::MIN_DECIBELS) : (float)Meter::MIN_DECIBELS;
+}
+
+// Constructor
+Meter::Obj::Obj(int32_t sampleRate, int32_t channelCount, float windowSeconds, int32_t waveformSize, int32_t framesPerBucket)
+{
+
+	// Set format
+	mChannelCount = math<int32_t>::max(channelCount, 1);
+	mSampleRate = math<int32_t>::max(sampleRate, 10);
+
+	// Set up 100 ms blocks
+	mBlockFrames = mSampleRate / 10;
+	mWindowBlocks = math<int32_t>::clamp((int32_t)(windowSeconds * 10.0f + 0.5f), 1, BLOCK_COUNT);
+
+	// Set up waveform
+	mBucketFrames = math<int32_t>::max(framesPerBucket, 1);
+	mWaveformSize = math<int32_t>::max(waveformSize, 1);
+
+	// Allocate everything up front so metering never allocates
+	mBlocks.resize(BLOCK_COUNT * mChannelCount);
+	mCurrent.resize(mChannelCount);
+	mFilters.resize(mChannelCount * 2);
+	mRunMin.resize(mChannelCount);
+	mRunMax.resize(mChannelCount);
+	mBucketMin.resize(mChannelCount);
+	mBucketMax.resize(mChannelCount);
+	mWaveformMin.resize(mChannelCount * mWaveformSize);
+	mWaveformMax.resize(mChannelCount * mWaveformSize);
+	mSnapshot.peak.resize(mChannelCount);
+	mSnapshot.rms.resize(mChannelCount);
+	mSnapshot.loudness.resize(mChannelCount);
+	mSnapshot.waveformMin.resize(mChannelCount * mWaveformSize);
+	mSnapshot.waveformMax.resize(mChannelCount * mWaveformSize);
+	mSnapshot.waveformSize = mWaveformSize;
+
+	// Initialize
+	createFilters();
+	reset();
+
+}
+
+// Destructor
+Meter::Obj::~Obj()
+{
+
+	// Clean up
+	mBlocks.clear();
+	mCurrent.clear();
+	mFilters.clear();
+	mWaveformMin.clear();
+	mWaveformMax.clear();
+
+}
+
+// Accumulate a run of frames
+void Meter::Obj::accumulate(const float * data, int32_t frameCount)
+{
+
+	// Reset run
+	for (int32_t mChannel = 0; mChannel < mChannelCount; mChannel++)
+	{
+		mRunMin[mChannel] = 0.0f;
+		mRunMax[mChannel] = 0.0f;
+	}
+
+	// Square, min and max of raw signal
+	int32_t i = 0;
+	int32_t mSampleCount = frameCount * mChannelCount;
+
+#ifdef METER_SSE
+
+	// When channel count divides four, each lane always 
+	// holds the same channel
+	if (mChannelCount == 1 || mChannelCount == 2 || mChannelCount == 4)
+	{
+
+		// Four samples at a time
+		__m128 mSum = _mm_setzero_ps();
+		__m128 mMin = _mm_setzero_ps();
+		__m128 mMax = _mm_setzero_ps();
+		for (; i + 4 <= mSampleCount; i += 4)
+		{
+			__m128 mValue = _mm_loadu_ps(data + i);
+			mSum = _mm_add_ps(mSum, _mm_mul_ps(mValue, mValue));
+			mMin = _mm_min_ps(mMin, mValue);
+			mMax = _mm_max_ps(mMax, mValue);
+		}
+
+		// Fold lanes into channels
+		float mLaneSum[4];
+		float mLaneMin[4];
+		float mLaneMax[4];
+		_mm_storeu_ps(mLaneSum, mSum);
+		_mm_storeu_ps(mLaneMin, mMin);
+		_mm_storeu_ps(mLaneMax, mMax);
+		for (int32_t mLane = 0; mLane < 4; mLane++)
+		{
+			int32_t mChannel = mLane % mChannelCount;
+			mCurrent[mChannel].sum += mLaneSum[mLane];
+			mRunMin[mChannel] = math<float>::min(mRunMin[mChannel], mLaneMin[mLane]);
+			mRunMax[mChannel] = math<float>::max(mRunMax[mChannel], mLaneMax[mLane]);
+		}
+
+	}
+
+#endif
+
+	// Remaining samples and other layouts
+	for (; i < mSampleCount; i++)
+	{
+		int32_t mChannel = i % mChannelCount;
+		float mValue = data[i];
+		mCurrent[mChannel].sum += mValue * mValue;
+		mRunMin[mChannel] = math<float>::min(mRunMin[mChannel], mValue);
+		mRunMax[mChannel] = math<float>::max(mRunMax[mChannel], mValue);
+	}
+
+	// Apply run to block and bucket
+	for (int32_t mChannel = 0; mChannel < mChannelCount; mChannel++)
+	{
+		mCurrent[mChannel].peak = math<float>::max(mCurrent[mChannel].peak, math<float>::max(mRunMax[mChannel], -mRunMin[mChannel]));
+		mBucketMin[mChannel] = math<float>::min(mBucketMin[mChannel], mRunMin[mChannel]);
+		mBucketMax[mChannel] = math<float>::max(mBucketMax[mChannel], mRunMax[mChannel]);
+	}
+
+	// K-weighted square (filters are recursive, so this runs per channel)
+	for (int32_t mChannel = 0; mChannel < mChannelCount; mChannel++)
+	{
+		Biquad & mShelf = mFilters[mChannel * 2];
+		Biquad & mHighPass = mFilters[mChannel * 2 + 1];
+		double mSum = 0.0;
+		for (int32_t j = mChannel; j < mSampleCount; j += mChannelCount)
+		{
+			double mValue = mHighPass.process(mShelf.process((double)data[j]));
+			mSum += mValue * mValue;
+		}
+		mCurrent[mChannel].weightedSum += mSum;
+	}
+
+}
+
+// Set up K-weighting filters (ITU-R BS.1770) for any sample rate
+void Meter::Obj::createFilters()
+{
+
+	// Stage one is a high shelf modelling the head
+	double mFrequency = 1681.974450955533;
+	double mGain = 3.999843853973347;
+	double mQ = 0.7071752369554196;
+	double mK = tan(M_PI * mFrequency / (double)mSampleRate);
+	double mVh = pow(10.0, mGain / 20.0);
+	double mVb = pow(mVh, 0.4996667741545416);
+	double mA0 = 1.0 + mK / mQ + mK * mK;
+	Biquad mShelf;
+	mShelf.b0 = (mVh + mVb * mK / mQ + mK * mK) / mA0;
+	mShelf.b1 = 2.0 * (mK * mK - mVh) / mA0;
+	mShelf.b2 = (mVh - mVb * mK / mQ + mK * mK) / mA0;
+	mShelf.a1 = 2.0 * (mK * mK - 1.0) / mA0;
+	mShelf.a2 = (1.0 - mK / mQ + mK * mK) / mA0;
+	mShelf.z1 = 0.0;
+	mShelf.z2 = 0.0;
+
+	// Stage two is the RLB high pass
+	mFrequency = 38.13547087602444;
+	mQ = 0.5003270373238773;
+	mK = tan(M_PI * mFrequency / (double)mSampleRate);
+	mA0 = 1.0 + mK / mQ + mK * mK;
+	Biquad mHighPass;
+	mHighPass.b0 = 1.0;
+	mHighPass.b1 = -2.0;
+	mHighPass.b2 = 1.0;
+	mHighPass.a1 = 2.0 * (mK * mK - 1.0) / mA0;
+	mHighPass.a2 = (1.0 - mK / mQ + mK * mK) / mA0;
+	mHighPass.z1 = 0.0;
+	mHighPass.z2 = 0.0;
+
+	// Apply to channels
+	for (int32_t mChannel = 0; mChannel < mChannelCount; mChannel++)
+	{
+		mFilters[mChannel * 2] = mShelf;
+		mFilters[mChannel * 2 + 1] = mHighPass;
+	}
+
+}
+
+// Close block and publish values
+void Meter::Obj::endBlock()
+{
+
+	// Store block in ring
+	for (int32_t mChannel = 0; mChannel < mChannelCount; mChannel++)
+	{
+		mBlocks[mBlockId * mChannelCount + mChannel] = mCurrent[mChannel];
+		mCurrent[mChannel].sum = 0.0;
+		mCurrent[mChannel].weightedSum = 0.0;
+		mCurrent[mChannel].peak = 0.0f;
+	}
+	mBlockId = (mBlockId + 1) % BLOCK_COUNT;
+	mBlocksFilled = math<int32_t>::min(mBlocksFilled + 1, BLOCK_COUNT);
+	mBlockPosition = 0;
+
+	// Window sizes in blocks
+	int32_t mLevelBlocks = math<int32_t>::min(mWindowBlocks, mBlocksFilled);
+	int32_t mMomentaryBlocks = math<int32_t>::min(4, mBlocksFilled);
+
+	// Update snapshot
+	lock_guard<mutex> mLock(mSnapshotMutex);
+	double mMomentary = 0.0;
+	double mShortTerm = 0.0;
+	for (int32_t mChannel = 0; mChannel < mChannelCount; mChannel++)
+	{
+
+		// Walk back from newest block
+		float mPeak = 0.0f;
+		double mSum = 0.0;
+		double mWeightedMomentary = 0.0;
+		double mWeightedShortTerm = 0.0;
+		for (int32_t i = 0; i < mBlocksFilled; i++)
+		{
+			const Accumulator & mBlock = mBlocks[((mBlockId - 1 - i + BLOCK_COUNT) % BLOCK_COUNT) * mChannelCount + mChannel];
+			if (i < mLevelBlocks)
+			{
+				mPeak = math<float>::max(mPeak, mBlock.peak);
+				mSum += mBlock.sum;
+			}
+			if (i < mMomentaryBlocks)
+				mWeightedMomentary += mBlock.weightedSum;
+			mWeightedShortTerm += mBlock.weightedSum;
+		}
+
+		// Convert totals to means
+		mWeightedMomentary /= (double)(mMomentaryBlocks * mBlockFrames);
+		mWeightedShortTerm /= (double)(mBlocksFilled * mBlockFrames);
+		mMomentary += mWeightedMomentary;
+		mShortTerm += mWeightedShortTerm;
+
+		// Per channel values
+		mSnapshot.peak[mChannel] = mPeak;
+		mSnapshot.rms[mChannel] = (float)sqrt(mSum / (double)(mLevelBlocks * mBlockFrames));
+		mSnapshot.loudness[mChannel] = toLoudness(mWeightedMomentary);
+
+	}
+
+	// Channels are summed with equal weight (front channels in BS.1770)
+	mSnapshot.momentaryLoudness = toLoudness(mMomentary);
+	mSnapshot.shortTermLoudness = toLoudness(mShortTerm);
+
+	// Copy waveform, oldest bucket first
+	for (int32_t mChannel = 0; mChannel < mChannelCount; mChannel++)
+	{
+		int32_t mRow = mChannel * mWaveformSize;
+		int32_t mHead = mWaveformSize - mBucketId;
+		copy(mWaveformMin.begin() + mRow + mBucketId, mWaveformMin.begin() + mRow + mWaveformSize, mSnapshot.waveformMin.begin() + mRow);
+		copy(mWaveformMin.begin() + mRow, mWaveformMin.begin() + mRow + mBucketId, mSnapshot.waveformMin.begin() + mRow + mHead);
+		copy(mWaveformMax.begin() + mRow + mBucketId, mWaveformMax.begin() + mRow + mWaveformSize, mSnapshot.waveformMax.begin() + mRow);
+		copy(mWaveformMax.begin() + mRow, mWaveformMax.begin() + mRow + mBucketId, mSnapshot.waveformMax.begin() + mRow + mHead);
+	}
+	mSnapshot.frameCount = mFrameCount;
+
+}
+
+// Close waveform bucket
+void Meter::Obj::endBucket()
+{
+
+	// Store bucket in ring
+	for (int32_t mChannel = 0; mChannel < mChannelCount; mChannel++)
+	{
+		mWaveformMin[mChannel * mWaveformSize + mBucketId] = mBucketMin[mChannel];
+		mWaveformMax[mChannel * mWaveformSize + mBucketId] = mBucketMax[mChannel];
+		mBucketMin[mChannel] = 0.0f;
+		mBucketMax[mChannel] = 0.0f;
+	}
+	mBucketId = (mBucketId + 1) % mWaveformSize;
+	mBucketPosition = 0;
+
+}
+
+// Returns channel count
+int32_t Meter::Obj::getChannelCount()
+{
+	return mChannelCount;
+}
+
+// Copy latest values
+void Meter::Obj::getSnapshot(Snapshot & snapshot)
+{
+
+	// DO IT!
+	lock_guard<mutex> mLock(mSnapshotMutex);
+	snapshot = mSnapshot;
+
+}
+
+// Meter interleaved samples
+void Meter::Obj::process(const float * data, int32_t size)
+{
+
+	// Bail if no data
+	if (data == 0 || size <= 0)
+		return;
+
+	// Split data into runs which end on block or bucket boundaries
+	int32_t mFrameTotal = size / mChannelCount;
+	int32_t mFrame = 0;
+	while (mFrame < mFrameTotal)
+	{
+
+		// Accumulate run
+		int32_t mRun = math<int32_t>::min(mFrameTotal - mFrame, math<int32_t>::min(mBlockFrames - mBlockPosition, mBucketFrames - mBucketPosition));
+		accumulate(data + mFrame * mChannelCount, mRun);
+		mFrame += mRun;
+		mFrameCount += mRun;
+		mBlockPosition += mRun;
+		mBucketPosition += mRun;
+
+		// Close bucket and block
+		if (mBucketPosition == mBucketFrames)
+			endBucket();
+		if (mBlockPosition == mBlockFrames)
+			endBlock();
+
+	}
+
+}
+
+// Clear windows and waveform
+void Meter::Obj::reset()
+{
+
+	// Clear totals
+	Accumulator mEmpty = { 0.0, 0.0, 0.0f };
+	fill(mBlocks.begin(), mBlocks.end(), mEmpty);
+	fill(mCurrent.begin(), mCurrent.end(), mEmpty);
+	fill(mBucketMin.begin(), mBucketMin.end(), 0.0f);
+	fill(mBucketMax.begin(), mBucketMax.end(), 0.0f);
+	fill(mWaveformMin.begin(), mWaveformMin.end(), 0.0f);
+	fill(mWaveformMax.begin(), mWaveformMax.end(), 0.0f);
+	for (vector<Biquad>::iterator mFilter = mFilters.begin(); mFilter != mFilters.end(); ++mFilter)
+	{
+		mFilter->z1 = 0.0;
+		mFilter->z2 = 0.0;
+	}
+
+	// Reset positions
+	mBlockId = 0;
+	mBlockPosition = 0;
+	mBlocksFilled = 0;
+	mBucketId = 0;
+	mBucketPosition = 0;
+	mFrameCount = 0;
+
+	// Clear snapshot
+	lock_guard<mutex> mLock(mSnapshotMutex);
+	fill(mSnapshot.peak.begin(), mSnapshot.peak.end(), 0.0f);
+	fill(mSnapshot.rms.begin(), mSnapshot.rms.end(), 0.0f);
+	fill(mSnapshot.loudness.begin(), mSnapshot.loudness.end(), (float)MIN_DECIBELS);
+	fill(mSnapshot.waveformMin.begin(), mSnapshot.waveformMin.end(), 0.0f);
+	fill(mSnapshot.waveformMax.begin(), mSnapshot.waveformMax.end(), 0.0f);
+	mSnapshot.momentaryLoudness = (float)MIN_DECIBELS;
+	mSnapshot.shortTermLoudness = (float)MIN_DECIBELS;
+	mSnapshot.frameCount = 0;
+
+}
@@ -0,0 +1,130 @@
+/*
+* 
+* Copyright (c) 2011, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/Cinder.h"
+#include "cinder/CinderMath.h"
+#include <vector>
+
+// Use SSE where available
+#if !defined(RESAMPLER_SSE) && (defined(_M_IX86) || defined(_M_X64) || defined(__SSE__))
+#define RESAMPLER_SSE
+#endif
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Mixes interleaved float audio from one channel layout to another
+class ChannelMixer
+{
+
+private:
+
+	// The object
+	class Obj
+	{
+
+	public:
+
+		// Con/de-structor
+		Obj(int32_t inputChannels, int32_t outputChannels, int32_t maxFrames);
+		~Obj();
+
+		// Mixes frames
+		void process(const float * input, int32_t frameCount);
+		void process(const float * input, int32_t frameCount, float * output);
+
+		// Gain matrix
+		float getGain(int32_t inputChannel, int32_t outputChannel);
+		void setGain(int32_t inputChannel, int32_t outputChannel, float gain);
+		void setDefaultGains();
+
+		// Getters
+		float * getData();
+		int32_t getDataSize();
+		int32_t getInputChannels();
+		int32_t getMaxFrames();
+		int32_t getOutputChannels();
+
+	private:
+
+		// Layout
+		int32_t mInputChannels;
+		int32_t mOutputChannels;
+
+		// Gains, one row of input gains per output channel
+		vector<float> mGains;
+
+		// Output buffer and sample count
+		vector<float> mData;
+		int32_t mDataSize;
+		int32_t mMaxFrames;
+
+	};
+
+	// Pointer to object
+	std::shared_ptr<Obj> mObj;
+
+public:
+
+	// Constructors
+	ChannelMixer() {}
+	ChannelMixer(int32_t inputChannels, int32_t outputChannels, int32_t maxFrames = 4096) 
+		: mObj(std::shared_ptr<Obj>(new Obj(inputChannels, outputChannels, maxFrames))) {}
+	~ChannelMixer() { mObj.reset(); }
+
+	// Mixes up to getMaxFrames() frames into getData()
+	void process(const float * input, int32_t frameCount) { mObj->process(input, frameCount); }
+
+	// Mixes frames into caller's buffer
+	void process(const float * input, int32_t frameCount, float * output) { mObj->process(input, frameCount, output); }
+
+	// Gain matrix (defaults to averaging down and copying up)
+	float getGain(int32_t inputChannel, int32_t outputChannel) { return mObj->getGain(inputChannel, outputChannel); }
+	void setGain(int32_t inputChannel, int32_t outputChannel, float gain) { mObj->setGain(inputChannel, outputChannel, gain); }
+	void setDefaultGains() { mObj->setDefaultGains(); }
+
+	// Getters
+	float * getData() { return mObj->getData(); }
+	int32_t getDataSize() { return mObj->getDataSize(); }
+	int32_t getInputChannels() { return mObj->getInputChannels(); }
+	int32_t getMaxFrames() { return mObj->getMaxFrames(); }
+	int32_t getOutputChannels() { return mObj->getOutputChannels(); }
+
+};
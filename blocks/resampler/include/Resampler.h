@@ -0,0 +1,145 @@
+/*
+* 
+* Copyright (c) 2011, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/Cinder.h"
+#include "cinder/CinderMath.h"
+#include <vector>
+
+// Use SSE where available
+#if !defined(RESAMPLER_SSE) && (defined(_M_IX86) || defined(_M_X64) || defined(__SSE__))
+#define RESAMPLER_SSE
+#endif
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Streaming polyphase sample rate converter for interleaved float audio
+class Resampler
+{
+
+private:
+
+	// The object
+	class Obj
+	{
+
+	public:
+
+		// Con/de-structor
+		Obj(int32_t inputRate, int32_t outputRate, int32_t channelCount, int32_t maxInputFrames, int32_t tapCount);
+		~Obj();
+
+		// Converts frames and returns output frame count
+		int32_t process(const float * input, int32_t frameCount);
+		int32_t process(const float * input, int32_t frameCount, float * output);
+
+		// Clears history
+		void reset();
+
+		// Getters
+		int32_t getChannelCount();
+		float * getData();
+		int32_t getDataSize();
+		int32_t getInputRate();
+		int32_t getLatency();
+		int32_t getMaxInputFrames();
+		int32_t getMaxOutputFrames(int32_t inputFrames);
+		int32_t getOutputRate();
+
+	private:
+
+		// Builds windowed sinc filter bank
+		void createFilter();
+
+		// Rates and ratio (output / input = up / down)
+		int32_t mChannelCount;
+		int32_t mDown;
+		int32_t mInputRate;
+		int32_t mOutputRate;
+		int32_t mUp;
+
+		// Filter bank, one row of taps per phase
+		vector<float> mCoefficients;
+		int32_t mTapCount;
+
+		// Per channel history, written twice so each
+		// window is contiguous
+		vector<float> mHistory;
+		int32_t mHistoryPosition;
+		int32_t mPhase;
+
+		// Output buffer and sample count
+		vector<float> mData;
+		int32_t mDataSize;
+		int32_t mMaxInputFrames;
+
+	};
+
+	// Pointer to object
+	std::shared_ptr<Obj> mObj;
+
+public:
+
+	// Constructors
+	Resampler() {}
+	Resampler(int32_t inputRate, int32_t outputRate, int32_t channelCount = 1, int32_t maxInputFrames = 4096, int32_t tapCount = 32) 
+		: mObj(std::shared_ptr<Obj>(new Obj(inputRate, outputRate, channelCount, maxInputFrames, tapCount))) {}
+	~Resampler() { mObj.reset(); }
+
+	// Converts up to getMaxInputFrames() frames into getData()
+	int32_t process(const float * input, int32_t frameCount) { return mObj->process(input, frameCount); }
+
+	// Converts frames into caller's buffer, which must hold getMaxOutputFrames(frameCount) frames
+	int32_t process(const float * input, int32_t frameCount, float * output) { return mObj->process(input, frameCount, output); }
+
+	// Clears history (call when stream is interrupted)
+	void reset() { mObj->reset(); }
+
+	// Getters
+	int32_t getChannelCount() { return mObj->getChannelCount(); }
+	float * getData() { return mObj->getData(); }
+	int32_t getDataSize() { return mObj->getDataSize(); }
+	int32_t getInputRate() { return mObj->getInputRate(); }
+	int32_t getLatency() { return mObj->getLatency(); }
+	int32_t getMaxInputFrames() { return mObj->getMaxInputFrames(); }
+	int32_t getMaxOutputFrames(int32_t inputFrames) { return mObj->getMaxOutputFrames(inputFrames); }
+	int32_t getOutputRate() { return mObj->getOutputRate(); }
+
+};
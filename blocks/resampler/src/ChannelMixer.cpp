@@ -0,0 +1,224 @@
+/*
+ * 
+ * Copyright (c) 2011, Ban the Rewind
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or 
+ * without modification, are permitted provided that the following 
+ * conditions are met:
+ * 
+ * Redistributions of source code must retain the above copyright 
+ * notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright 
+ * notice, this list of conditions and the following disclaimer in 
+ * the documentation and/or other materials provided with the 
+ * distribution.
+ * 
+ * Neither the name of the Ban the Rewind nor the names of its 
+ * contributors may be used to endorse or promote products 
+ * derived from this software without specific prior written 
+ * permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+
+// Include header
+#include "ChannelMixer.h"
+
+// Include SSE
+#ifdef RESAMPLER_SSE
+#include <xmmintrin.h>
+#endif
+
+// Constructor
+ChannelMixer::Obj::Obj(int32_t inputChannels, int32_t outputChannels, int32_t maxFrames)
+{
+
+	// Set layout
+	mInputChannels = math<int32_t>::max(inputChannels, 1);
+	mOutputChannels = math<int32_t>::max(outputChannels, 1);
+	mMaxFrames = math<int32_t>::max(maxFrames, 1);
+
+	// Allocate everything up front so processing never allocates
+	mGains.resize(mInputChannels * mOutputChannels);
+	mData.resize(mMaxFrames * mOutputChannels);
+	mDataSize = 0;
+
+	// Set up matrix
+	setDefaultGains();
+
+}
+
+// Destructor
+ChannelMixer::Obj::~Obj()
+{
+
+	// Clean up
+	mData.clear();
+	mGains.clear();
+
+}
+
+// Returns output buffer
+float * ChannelMixer::Obj::getData()
+{
+	return &mData[0];
+}
+
+// Returns number of samples in output buffer
+int32_t ChannelMixer::Obj::getDataSize()
+{
+	return mDataSize;
+}
+
+// Returns gain from input to output channel
+float ChannelMixer::Obj::getGain(int32_t inputChannel, int32_t outputChannel)
+{
+
+	// Bail if out of range
+	if (inputChannel < 0 || inputChannel >= mInputChannels || outputChannel < 0 || outputChannel >= mOutputChannels)
+		return 0.0f;
+
+	// DO IT!
+	return mGains[outputChannel * mInputChannels + inputChannel];
+
+}
+
+// Returns input channel count
+int32_t ChannelMixer::Obj::getInputChannels()
+{
+	return mInputChannels;
+}
+
+// Returns largest block process() accepts with internal buffer
+int32_t ChannelMixer::Obj::getMaxFrames()
+{
+	return mMaxFrames;
+}
+
+// Returns output channel count
+int32_t ChannelMixer::Obj::getOutputChannels()
+{
+	return mOutputChannels;
+}
+
+// Mix into internal buffer
+void ChannelMixer::Obj::process(const float * input, int32_t frameCount)
+{
+
+	// Mix up to buffer size
+	frameCount = math<int32_t>::min(frameCount, mMaxFrames);
+	process(input, frameCount, &mData[0]);
+	mDataSize = math<int32_t>::max(frameCount, 0) * mOutputChannels;
+
+}
+
+// Mix interleaved frames
+void ChannelMixer::Obj::process(const float * input, int32_t frameCount, float * output)
+{
+
+	// Bail if no data
+	if (input == 0 || output == 0 || frameCount <= 0)
+		return;
+
+	int32_t i = 0;
+
+#ifdef RESAMPLER_SSE
+
+	// Stereo to mono, four frames at a time
+	if (mInputChannels == 2 && mOutputChannels == 1)
+	{
+		__m128 mLeftGain = _mm_set1_ps(mGains[0]);
+		__m128 mRightGain = _mm_set1_ps(mGains[1]);
+		for (; i + 4 <= frameCount; i += 4)
+		{
+			__m128 mA = _mm_loadu_ps(input + i * 2);
+			__m128 mB = _mm_loadu_ps(input + i * 2 + 4);
+			__m128 mLeft = _mm_shuffle_ps(mA, mB, _MM_SHUFFLE(2, 0, 2, 0));
+			__m128 mRight = _mm_shuffle_ps(mA, mB, _MM_SHUFFLE(3, 1, 3, 1));
+			_mm_storeu_ps(output + i, _mm_add_ps(_mm_mul_ps(mLeft, mLeftGain), _mm_mul_ps(mRight, mRightGain)));
+		}
+	}
+
+	// Mono to stereo, four frames at a time
+	if (mInputChannels == 1 && mOutputChannels == 2)
+	{
+		__m128 mGain = _mm_setr_ps(mGains[0], mGains[1], mGains[0], mGains[1]);
+		for (; i + 4 <= frameCount; i += 4)
+		{
+			__m128 mMono = _mm_loadu_ps(input + i);
+			_mm_storeu_ps(output + i * 2, _mm_mul_ps(_mm_unpacklo_ps(mMono, mMono), mGain));
+			_mm_storeu_ps(output + i * 2 + 4, _mm_mul_ps(_mm_unpackhi_ps(mMono, mMono), mGain));
+		}
+	}
+
+#endif
+
+	// Remaining frames and other layouts
+	for (; i < frameCount; i++)
+	{
+		const float * mIn = input + i * mInputChannels;
+		float * mOut = output + i * mOutputChannels;
+		for (int32_t mOutput = 0; mOutput < mOutputChannels; mOutput++)
+		{
+			const float * mRow = &mGains[mOutput * mInputChannels];
+			float mSum = 0.0f;
+			for (int32_t mInput = 0; mInput < mInputChannels; mInput++)
+				mSum += mIn[mInput] * mRow[mInput];
+			mOut[mOutput] = mSum;
+		}
+	}
+
+}
+
+// Average down or copy up
+void ChannelMixer::Obj::setDefaultGains()
+{
+
+	// Clear matrix
+	fill(mGains.begin(), mGains.end(), 0.0f);
+
+	// Fewer outputs: each input goes to one output, averaged with the others landing there
+	if (mInputChannels >= mOutputChannels)
+	{
+		for (int32_t mOutput = 0; mOutput < mOutputChannels; mOutput++)
+		{
+			int32_t mCount = 0;
+			for (int32_t mInput = mOutput; mInput < mInputChannels; mInput += mOutputChannels)
+				mCount++;
+			for (int32_t mInput = mOutput; mInput < mInputChannels; mInput += mOutputChannels)
+				mGains[mOutput * mInputChannels + mInput] = 1.0f / (float)mCount;
+		}
+	}
+	else
+	{
+
+		// More outputs: wrap inputs around outputs
+		for (int32_t mOutput = 0; mOutput < mOutputChannels; mOutput++)
+			mGains[mOutput * mInputChannels + mOutput % mInputChannels] = 1.0f;
+
+	}
+
+}
+
+// Set gain from input to output channel
+void ChannelMixer::Obj::setGain(int32_t inputChannel, int32_t outputChannel, float gain)
+{
+
+	// DO IT!
+	if (inputChannel >= 0 && inputChannel < mInputChannels && outputChannel >= 0 && outputChannel < mOutputChannels)
+		mGains[outputChannel * mInputChannels + inputChannel] = gain;
+
+}
@@ -0,0 +1,291 @@
+/*
+ * 
+ * Copyright (c) 2011, Ban the Rewind
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or 
+ * without modification, are permitted provided that the following 
+ * conditions are met:
+ * 
+ * Redistributions of source code must retain the above copyright 
+ * notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright 
+ * notice, this list of conditions and the following disclaimer in 
+ * the documentation and/or other materials provided with the 
+ * distribution.
+ * 
+ * Neither the name of the Ban the Rewind nor the names of its 
+ * contributors may be used to endorse or promote products 
+ * derived from this software without specific prior written 
+ * permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+
+// Include header
+#include "Resampler.h"
+
+// Include SSE
+#ifdef RESAMPLER_SSE
+#include <xmmintrin.h>
+#endif
+
+// Greatest common divisor
+static int32_t greatestCommonDivisor(int32_t a, int32_t b)
+{
+	while (b != 0)
+	{
+		int32_t mRemainder = a % b;
+		a = b;
+		b = mRemainder;
+	}
+	return a;
+}
+
+// Multiply and sum two arrays (count must be multiple of four)
+static inline float dotProduct(const float * a, const float * b, int32_t count)
+{
+
+#ifdef RESAMPLER_SSE
+
+	// Four lanes at a time
+	__m128 mSum = _mm_setzero_ps();
+	for (int32_t i = 0; i < count; i += 4)
+		mSum = _mm_add_ps(mSum, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+
+	// Add lanes
+	mSum = _mm_add_ps(mSum, _mm_movehl_ps(mSum, mSum));
+	mSum = _mm_add_ss(mSum, _mm_shuffle_ps(mSum, mSum, 1));
+	return _mm_cvtss_f32(mSum);
+
+#else
+
+	// Four accumulators to break dependency chain
+	float mSum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for (int32_t i = 0; i < count; i += 4)
+	{
+		mSum[0] += a[i] * b[i];
+		mSum[1] += a[i + 1] * b[i + 1];
+		mSum[2] += a[i + 2] * b[i + 2];
+		mSum[3] += a[i + 3] * b[i + 3];
+	}
+	return (mSum[0] + mSum[1]) + (mSum[2] + mSum[3]);
+
+#endif
+
+}
+
+// Constructor
+Resampler::Obj::Obj(int32_t inputRate, int32_t outputRate, int32_t channelCount, int32_t maxInputFrames, int32_t tapCount)
+{
+
+	// Set format
+	mChannelCount = math<int32_t>::max(channelCount, 1);
+	mInputRate = math<int32_t>::max(inputRate, 1);
+	mOutputRate = math<int32_t>::max(outputRate, 1);
+	mMaxInputFrames = math<int32_t>::max(maxInputFrames, 1);
+
+	// Reduce ratio
+	int32_t mDivisor = greatestCommonDivisor(mInputRate, mOutputRate);
+	mUp = mOutputRate / mDivisor;
+	mDown = mInputRate / mDivisor;
+
+	// Round tap count up to a multiple of four for SIMD
+	mTapCount = math<int32_t>::max((tapCount + 3) & ~3, 4);
+
+	// Allocate everything up front so processing never allocates
+	mHistory.resize(mChannelCount * mTapCount * 2);
+	mData.resize(getMaxOutputFrames(mMaxInputFrames) * mChannelCount);
+	mDataSize = 0;
+
+	// Build filter and clear history
+	createFilter();
+	reset();
+
+}
+
+// Destructor
+Resampler::Obj::~Obj()
+{
+
+	// Clean up
+	mCoefficients.clear();
+	mData.clear();
+	mHistory.clear();
+
+}
+
+// Build windowed sinc filter bank
+void Resampler::Obj::createFilter()
+{
+
+	// Skip filter if rates match
+	if (mUp == mDown)
+		return;
+
+	// Prototype filter runs at input rate times up factor. Cut off just 
+	// below the lower Nyquist frequency to leave room for the transition band.
+	int32_t mLength = mTapCount * mUp;
+	double mCutoff = 0.5 * 0.94 / (double)math<int32_t>::max(mUp, mDown);
+	double mCenter = (double)(mLength - 1) * 0.5;
+	vector<double> mPrototype(mLength);
+	double mSum = 0.0;
+	for (int32_t i = 0; i < mLength; i++)
+	{
+
+		// Sinc
+		double mX = (double)i - mCenter;
+		double mSinc = mX == 0.0 ? 2.0 * mCutoff : sin(2.0 * M_PI * mCutoff * mX) / (M_PI * mX);
+
+		// Blackman-Harris window
+		double mW = 2.0 * M_PI * ((double)i + 0.5) / (double)mLength;
+		double mWindow = 0.35875 - 0.48829 * cos(mW) + 0.14128 * cos(2.0 * mW) - 0.01168 * cos(3.0 * mW);
+
+		mPrototype[i] = mSinc * mWindow;
+		mSum += mPrototype[i];
+
+	}
+
+	// Split prototype into phases, normalized for unity gain. Taps are 
+	// reversed so each phase lines up with history, oldest sample first.
+	double mGain = (double)mUp / mSum;
+	mCoefficients.resize(mUp * mTapCount);
+	for (int32_t mPhaseId = 0; mPhaseId < mUp; mPhaseId++)
+		for (int32_t i = 0; i < mTapCount; i++)
+			mCoefficients[mPhaseId * mTapCount + i] = (float)(mPrototype[mPhaseId + (mTapCount - 1 - i) * mUp] * mGain);
+
+}
+
+// Returns channel count
+int32_t Resampler::Obj::getChannelCount()
+{
+	return mChannelCount;
+}
+
+// Returns output buffer
+float * Resampler::Obj::getData()
+{
+	return &mData[0];
+}
+
+// Returns number of samples in output buffer
+int32_t Resampler::Obj::getDataSize()
+{
+	return mDataSize;
+}
+
+// Returns input sample rate
+int32_t Resampler::Obj::getInputRate()
+{
+	return mInputRate;
+}
+
+// Returns filter delay in output frames
+int32_t Resampler::Obj::getLatency()
+{
+	return mUp == mDown ? 0 : ((mTapCount * mUp - 1) / 2 + mDown / 2) / mDown;
+}
+
+// Returns largest block process() accepts with internal buffer
+int32_t Resampler::Obj::getMaxInputFrames()
+{
+	return mMaxInputFrames;
+}
+
+// Returns largest number of frames produced by an input block
+int32_t Resampler::Obj::getMaxOutputFrames(int32_t inputFrames)
+{
+	return (int32_t)(((int64_t)inputFrames * (int64_t)mUp) / (int64_t)mDown) + 2;
+}
+
+// Returns output sample rate
+int32_t Resampler::Obj::getOutputRate()
+{
+	return mOutputRate;
+}
+
+// Convert into internal buffer
+int32_t Resampler::Obj::process(const float * input, int32_t frameCount)
+{
+
+	// Convert up to buffer size
+	int32_t mFrames = process(input, math<int32_t>::min(frameCount, mMaxInputFrames), &mData[0]);
+	mDataSize = mFrames * mChannelCount;
+	return mFrames;
+
+}
+
+// Convert interleaved frames
+int32_t Resampler::Obj::process(const float * input, int32_t frameCount, float * output)
+{
+
+	// Bail if no data
+	if (input == 0 || output == 0 || frameCount <= 0)
+		return 0;
+
+	// Pass through if rates match
+	if (mUp == mDown)
+	{
+		memcpy(output, input, sizeof(float) * frameCount * mChannelCount);
+		return frameCount;
+	}
+
+	// Iterate through input frames
+	int32_t mOutputFrames = 0;
+	int32_t mHistorySize = mTapCount * 2;
+	for (int32_t i = 0; i < frameCount; i++)
+	{
+
+		// Push frame into history
+		mHistoryPosition = mHistoryPosition + 1 == mTapCount ? 0 : mHistoryPosition + 1;
+		for (int32_t mChannel = 0; mChannel < mChannelCount; mChannel++)
+		{
+			float * mChannelHistory = &mHistory[mChannel * mHistorySize];
+			float mValue = input[i * mChannelCount + mChannel];
+			mChannelHistory[mHistoryPosition] = mValue;
+			mChannelHistory[mHistoryPosition + mTapCount] = mValue;
+		}
+
+		// Emit every output frame which falls between
+		// this input frame and the next one
+		while (mPhase < mUp)
+		{
+			const float * mTaps = &mCoefficients[mPhase * mTapCount];
+			float * mFrame = output + mOutputFrames * mChannelCount;
+			for (int32_t mChannel = 0; mChannel < mChannelCount; mChannel++)
+				mFrame[mChannel] = dotProduct(mTaps, &mHistory[mChannel * mHistorySize + mHistoryPosition + 1], mTapCount);
+			mOutputFrames++;
+			mPhase += mDown;
+		}
+		mPhase -= mUp;
+
+	}
+
+	// Return number of frames written
+	return mOutputFrames;
+
+}
+
+// Clear history
+void Resampler::Obj::reset()
+{
+
+	// DO IT!
+	memset(&mHistory[0], 0, sizeof(float) * mHistory.size());
+	mHistoryPosition = 0;
+	mPhase = 0;
+	mDataSize = 0;
+
+}
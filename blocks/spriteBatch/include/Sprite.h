@@ -40,12 +40,15 @@
 #include <cinder/Area.h>
 #include <cinder/gl/Texture.h>
 #include <cinder/ImageIo.h>
+#include "SpriteStore.h"
 
 // Imports
 using namespace ci;
 using namespace std;
 
-// Sprite class
+// Sprite class. Once inserted into a SpriteBatch, a sprite's 
+// properties live in the batch's store and the sprite reads and
+// writes them there.
 class Sprite
 {
 
@@ -57,67 +60,130 @@ private:
 	public: 
 
 		// Con/de-structors
-		Obj(const gl::Texture & texture, const Area & area, const ColorAf & color) : mAlpha(1.0f), 
-			mBounds(texture.getCleanBounds()), 
+		Obj(const gl::Texture & texture, const Area & source, const Area & area, const ColorAf & color) : mAlpha(1.0f), 
+			mBounds(source), 
 			mColor(color), 
-			mId(-numeric_limits<int32_t>::max()), 
+			mDepth(0.0f), 
+			mId(SpriteStore::NO_ID), 
+			mLayer(0), 
 			mTexture(texture), 
 			mVisible(true)
 		{
 			set(area.getX1(), area.getY1(), area.getX2(), area.getY2());
-			setCenter();
-			
-			// Set contact interval
-			mContactInterval = 0.1;
-			mLastContactTime = 0.0;
+
+			// Texture coordinates don't change, so find them once
+			if (mTexture)
+				mTexCoords = mTexture.getAreaTexCoords(mBounds);
 
 		}
 		~Obj() { mTexture.reset(); };
 
 		// Draw
 		void draw() {
-			if (mVisible && mBounds.getWidth() > 0 && mBounds.getHeight() > 0)
+			const Area & mSource = getSource();
+			if (getVisible() && mSource.getWidth() > 0 && mSource.getHeight() > 0)
 			{
-				gl::color(mAlpha == 1.0f ? mColor : ColorAf(mColor.r, mColor.g, mColor.b, mAlpha));
-				gl::draw(mTexture, (Area)(* this)); 
+				gl::color(getColor());
+				gl::draw(getTexture(), mSource, getRect()); 
 			}
 		}
 
+		// Moves properties into store, returning ID
+		int32_t bind(const SpriteStore & store)
+		{
+			mStore = store;
+			mId = mStore.insert(mTexture, mBounds, mTexCoords, Rectf((float)x1, (float)y1, (float)x2, (float)y2), mColor, mAlpha, mVisible, mLayer, mDepth);
+			return mId;
+		}
+
+		// Copies properties back out of store
+		void unbind()
+		{
+			int32_t mIndex = getIndex();
+			if (mIndex >= 0)
+			{
+				Rectf mRect = getRect();
+				set((int32_t)mRect.x1, (int32_t)mRect.y1, (int32_t)mRect.x2, (int32_t)mRect.y2);
+				mAlpha = mStore.getAlphas()[mIndex];
+				mColor = mStore.getColors()[mIndex];
+				mDepth = mStore.getDepths()[mIndex];
+				mLayer = mStore.getLayers()[mIndex];
+				mBounds = mStore.getSources()[mIndex];
+				mTexCoords = mStore.getTexCoords()[mIndex];
+				mTexture = mStore.getTexture(mStore.getTextureIds()[mIndex]);
+				mVisible = mStore.getVisible()[mIndex] != 0;
+			}
+			mStore = SpriteStore();
+			mId = SpriteStore::NO_ID;
+		}
+
 		// Get/set
-		float getAlpha() { return mAlpha; }
-		Vec2f getCenter() { return mCenter; }
+		float getAlpha() { int32_t mIndex = getIndex(); return mIndex < 0 ? mAlpha : mStore.getAlphas()[mIndex]; }
+		Vec2f getCenter() { return getRect().getCenter(); }
+		ColorAf getColor() 
+		{ 
+			int32_t mIndex = getIndex();
+			return mIndex < 0 ? SpriteStore::getDrawColor(mColor, mAlpha) : SpriteStore::getDrawColor(mStore.getColors()[mIndex], mStore.getAlphas()[mIndex]); 
+		}
+		float getDepth() { int32_t mIndex = getIndex(); return mIndex < 0 ? mDepth : mStore.getDepths()[mIndex]; }
 		int32_t getId() { return mId; }
-		bool getVisible() { return mVisible; }
-		void setAlpha(float alpha) { mAlpha = alpha; }
-		void setCenter() { mCenter = Vec2f((float)(x1 + (x2 - x1) / 2), (float)(y1 + (y2 - y1) / 2)); }
-		void setColor(const ColorAf & color) { mColor = color; }
-		void setId(int32_t id) { mId = id; }
-		void setVisible(bool visible) { mVisible = visible; }
-		void setX(int32_t value) { 
-			int32_t mDiff = value - x1; 
-			x1 += mDiff;
-			x2 += mDiff;
-			setCenter();
+		int32_t getLayer() { int32_t mIndex = getIndex(); return mIndex < 0 ? mLayer : mStore.getLayers()[mIndex]; }
+		const SpriteStore & getStore() { return mStore; }
+		Rectf getRect()
+		{
+			int32_t mIndex = getIndex();
+			if (mIndex < 0)
+				return Rectf((float)x1, (float)y1, (float)x2, (float)y2);
+			const Vec2f & mPosition = mStore.getPositions()[mIndex];
+			return Rectf(mPosition, mPosition + mStore.getSizes()[mIndex]);
+		}
+		const Area & getSource() { int32_t mIndex = getIndex(); return mIndex < 0 ? mBounds : mStore.getSources()[mIndex]; }
+		const Rectf & getTexCoords() { int32_t mIndex = getIndex(); return mIndex < 0 ? mTexCoords : mStore.getTexCoords()[mIndex]; }
+		const gl::Texture & getTexture() { int32_t mIndex = getIndex(); return mIndex < 0 ? mTexture : mStore.getTexture(mStore.getTextureIds()[mIndex]); }
+		bool getVisible() { int32_t mIndex = getIndex(); return mIndex < 0 ? mVisible : mStore.getVisible()[mIndex] != 0; }
+		void setAlpha(float alpha) { int32_t mIndex = getIndex(); if (mIndex < 0) mAlpha = alpha; else mStore.getAlphas()[mIndex] = alpha; }
+		void setColor(const ColorAf & color) { int32_t mIndex = getIndex(); if (mIndex < 0) mColor = color; else mStore.getColors()[mIndex] = color; }
+		void setDepth(float depth) { if (getIndex() < 0) mDepth = depth; else mStore.setDepth(mId, depth); }
+		void setTexture(const gl::Texture & texture, const Area & source)
+		{
+			Rectf mCoords = texture ? texture.getAreaTexCoords(source) : Rectf();
+			if (getIndex() >= 0)
+			{
+				mStore.setTexture(mId, texture, source, mCoords);
+			}
+			else
+			{
+				mBounds = source;
+				mTexCoords = mCoords;
+				mTexture = texture;
+			}
 		}
-		void setY(int32_t value) { 
-			int32_t mDiff = value - y1; 
-			y1 += mDiff;
-			y2 += mDiff;
-			setCenter();
+		void setLayer(int32_t layer) { if (getIndex() < 0) mLayer = layer; else mStore.setLayer(mId, layer); }
+		void setRect(const Rectf & rect)
+		{
+			int32_t mIndex = getIndex();
+			if (mIndex < 0)
+			{
+				set((int32_t)rect.x1, (int32_t)rect.y1, (int32_t)rect.x2, (int32_t)rect.y2);
+			}
+			else
+			{
+				mStore.setRect(mId, rect);
+			}
 		}
-
-		// These are needed to prevent simultaneous
-		// contacts from crashing
-		double mLastContactTime;
-		double mContactInterval;
+		void setVisible(bool visible) { int32_t mIndex = getIndex(); if (mIndex < 0) mVisible = visible; else mStore.getVisible()[mIndex] = visible ? 1 : 0; }
 
 	private:
 
+		// Index in store, or -1 if not in one
+		int32_t getIndex() { return mStore ? mStore.getIndex(mId) : -1; }
+
 		// Color
 		ColorAf mColor;
 
 		// Texture
 		Area mBounds;
+		Rectf mTexCoords;
 		gl::Texture mTexture;
 
 		// ID
@@ -127,64 +193,89 @@ private:
 		bool mVisible;
 		float mAlpha;
 
-		// Center
-		Vec2f mCenter;
+		// Draw order
+		float mDepth;
+		int32_t mLayer;
+
+		// Store holding properties while in a batch
+		SpriteStore mStore;
 
 	};
 
 	//	The object
 	std::shared_ptr<Obj> mObj;
 
+	// Batch binds sprites to its store, which sets their IDs
+	friend class SpriteBatch;
+
 public:
 
 	// Constructor
 	Sprite() {};
-	Sprite(const gl::Texture & texture, const Area & area, const ColorAf & color) : mObj(shared_ptr<Obj>(new Obj(texture, area, color))) {}
+	Sprite(const gl::Texture & texture, const Area & area, const ColorAf & color) : mObj(shared_ptr<Obj>(new Obj(texture, texture.getCleanBounds(), area, color))) {}
+	Sprite(const gl::Texture & texture, const Area & source, const Area & area, const ColorAf & color) : mObj(shared_ptr<Obj>(new Obj(texture, source, area, color))) {}
 	~Sprite() { mObj.reset(); }
 
 	// Methods
-	bool contains(const Vec2f & offset) 
-	{
-		// Bail if simulateous touches
-		if (!mObj)
-			return false;
-		if (getElapsedSeconds() - mObj->mLastContactTime < mObj->mContactInterval)
-			return false;
-		mObj->mLastContactTime = getElapsedSeconds();
-		return mObj->contains(offset); 
-	}
+	bool contains(const Vec2f & offset) const { return mObj && mObj->getRect().contains(offset); }
 	void draw() { mObj->draw(); }
 	float getAlpha() const { return mObj->getAlpha(); }
 	Vec2f getCenter() { return mObj->getCenter(); }
-	int32_t getHeight() { return mObj->getY2() - mObj->getY1(); }
+	ColorAf getColor() const { return mObj->getColor(); }
+	float getDepth() const { return mObj->getDepth(); }
+	int32_t getLayer() const { return mObj->getLayer(); }
+	Rectf getRect() const { return mObj->getRect(); }
+	Area getSource() const { return mObj->getSource(); }
+	const Rectf & getTexCoords() const { return mObj->getTexCoords(); }
+	const gl::Texture & getTexture() const { return mObj->getTexture(); }
+	int32_t getHeight() { return (int32_t)mObj->getRect().getHeight(); }
 	int32_t getId() const { return mObj->getId(); }
 	bool getVisible() const { return mObj->getVisible(); }
-	int32_t getWidth() { return mObj->getX2() - mObj->getX1(); }
+	int32_t getWidth() { return (int32_t)mObj->getRect().getWidth(); }
 	void setAlpha(float alpha) const { mObj->setAlpha(alpha); }
 	void setColor(const ColorAf & color) const { mObj->setColor(color); }
-	void setId(int32_t id) const { mObj->setId(id); }
+	void setDepth(float depth) const { mObj->setDepth(depth); }
+	void setLayer(int32_t layer) const { mObj->setLayer(layer); }
+	void setTexture(const gl::Texture & texture) const { mObj->setTexture(texture, texture.getCleanBounds()); }
+	void setTexture(const gl::Texture & texture, const Area & source) const { mObj->setTexture(texture, source); }
 	void setVisible(bool visible) const { mObj->setVisible(visible); }
-	int32_t getX1() { return mObj->getX1(); }
-	int32_t getX2() { return mObj->getX2(); }
-	int32_t getY1() { return mObj->getY1(); };
-	int32_t getY2() { return mObj->getY2(); }
-	void setX(int32_t value) { mObj->setX(value); };
-	void setX1(int32_t value) { 
-		mObj->setX1(value); 
-		mObj->setCenter();
+	int32_t getX1() { return (int32_t)mObj->getRect().x1; }
+	int32_t getX2() { return (int32_t)mObj->getRect().x2; }
+	int32_t getY1() { return (int32_t)mObj->getRect().y1; };
+	int32_t getY2() { return (int32_t)mObj->getRect().y2; }
+	void setX(int32_t value) 
+	{ 
+		Rectf mRect = mObj->getRect();
+		mObj->setRect(mRect.getOffset(Vec2f((float)value - mRect.x1, 0.0f)));
+	};
+	void setX1(int32_t value) 
+	{ 
+		Rectf mRect = mObj->getRect();
+		mRect.x1 = (float)value;
+		mObj->setRect(mRect);
+	}
+	void setX2(int32_t value) 
+	{ 
+		Rectf mRect = mObj->getRect();
+		mRect.x2 = (float)value;
+		mObj->setRect(mRect);
 	}
-	void setX2(int32_t value) { 
-		mObj->setX2(value);
-		mObj->setCenter();
+	void setY(int32_t value) 
+	{ 
+		Rectf mRect = mObj->getRect();
+		mObj->setRect(mRect.getOffset(Vec2f(0.0f, (float)value - mRect.y1)));
 	}
-	void setY(int32_t value) { mObj->setY(value); }
-	void setY1(int32_t value) { 
-		mObj->setY1(value); 
-		mObj->setCenter();
+	void setY1(int32_t value) 
+	{ 
+		Rectf mRect = mObj->getRect();
+		mRect.y1 = (float)value;
+		mObj->setRect(mRect);
 	}
-	void setY2(int32_t value) { 
-		mObj->setY2(value); 
-		mObj->setCenter();
+	void setY2(int32_t value) 
+	{ 
+		Rectf mRect = mObj->getRect();
+		mRect.y2 = (float)value;
+		mObj->setRect(mRect);
 	}
 
 };
@@ -0,0 +1,477 @@
+/*
+* 
+* Copyright (c) 2011, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/Cinder.h"
+#include "cinder/CinderMath.h"
+#include "cinder/Color.h"
+#include "cinder/Thread.h"
+#include "cinder/Vector.h"
+#include "SpriteStore.h"
+#include <vector>
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Tweens sprite positions, alpha and color. Tweens are kept in 
+// flat arrays, one table per property, and update() splits them 
+// into chunks run in parallel on a pool of worker threads. Each 
+// chunk writes straight into the store's property arrays, which 
+// the batch streams to its vertex buffer on draw().
+class SpriteAnimator
+{
+
+public:
+
+	// Easing curves
+	enum Ease
+	{
+		EASE_LINEAR, 
+		EASE_IN_QUAD, 
+		EASE_OUT_QUAD, 
+		EASE_IN_OUT_QUAD, 
+		EASE_IN_CUBIC, 
+		EASE_OUT_CUBIC, 
+		EASE_IN_OUT_CUBIC, 
+		EASE_IN_OUT_SINE
+	};
+
+	// Applies easing curve to t, where t is in [0, 1]
+	static float ease(Ease curve, float t)
+	{
+		switch (curve)
+		{
+		case EASE_IN_QUAD:
+			return t * t;
+		case EASE_OUT_QUAD:
+			return t * (2.0f - t);
+		case EASE_IN_OUT_QUAD:
+			return t < 0.5f ? 2.0f * t * t : -1.0f + (4.0f - 2.0f * t) * t;
+		case EASE_IN_CUBIC:
+			return t * t * t;
+		case EASE_OUT_CUBIC:
+			t -= 1.0f;
+			return t * t * t + 1.0f;
+		case EASE_IN_OUT_CUBIC:
+			if (t < 0.5f)
+				return 4.0f * t * t * t;
+			t = 2.0f * t - 2.0f;
+			return 0.5f * t * t * t + 1.0f;
+		case EASE_IN_OUT_SINE:
+			return 0.5f - 0.5f * math<float>::cos((float)M_PI * t);
+		default:
+			return t;
+		}
+	}
+
+private:
+
+	// Tweens for one property. Each sprite has at most one tween
+	// per table, so parallel chunks never write the same element.
+	template<typename T>
+	struct TweenTable
+	{
+
+		// Adds tween, replacing any on the same sprite
+		void add(int32_t id, const T & from, const T & to, float start, float duration, Ease curve)
+		{
+
+			// Grow slot lookup
+			int32_t mSlot = id & SpriteStore::SLOT_MASK;
+			if (mSlot >= (int32_t)mIndices.size())
+				mIndices.resize((size_t)mSlot + 1, -1);
+
+			// Overwrite existing tween or append
+			int32_t mIndex = mIndices[mSlot];
+			if (mIndex < 0 || mIds[mIndex] != id)
+			{
+				if (mIndex >= 0)
+					remove(mIndex);
+				mIndex = (int32_t)mIds.size();
+				mIndices[mSlot] = mIndex;
+				mCurves.push_back((uint8_t)curve);
+				mDone.push_back(0);
+				mDurations.push_back(0.0f);
+				mFrom.push_back(from);
+				mIds.push_back(id);
+				mStarts.push_back(0.0f);
+				mTo.push_back(to);
+			}
+			mCurves[mIndex] = (uint8_t)curve;
+			mDone[mIndex] = 0;
+			mDurations[mIndex] = duration;
+			mFrom[mIndex] = from;
+			mStarts[mIndex] = start;
+			mTo[mIndex] = to;
+
+		}
+
+		// Removes all tweens
+		void clear()
+		{
+			mCurves.clear();
+			mDone.clear();
+			mDurations.clear();
+			mFrom.clear();
+			mIds.clear();
+			mIndices.clear();
+			mStarts.clear();
+			mTo.clear();
+		}
+
+		// Returns true if sprite has a tween here
+		bool contains(int32_t id) const
+		{
+			int32_t mSlot = id & SpriteStore::SLOT_MASK;
+			return mSlot < (int32_t)mIndices.size() && mIndices[mSlot] >= 0 && mIds[mIndices[mSlot]] == id;
+		}
+
+		// Drops finished tweens
+		void compact()
+		{
+			for (int32_t i = (int32_t)mIds.size() - 1; i >= 0; i--)
+				if (mDone[i] != 0)
+					remove(i);
+		}
+
+		// Removes tween at index by moving the last one into its place
+		void remove(int32_t index)
+		{
+			int32_t mLast = (int32_t)mIds.size() - 1;
+			if (mIndices[mIds[index] & SpriteStore::SLOT_MASK] == index)
+				mIndices[mIds[index] & SpriteStore::SLOT_MASK] = -1;
+			if (index != mLast)
+			{
+				mCurves[index] = mCurves[mLast];
+				mDone[index] = mDone[mLast];
+				mDurations[index] = mDurations[mLast];
+				mFrom[index] = mFrom[mLast];
+				mIds[index] = mIds[mLast];
+				mStarts[index] = mStarts[mLast];
+				mTo[index] = mTo[mLast];
+				mIndices[mIds[index] & SpriteStore::SLOT_MASK] = index;
+			}
+			mCurves.pop_back();
+			mDone.pop_back();
+			mDurations.pop_back();
+			mFrom.pop_back();
+			mIds.pop_back();
+			mStarts.pop_back();
+			mTo.pop_back();
+		}
+
+		// Removes tween for sprite, if any
+		void removeId(int32_t id)
+		{
+			if (contains(id))
+				remove(mIndices[id & SpriteStore::SLOT_MASK]);
+		}
+
+		// Advances tweens in [begin, end) to time and writes 
+		// values into target, which is indexed like the store
+		void run(const SpriteStore & store, vector<T> & target, float time, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+
+				// Flag tweens on removed sprites
+				int32_t mIndex = store.getIndex(mIds[i]);
+				if (mIndex < 0)
+				{
+					mDone[i] = 1;
+					continue;
+				}
+
+				// Skip delayed tweens
+				float mElapsed = time - mStarts[i];
+				if (mElapsed < 0.0f)
+					continue;
+
+				// Interpolate
+				float t = mDurations[i] > 0.0f ? math<float>::min(mElapsed / mDurations[i], 1.0f) : 1.0f;
+				target[mIndex] = mFrom[i] + (mTo[i] - mFrom[i]) * ease((Ease)mCurves[i], t);
+				if (t >= 1.0f)
+					mDone[i] = 1;
+
+			}
+		}
+
+		// Logs sprites with running tweens as moved. Called 
+		// on the update thread once the chunks are done.
+		void markMoved(SpriteStore & store, float time)
+		{
+			for (size_t i = 0; i < mIds.size(); i++)
+				if (mStarts[i] <= time)
+					store.markMoved(mIds[i]);
+		}
+
+		// Number of tweens
+		size_t size() const { return mIds.size(); }
+
+		// Tween properties
+		vector<uint8_t> mCurves;
+		vector<uint8_t> mDone;
+		vector<float> mDurations;
+		vector<T> mFrom;
+		vector<int32_t> mIds;
+		vector<float> mStarts;
+		vector<T> mTo;
+
+		// Tween index by sprite slot
+		vector<int32_t> mIndices;
+
+	};
+
+	// The object
+	class Obj
+	{
+
+	public:
+
+		// Con/de-structor
+		Obj(const SpriteStore & store, int32_t threadCount) : mChunkCount(1), mExit(false), mGeneration(0), mPending(0), mStore(store), mTime(0.0f)
+		{
+
+			// Use all cores by default. The calling thread runs 
+			// a chunk too, so start one fewer worker.
+			if (threadCount <= 0)
+				threadCount = math<int32_t>::max((int32_t)thread::hardware_concurrency(), 1);
+			for (int32_t i = 1; i < threadCount; i++)
+				mWorkers.push_back(std::shared_ptr<thread>(new thread(&SpriteAnimator::Obj::work, this, i)));
+
+		}
+		~Obj()
+		{
+
+			// Stop workers
+			{
+				lock_guard<mutex> mLock(mMutex);
+				mExit = true;
+			}
+			mWake.notify_all();
+			for (vector<std::shared_ptr<thread> >::iterator mWorker = mWorkers.begin(); mWorker != mWorkers.end(); ++mWorker)
+				(* mWorker)->join();
+
+		}
+
+		// Starts tweens from current values
+		void fadeTo(int32_t id, float alpha, float duration, Ease curve, float delay)
+		{
+			int32_t mIndex = mStore.getIndex(id);
+			if (mIndex >= 0)
+				mAlphas.add(id, mStore.getAlphas()[mIndex], alpha, mTime + delay, duration, curve);
+		}
+		void moveTo(int32_t id, const Vec2f & position, float duration, Ease curve, float delay)
+		{
+			int32_t mIndex = mStore.getIndex(id);
+			if (mIndex >= 0)
+				mPositions.add(id, mStore.getPositions()[mIndex], position, mTime + delay, duration, curve);
+		}
+		void tintTo(int32_t id, const ColorAf & color, float duration, Ease curve, float delay)
+		{
+			int32_t mIndex = mStore.getIndex(id);
+			if (mIndex >= 0)
+				mColors.add(id, mStore.getColors()[mIndex], color, mTime + delay, duration, curve);
+		}
+
+		// Stops tweens
+		void clear()
+		{
+			mAlphas.clear();
+			mColors.clear();
+			mPositions.clear();
+		}
+		void stop(int32_t id)
+		{
+			mAlphas.removeId(id);
+			mColors.removeId(id);
+			mPositions.removeId(id);
+		}
+
+		// Advances clock and applies tweens
+		void update(float seconds)
+		{
+
+			// Advance clock
+			mTime += seconds;
+
+			// Run small workloads on this thread only
+			mChunkCount = size() < MIN_PARALLEL_SIZE ? 1 : (int32_t)mWorkers.size() + 1;
+
+			// Wake workers, then run the first chunk here
+			if (mChunkCount > 1)
+			{
+				{
+					lock_guard<mutex> mLock(mMutex);
+					mPending = mChunkCount - 1;
+					mGeneration++;
+				}
+				mWake.notify_all();
+			}
+			run(0);
+
+			// Wait for workers to finish
+			if (mChunkCount > 1)
+			{
+				unique_lock<mutex> mLock(mMutex);
+				while (mPending > 0)
+					mFinished.wait(mLock);
+			}
+
+			// Let the batch refile moved sprites, 
+			// then drop finished tweens
+			mPositions.markMoved(mStore, mTime);
+			mAlphas.compact();
+			mColors.compact();
+			mPositions.compact();
+
+		}
+
+		// Getters
+		bool isAnimating(int32_t id) const { return mAlphas.contains(id) || mColors.contains(id) || mPositions.contains(id); }
+		int32_t getThreadCount() const { return (int32_t)mWorkers.size() + 1; }
+		float getTime() const { return mTime; }
+		int32_t size() const { return (int32_t)(mAlphas.size() + mColors.size() + mPositions.size()); }
+
+	private:
+
+		// Below this many tweens, threading costs more than it saves
+		static const int32_t MIN_PARALLEL_SIZE = 4096;
+
+		// Runs one chunk of each table
+		void run(int32_t chunk)
+		{
+			runTable(mAlphas, mStore.getAlphas(), chunk);
+			runTable(mColors, mStore.getColors(), chunk);
+			runTable(mPositions, mStore.getPositions(), chunk);
+		}
+		template<typename T>
+		void runTable(TweenTable<T> & table, vector<T> & target, int32_t chunk)
+		{
+			size_t mSize = table.size();
+			table.run(mStore, target, mTime, mSize * (size_t)chunk / (size_t)mChunkCount, mSize * (size_t)(chunk + 1) / (size_t)mChunkCount);
+		}
+
+		// Worker thread loop
+		void work(int32_t chunk)
+		{
+			uint32_t mSeen = 0;
+			while (true)
+			{
+
+				// Wait for an update
+				{
+					unique_lock<mutex> mLock(mMutex);
+					while (!mExit && mGeneration == mSeen)
+						mWake.wait(mLock);
+					if (mExit)
+						return;
+					mSeen = mGeneration;
+				}
+
+				// Run chunk and report back
+				run(chunk);
+				{
+					lock_guard<mutex> mLock(mMutex);
+					mPending--;
+					if (mPending == 0)
+						mFinished.notify_one();
+				}
+
+			}
+		}
+
+		// Tweens
+		TweenTable<float> mAlphas;
+		TweenTable<ColorAf> mColors;
+		TweenTable<Vec2f> mPositions;
+
+		// Sprite properties
+		SpriteStore mStore;
+		float mTime;
+
+		// Worker pool
+		int32_t mChunkCount;
+		bool mExit;
+		condition_variable mFinished;
+		uint32_t mGeneration;
+		mutex mMutex;
+		int32_t mPending;
+		condition_variable mWake;
+		vector<std::shared_ptr<thread> > mWorkers;
+
+	};
+
+	// Pointer to object
+	std::shared_ptr<Obj> mObj;
+
+public:
+
+	// Con/de-structor. Pass the batch's store. A thread count of 
+	// zero uses one thread per core.
+	SpriteAnimator() {}
+	SpriteAnimator(const SpriteStore & store, int32_t threadCount = 0) : mObj(std::shared_ptr<Obj>(new Obj(store, threadCount))) {}
+	~SpriteAnimator() { mObj.reset(); }
+
+	// Tween sprite from its current value to a new one over duration 
+	// seconds, starting after delay. Starting a tween replaces any 
+	// running on the same property of the same sprite. Positions 
+	// are the sprite's top left corner.
+	void fadeTo(int32_t id, float alpha, float duration, Ease curve = EASE_LINEAR, float delay = 0.0f) { mObj->fadeTo(id, alpha, duration, curve, delay); }
+	void moveTo(int32_t id, const Vec2f & position, float duration, Ease curve = EASE_LINEAR, float delay = 0.0f) { mObj->moveTo(id, position, duration, curve, delay); }
+	void tintTo(int32_t id, const ColorAf & color, float duration, Ease curve = EASE_LINEAR, float delay = 0.0f) { mObj->tintTo(id, color, duration, curve, delay); }
+
+	// Stop tweens, leaving sprites where they are
+	void clear() { mObj->clear(); }
+	void stop(int32_t id) { mObj->stop(id); }
+
+	// Advance all tweens by seconds. Call once per frame before 
+	// drawing, and don't insert or erase sprites while it runs.
+	void update(float seconds) { mObj->update(seconds); }
+
+	// Getters
+	bool isAnimating(int32_t id) const { return mObj->isAnimating(id); }
+	int32_t getThreadCount() const { return mObj->getThreadCount(); }
+	float getTime() const { return mObj->getTime(); }
+	int32_t size() const { return mObj->size(); }
+
+	// Validity
+	operator bool() const { return mObj.get() != 0; }
+
+};
@@ -0,0 +1,479 @@
+/*
+* 
+* Copyright (c) 2011, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/app/App.h"
+#include "cinder/Cinder.h"
+#include "cinder/gl/Texture.h"
+#include "cinder/ImageIo.h"
+#include "cinder/Surface.h"
+#include "cinder/Utilities.h"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include "Sprite.h"
+#include <vector>
+
+// Imports
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Packs images into a few large textures so sprites can share 
+// them and draw in a handful of batches. Add surfaces by name, 
+// call pack(), then create sprites from the named regions.
+class SpriteAtlas
+{
+
+private:
+
+	// The object
+	class Obj
+	{
+
+	public:
+
+		// Con/de-structor
+		Obj(int32_t pageSize, int32_t padding) : mPadding(padding), mPageSize(pageSize) {}
+		~Obj() {}
+
+		// Queues surface for next pack
+		void add(const string & name, const Surface & surface)
+		{
+
+			// Bail if image won't fit on a page
+			if (surface.getWidth() + mPadding * 2 > mPageSize || surface.getHeight() + mPadding * 2 > mPageSize)
+			{
+				console() << "Image \"" << name << "\" is larger than atlas page\n";
+				return;
+			}
+
+			// DO IT!
+			mPending.push_back(make_pair(name, surface));
+
+		}
+
+		// Packs queued surfaces
+		void pack()
+		{
+
+			// Bail if nothing's queued
+			if (mPending.empty())
+				return;
+
+			// Tallest first, then widest, packs the skyline tightest
+			sort(mPending.begin(), mPending.end(), &Obj::isTaller);
+
+			// Place each surface on the first page that fits,
+			// opening a new page when none do
+			vector<bool> mPageDirty(mPages.size(), false);
+			for (vector<Pending>::iterator mImage = mPending.begin(); mImage != mPending.end(); ++mImage)
+			{
+
+				// Padded size
+				int32_t mWidth = mImage->second.getWidth() + mPadding * 2;
+				int32_t mHeight = mImage->second.getHeight() + mPadding * 2;
+
+				// Find page and position
+				Vec2i mPosition;
+				int32_t mPageId = -1;
+				for (int32_t i = 0; i < (int32_t)mPages.size() && mPageId < 0; i++)
+					if (mPages[i].find(mWidth, mHeight, mPosition))
+						mPageId = i;
+				if (mPageId < 0)
+				{
+					mPageId = (int32_t)mPages.size();
+					mPages.push_back(Page(mPageSize));
+					mPageDirty.push_back(false);
+					mPages[mPageId].find(mWidth, mHeight, mPosition);
+				}
+
+				// Claim space and copy image into page
+				Page & mPage = mPages[mPageId];
+				mPage.place(mPosition, mWidth, mHeight);
+				Vec2i mOrigin = mPosition + Vec2i(mPadding, mPadding);
+				mPage.mSurface.copyFrom(mImage->second, mImage->second.getBounds(), mOrigin);
+				mPageDirty[mPageId] = true;
+
+				// Record region
+				Region mRegion;
+				mRegion.mArea = Area(mOrigin, mOrigin + mImage->second.getSize());
+				mRegion.mPage = mPageId;
+				mRegions[mImage->first] = mRegion;
+
+			}
+			mPending.clear();
+
+			// Upload changed pages. Existing textures are updated in 
+			// place so sprites already using them stay valid.
+			for (int32_t i = 0; i < (int32_t)mPages.size(); i++)
+			{
+				if (mPageDirty[i])
+				{
+					if (mPages[i].mTexture)
+						mPages[i].mTexture.update(mPages[i].mSurface);
+					else
+						mPages[i].mTexture = gl::Texture(mPages[i].mSurface);
+				}
+			}
+
+		}
+
+		// Writes pages as PNG and an index of regions
+		bool save(const string & path)
+		{
+
+			// Pack anything left over
+			pack();
+
+			// Open index
+			ofstream mFile(path.c_str(), ios::trunc);
+			if (!mFile.is_open())
+			{
+				console() << "Unable to write atlas \"" << path << "\"\n";
+				return false;
+			}
+
+			// Write header and pages
+			mFile << "btratlas " << VERSION << "\n";
+			mFile << "pagesize " << mPageSize << " " << mPadding << "\n";
+			for (int32_t i = 0; i < (int32_t)mPages.size(); i++)
+			{
+				string mPagePath = path + "." + toString(i) + ".png";
+				writeImage(mPagePath, mPages[i].mSurface);
+				mFile << "page " << mPagePath.substr(mPagePath.find_last_of("/\\") + 1) << "\n";
+			}
+
+			// Write regions. Name goes last since it may have spaces.
+			for (map<string, Region>::iterator mRegion = mRegions.begin(); mRegion != mRegions.end(); ++mRegion)
+			{
+				const Area & mArea = mRegion->second.mArea;
+				mFile << "region " << mRegion->second.mPage << " " << mArea.getX1() << " " << mArea.getY1() << " " << 
+					mArea.getX2() << " " << mArea.getY2() << " " << mRegion->first << "\n";
+			}
+
+			// Close file
+			mFile.close();
+			return true;
+
+		}
+
+		// Reads pages and regions written by save()
+		bool load(const string & path)
+		{
+
+			// Open index
+			ifstream mFile(path.c_str());
+			if (!mFile.is_open())
+				return false;
+
+			// Check header
+			string mTag;
+			int32_t mVersion = 0;
+			mFile >> mTag >> mVersion;
+			if (mTag != "btratlas" || mVersion != VERSION)
+			{
+				console() << "Invalid atlas \"" << path << "\"\n";
+				return false;
+			}
+
+			// Page paths are relative to index
+			string mDirectory = path.substr(0, path.find_last_of("/\\") + 1);
+
+			// Read entries into new lists so a bad file leaves this atlas alone
+			vector<Page> mNewPages;
+			map<string, Region> mNewRegions;
+			int32_t mNewPageSize = mPageSize;
+			int32_t mNewPadding = mPadding;
+			string mLine;
+			while (getline(mFile, mLine))
+			{
+				istringstream mStream(mLine);
+				string mKey;
+				mStream >> mKey;
+				if (mKey == "pagesize")
+				{
+					mStream >> mNewPageSize >> mNewPadding;
+				}
+				else if (mKey == "page")
+				{
+
+					// Load page image
+					string mFileName;
+					getline(mStream >> ws, mFileName);
+					Page mPage(0);
+					try
+					{
+						mPage.mSurface = Surface(loadImage(mDirectory + mFileName));
+					}
+					catch (...)
+					{
+						console() << "Unable to load atlas page \"" << mFileName << "\"\n";
+						return false;
+					}
+					mPage.mTexture = gl::Texture(mPage.mSurface);
+
+					// Pages are full, so nothing more is packed into them
+					mPage.mSize = mNewPageSize;
+					mPage.mSkyline.push_back(Vec3i(0, mNewPageSize, mNewPageSize));
+					mNewPages.push_back(mPage);
+
+				}
+				else if (mKey == "region")
+				{
+					Region mRegion;
+					int32_t mX1, mY1, mX2, mY2;
+					string mName;
+					mStream >> mRegion.mPage >> mX1 >> mY1 >> mX2 >> mY2;
+					getline(mStream >> ws, mName);
+					if (mStream.fail() || mRegion.mPage < 0 || mRegion.mPage >= (int32_t)mNewPages.size())
+					{
+						console() << "Invalid atlas region in \"" << path << "\"\n";
+						return false;
+					}
+					mRegion.mArea = Area(mX1, mY1, mX2, mY2);
+					mNewRegions[mName] = mRegion;
+				}
+			}
+
+			// Swap in loaded atlas
+			mPageSize = mNewPageSize;
+			mPadding = mNewPadding;
+			mPages = mNewPages;
+			mRegions = mNewRegions;
+			mPending.clear();
+			return true;
+
+		}
+
+		// Getters
+		Area getArea(const string & name) 
+		{
+			map<string, Region>::iterator mRegion = mRegions.find(name);
+			return mRegion == mRegions.end() ? Area() : mRegion->second.mArea;
+		}
+		gl::Texture getPage(int32_t index) { return index >= 0 && index < (int32_t)mPages.size() ? mPages[index].mTexture : gl::Texture(); }
+		int32_t getPageCount() { return (int32_t)mPages.size(); }
+		int32_t getPageIndex(const string & name)
+		{
+			map<string, Region>::iterator mRegion = mRegions.find(name);
+			return mRegion == mRegions.end() ? -1 : mRegion->second.mPage;
+		}
+		int32_t getPageSize() { return mPageSize; }
+		gl::Texture getTexture(const string & name)
+		{
+			map<string, Region>::iterator mRegion = mRegions.find(name);
+			return mRegion == mRegions.end() ? gl::Texture() : mPages[mRegion->second.mPage].mTexture;
+		}
+		bool hasRegion(const string & name) { return mRegions.find(name) != mRegions.end(); }
+
+	private:
+
+		// Index file version
+		static const int32_t VERSION = 1;
+
+		// Queued image
+		typedef pair<string, Surface> Pending;
+
+		// Sorts queue by height, then width, descending
+		static bool isTaller(const Pending & a, const Pending & b)
+		{
+			if (a.second.getHeight() != b.second.getHeight())
+				return a.second.getHeight() > b.second.getHeight();
+			return a.second.getWidth() > b.second.getWidth();
+		}
+
+		// Packed image
+		struct Region
+		{
+			Region() : mPage(0) {}
+			Area mArea;
+			int32_t mPage;
+		};
+
+		// A texture and its skyline, a list of horizontal 
+		// segments (x, top, width) covering the page
+		struct Page
+		{
+
+			Page(int32_t size)
+			{
+				if (size > 0)
+				{
+					mSurface = Surface(size, size, true);
+					memset(mSurface.getData(), 0, mSurface.getRowBytes() * size);
+					mSkyline.push_back(Vec3i(0, 0, size));
+				}
+				mSize = size;
+			}
+
+			// Finds lowest, then leftmost, position for a rectangle
+			bool find(int32_t width, int32_t height, Vec2i & position)
+			{
+				int32_t mBestY = numeric_limits<int32_t>::max();
+				int32_t mBestX = 0;
+				for (size_t i = 0; i < mSkyline.size(); i++)
+				{
+
+					// Rectangle rests on the highest segment it spans
+					int32_t mX = mSkyline[i].x;
+					if (mX + width > mSize)
+						break;
+					int32_t mY = 0;
+					int32_t mRemaining = width;
+					for (size_t j = i; j < mSkyline.size() && mRemaining > 0; j++)
+					{
+						mY = math<int32_t>::max(mY, mSkyline[j].y);
+						mRemaining -= mSkyline[j].z;
+					}
+					if (mY + height <= mSize && mY < mBestY)
+					{
+						mBestY = mY;
+						mBestX = mX;
+					}
+
+				}
+				if (mBestY == numeric_limits<int32_t>::max())
+					return false;
+				position = Vec2i(mBestX, mBestY);
+				return true;
+			}
+
+			// Raises skyline under a placed rectangle
+			void place(const Vec2i & position, int32_t width, int32_t height)
+			{
+
+				// Insert new segment
+				Vec3i mSegment(position.x, position.y + height, width);
+				size_t mIndex = 0;
+				while (mIndex < mSkyline.size() && mSkyline[mIndex].x < position.x)
+					mIndex++;
+				mSkyline.insert(mSkyline.begin() + mIndex, mSegment);
+
+				// Trim or remove segments it covers
+				int32_t mRight = position.x + width;
+				size_t i = mIndex + 1;
+				while (i < mSkyline.size() && mSkyline[i].x < mRight)
+				{
+					int32_t mSegmentRight = mSkyline[i].x + mSkyline[i].z;
+					if (mSegmentRight <= mRight)
+					{
+						mSkyline.erase(mSkyline.begin() + i);
+					}
+					else
+					{
+						mSkyline[i].z = mSegmentRight - mRight;
+						mSkyline[i].x = mRight;
+						break;
+					}
+				}
+
+				// Merge neighbors at the same height
+				for (size_t j = 0; j + 1 < mSkyline.size();)
+				{
+					if (mSkyline[j].y == mSkyline[j + 1].y)
+					{
+						mSkyline[j].z += mSkyline[j + 1].z;
+						mSkyline.erase(mSkyline.begin() + j + 1);
+					}
+					else
+					{
+						j++;
+					}
+				}
+
+			}
+
+			int32_t mSize;
+			vector<Vec3i> mSkyline;
+			Surface mSurface;
+			gl::Texture mTexture;
+
+		};
+
+		// Pages, regions and queued images
+		vector<Page> mPages;
+		vector<Pending> mPending;
+		map<string, Region> mRegions;
+
+		// Dimensions
+		int32_t mPadding;
+		int32_t mPageSize;
+
+	};
+
+	// Pointer to object
+	std::shared_ptr<Obj> mObj;
+
+public:
+
+	// Con/de-structor
+	SpriteAtlas(int32_t pageSize = 2048, int32_t padding = 1) : mObj(std::shared_ptr<Obj>(new Obj(pageSize, padding))) {}
+	~SpriteAtlas() { mObj.reset(); }
+
+	// Queues image for packing
+	void add(const string & name, const Surface & surface) { mObj->add(name, surface); }
+
+	// Packs queued images into pages and uploads them
+	void pack() { mObj->pack(); }
+
+	// Saves atlas as an index file plus one PNG per page 
+	// ("<path>.0.png", "<path>.1.png", ...)
+	bool save(const string & path) { return mObj->save(path); }
+
+	// Loads atlas written by save(), replacing this one
+	bool load(const string & path) { return mObj->load(path); }
+
+	// Creates sprite showing named image at position
+	Sprite createSprite(const string & name, const Vec2i & position, const ColorAf & color = ColorAf::white())
+	{
+		Area mArea = mObj->getArea(name);
+		return Sprite(mObj->getTexture(name), mArea, Area(position, position + mArea.getSize()), color);
+	}
+
+	// Getters
+	Area getArea(const string & name) { return mObj->getArea(name); }
+	gl::Texture getPage(int32_t index) { return mObj->getPage(index); }
+	int32_t getPageCount() { return mObj->getPageCount(); }
+	int32_t getPageIndex(const string & name) { return mObj->getPageIndex(name); }
+	int32_t getPageSize() { return mObj->getPageSize(); }
+	gl::Texture getTexture(const string & name) { return mObj->getTexture(name); }
+	bool hasRegion(const string & name) { return mObj->hasRegion(name); }
+
+};
@@ -39,7 +39,11 @@
 // Includes
 #include "cinder/Cinder.h"
 #include "Sprite.h"
-#include <map>
+#include "SpriteGrid.h"
+#include "SpriteRenderer.h"
+#include "SpriteStore.h"
+#include <algorithm>
+#include <vector>
 
 // Imports
 using namespace ci;
@@ -52,56 +56,465 @@ class SpriteBatch
 public:
 
 	// Aliases
-	typedef map<int32_t, Sprite> SpriteList;
+	typedef vector<Sprite> SpriteList;
 
 	// Con/de-structor
-	SpriteBatch() {}
+	SpriteBatch(float cellSize = 128.0f) : mCulling(false), mGrid(cellSize), mSequence(0), mStore(SpriteStore::create()) {}
 	~SpriteBatch() {}
 
-	// Adds sprite to list and set its ID
-	void insert(const Sprite & sprite)
+	// Adds sprite to list and sets its ID. A sprite may 
+	// only be in one batch at a time.
+	int32_t insert(const Sprite & sprite)
 	{
-		int32_t mSpriteId = mSpriteList.empty() ? 0 : mSpriteList.rbegin()->first + 1;
-		sprite.setId(mSpriteId);
-		mSpriteList.insert(make_pair(mSpriteId, sprite));
+
+		// Bail if sprite is empty or already in a batch
+		if (!sprite.mObj || sprite.mObj->getStore())
+			return sprite.getId();
+
+		// Move sprite's properties into store
+		int32_t mSpriteId = sprite.mObj->bind(mStore);
+		if (mSpriteId == SpriteStore::NO_ID)
+			return mSpriteId;
+		mSprites.push_back(sprite);
+		mDrawPositions.push_back(UNPLACED);
+		setSequence(mSpriteId);
+		return mSpriteId;
+
+	}
+
+	// Adds sprite without a Sprite object, for sprites that come and go 
+	// too quickly to be worth one. Address it by the returned ID.
+	int32_t insert(const gl::Texture & texture, const Area & source, const Rectf & rect, const ColorAf & color = ColorAf::white(), int32_t layer = 0, float depth = 0.0f)
+	{
+
+		// DO IT!
+		int32_t mSpriteId = mStore.insert(texture, source, texture ? texture.getAreaTexCoords(source) : Rectf(), rect, color, 1.0f, true, layer, depth);
+		if (mSpriteId == SpriteStore::NO_ID)
+			return mSpriteId;
+		mSprites.push_back(Sprite());
+		mDrawPositions.push_back(UNPLACED);
+		setSequence(mSpriteId);
+		return mSpriteId;
+
 	}
 
 	// Adds vector of sprites to list and set their IDs
 	void insert(const vector<Sprite> & sprites)
 	{
+		reserve(size() + (int32_t)sprites.size());
 		for (vector<Sprite>::const_iterator mSprite = sprites.begin(); mSprite != sprites.end(); ++mSprite)
-		{
-			int32_t mSpriteId = mSpriteList.empty() ? 0 : mSpriteList.rbegin()->first + 1;
-			mSprite->setId(mSpriteId);
-			mSpriteList.insert(make_pair(mSpriteId, (* mSprite)));
-		}
+			insert(* mSprite);
 	}
 
 	// Remove sprite from list and reset its ID
 	void erase(const Sprite & sprite)
 	{
-		mSpriteList.erase(mSpriteList.find(sprite.getId()));
-		sprite.setId(-numeric_limits<int32_t>::max());
+
+		// Bail if sprite isn't in this batch
+		if (!sprite.mObj || sprite.mObj->getStore() != mStore)
+			return;
+
+		// Copy properties back to sprite, then remove them
+		int32_t mSpriteId = sprite.getId();
+		sprite.mObj->unbind();
+		erase(mSpriteId);
+
+	}
+
+	// Removes sprite by ID. Stale IDs are ignored.
+	void erase(int32_t id)
+	{
+
+		// Bail if sprite isn't in this batch
+		int32_t mIndex = mStore.getIndex(id);
+		if (mIndex < 0)
+			return;
+
+		// Detach sprite object, if any
+		if (mSprites[mIndex].mObj && mSprites[mIndex].mObj->getStore())
+			mSprites[mIndex].mObj->unbind();
+
+		// Take sprite out of draw order
+		removeOrder(mIndex);
+
+		// The last sprite moves into the gap, so mirror that here
+		mGrid.remove(id);
+		mStore.erase(id);
+		mSprites[mIndex] = mSprites.back();
+		mSprites.pop_back();
+
+	}
+
+	// Removes vectors of sprites
+	void erase(const vector<Sprite> & sprites)
+	{
+		for (vector<Sprite>::const_iterator mSprite = sprites.begin(); mSprite != sprites.end(); ++mSprite)
+			erase(* mSprite);
+	}
+	void erase(const vector<int32_t> & ids)
+	{
+		for (vector<int32_t>::const_iterator mId = ids.begin(); mId != ids.end(); ++mId)
+			erase(* mId);
+	}
+
+	// True if ID refers to a sprite in this batch
+	bool contains(int32_t id) const { return mStore.contains(id); }
+
+	// Grows storage to hold count sprites without reallocating
+	void reserve(int32_t count)
+	{
+		mStore.reserve(count);
+		mSprites.reserve((size_t)count);
+		mDrawOrder.reserve((size_t)count);
+		mDrawPositions.reserve((size_t)count);
+		mOrderKeys.reserve((size_t)count);
+		mSequences.reserve((size_t)count);
 	}
 
 	// Clear list
 	void clear() 
 	{
-		for (SpriteList::iterator mSprite = mSpriteList.begin(); mSprite != mSpriteList.end(); ++mSprite)
-			mSprite->second.setId(-numeric_limits<int32_t>::max());
-		mSpriteList.clear(); 
+		for (SpriteList::iterator mSprite = mSprites.begin(); mSprite != mSprites.end(); ++mSprite)
+			if (mSprite->mObj)
+				mSprite->mObj->unbind();
+		mSprites.clear();
+		mStore.clear();
+		mDrawOrder.clear();
+		mDrawPositions.clear();
+		mOrderKeys.clear();
+		mGrid.clear();
+		mSequences.clear();
+		mSequence = 0;
 	}
 
-	// Draw sprites
+	// Draw sprites by layer, then depth, then insertion order, 
+	// whatever their textures. Sprites sharing a texture share 
+	// draw calls where that doesn't change what's on top. If 
+	// culling is on, only sprites overlapping the cull rect 
+	// are drawn.
 	void draw()
 	{
-		for (SpriteList::iterator mSprite = mSpriteList.begin(); mSprite != mSpriteList.end(); ++mSprite)
-			mSprite->second.draw();
+
+		// Bring draw order up to date
+		updateOrder();
+
+		// Batch visible sprites, in view if culling. The 
+		// renderer keeps their order, so layers need no 
+		// special care.
+		const vector<float> & mAlphas = mStore.getAlphas();
+		const vector<Vec2f> & mPositions = mStore.getPositions();
+		const vector<Vec2f> & mSizes = mStore.getSizes();
+		const vector<uint8_t> & mVisible = mStore.getVisible();
+		mRenderer.begin();
+		for (vector<int32_t>::const_iterator mIndex = mDrawOrder.begin(); mIndex != mDrawOrder.end(); ++mIndex)
+		{
+			int32_t i = * mIndex;
+			if (i < 0 || mVisible[i] == 0 || mAlphas[i] <= 0.0f)
+				continue;
+			if (mCulling && !Rectf(mPositions[i], mPositions[i] + mSizes[i]).intersects(mCullRect))
+				continue;
+			add(i);
+		}
+		mRenderer.draw();
+
+	}
+
+	// Returns ID of topmost visible sprite containing 
+	// point, or SpriteStore::NO_ID if there is none
+	int32_t pick(const Vec2f & point)
+	{
+		updateGrid();
+		return pickCell(point);
+	}
+
+	// Picks many points at once, eg, every active touch. 
+	// ids receives one result per point.
+	void pick(const vector<Vec2f> & points, vector<int32_t> & ids)
+	{
+		updateGrid();
+		ids.resize(points.size());
+		for (size_t i = 0; i < points.size(); i++)
+			ids[i] = pickCell(points[i]);
 	}
 
+	// Appends IDs of visible sprites overlapping rect to ids, 
+	// topmost first, or in draw order if topmostFirst is false
+	void query(const Rectf & rect, vector<int32_t> & ids, bool topmostFirst = true)
+	{
+
+		// Bring grid up to date
+		updateGrid();
+
+		// Gather candidates and keep those that overlap
+		size_t mStart = ids.size();
+		mGrid.gather(rect, ids);
+		const vector<Vec2f> & mPositions = mStore.getPositions();
+		const vector<Vec2f> & mSizes = mStore.getSizes();
+		const vector<uint8_t> & mVisible = mStore.getVisible();
+		vector<int32_t>::iterator mEnd = ids.begin() + mStart;
+		for (vector<int32_t>::iterator mId = ids.begin() + mStart; mId != ids.end(); ++mId)
+		{
+			int32_t i = mStore.getIndex(* mId);
+			if (i < 0)
+				continue;
+			if (mVisible[i] != 0 && Rectf(mPositions[i], mPositions[i] + mSizes[i]).intersects(rect))
+				* mEnd++ = * mId;
+		}
+		ids.erase(mEnd, ids.end());
+
+		// Sort by draw order
+		mKeys.clear();
+		for (vector<int32_t>::const_iterator mId = ids.begin() + mStart; mId != ids.end(); ++mId)
+			mKeys.push_back(getKey(* mId));
+		sort(mKeys.begin(), mKeys.end());
+		for (size_t i = 0; i < mKeys.size(); i++)
+			ids[mStart + i] = mKeys[topmostFirst ? mKeys.size() - 1 - i : i].mId;
+
+	}
+
+	// Swaps texture of sprite by ID
+	void setTexture(int32_t id, const gl::Texture & texture, const Area & source)
+	{
+		if (mStore.contains(id))
+			mStore.setTexture(id, texture, source, texture ? texture.getAreaTexCoords(source) : Rectf());
+	}
+
+	// Draw order keys. Changes take effect on the next draw(), 
+	// which moves only the sprites that changed.
+	void setDepth(int32_t id, float depth) { mStore.setDepth(id, depth); }
+	void setLayer(int32_t id, int32_t layer) { mStore.setLayer(id, layer); }
+
+	// Cull sprites outside rect when drawing. Use the 
+	// visible area, in the same space as the sprites.
+	void disableCulling() { mCulling = false; }
+	void setCullRect(const Rectf & rect) { mCullRect = rect; mCulling = true; }
+
+	// Number of draw calls made by last draw()
+	int32_t getDrawCount() { return mRenderer.getDrawCount(); }
+
+	// Sprites, in store order. Sprites inserted 
+	// without a Sprite object are empty here.
+	const SpriteList & getSprites() const { return mSprites; }
+
+	// Property arrays and setters for bulk updates. Sprites 
+	// are only added and removed through the batch.
+	SpriteStore & getStore() { return mStore; }
+
+	// Number of sprites
+	int32_t size() const { return (int32_t)mSprites.size(); }
+
 private:
 
-	// The list
-	SpriteList mSpriteList;
+	// Draw order key. Sprites draw by layer, then 
+	// depth, then the order they were inserted.
+	struct OrderKey
+	{
+		bool operator<(const OrderKey & rhs) const
+		{
+			if (mLayer != rhs.mLayer)
+				return mLayer < rhs.mLayer;
+			if (mDepth != rhs.mDepth)
+				return mDepth < rhs.mDepth;
+			return mSequence < rhs.mSequence;
+		}
+		float mDepth;
+		int32_t mId;
+		int32_t mLayer;
+		uint32_t mSequence;
+	};
+
+	// Orders store indices by their sprites' filed keys
+	struct IndexLess
+	{
+		IndexLess(const vector<int32_t> & ids, const vector<OrderKey> & keys) : mIds(ids), mKeys(keys) {}
+		bool operator()(int32_t a, int32_t b) const
+		{
+			return mKeys[mIds[a] & SpriteStore::SLOT_MASK] < mKeys[mIds[b] & SpriteStore::SLOT_MASK];
+		}
+		const vector<int32_t> & mIds;
+		const vector<OrderKey> & mKeys;
+	};
+
+	// Draw positions of sprites not in draw order yet, 
+	// and those waiting to be merged back in
+	enum { UNPLACED = -1, PENDING = -2 };
+
+	// Adds sprite at index to renderer
+	void add(int32_t i)
+	{
+		const vector<Vec2f> & mPositions = mStore.getPositions();
+		mRenderer.add(mStore.getTexture(mStore.getTextureIds()[i]), Rectf(mPositions[i], mPositions[i] + mStore.getSizes()[i]), 
+			mStore.getTexCoords()[i], SpriteStore::getDrawColor(mStore.getColors()[i], mStore.getAlphas()[i]));
+	}
+
+	// Current draw order key for sprite
+	OrderKey getKey(int32_t id)
+	{
+		int32_t mIndex = mStore.getIndex(id);
+		OrderKey mKey;
+		mKey.mDepth = mStore.getDepths()[mIndex];
+		mKey.mId = id;
+		mKey.mLayer = mStore.getLayers()[mIndex];
+		mKey.mSequence = mSequences[id & SpriteStore::SLOT_MASK];
+		return mKey;
+	}
+
+	// Picks from an up-to-date grid
+	int32_t pickCell(const Vec2f & point)
+	{
+		int32_t mTopId = SpriteStore::NO_ID;
+		OrderKey mTopKey;
+		const vector<Vec2f> & mPositions = mStore.getPositions();
+		const vector<Vec2f> & mSizes = mStore.getSizes();
+		const vector<uint8_t> & mVisible = mStore.getVisible();
+		const vector<int32_t> & mCandidates = mGrid.gather(point);
+		for (vector<int32_t>::const_iterator mId = mCandidates.begin(); mId != mCandidates.end(); ++mId)
+		{
+			int32_t i = mStore.getIndex(* mId);
+			if (i < 0 || mVisible[i] == 0 || !Rectf(mPositions[i], mPositions[i] + mSizes[i]).contains(point))
+				continue;
+			OrderKey mKey = getKey(* mId);
+			if (mTopId == SpriteStore::NO_ID || mTopKey < mKey)
+			{
+				mTopId = * mId;
+				mTopKey = mKey;
+			}
+		}
+		return mTopId;
+	}
+
+	// Records insertion order, by slot
+	void setSequence(int32_t id)
+	{
+		int32_t mSlot = id & SpriteStore::SLOT_MASK;
+		if (mSlot >= (int32_t)mSequences.size())
+			mSequences.resize((size_t)mSlot + 1, 0);
+		mSequences[mSlot] = mSequence++;
+	}
+
+	// Takes sprite at index out of draw order, leaving a gap, and 
+	// mirrors the store moving the last sprite into its place
+	void removeOrder(int32_t index)
+	{
+		int32_t mLast = (int32_t)mDrawPositions.size() - 1;
+		if (mDrawPositions[index] >= 0)
+			mDrawOrder[mDrawPositions[index]] = -1;
+		if (index != mLast)
+		{
+			int32_t mPosition = mDrawPositions[mLast];
+			if (mPosition >= 0)
+				mDrawOrder[mPosition] = index;
+			mDrawPositions[index] = mPosition;
+		}
+		mDrawPositions.pop_back();
+	}
+
+	// Moves sprites that were inserted or re-layered since last 
+	// draw to their new place in draw order. Changed sprites are 
+	// sorted, O(k log k), and merged back in with one pass over 
+	// the rest, which also closes gaps left by erased sprites. 
+	// Frames with no changes leave draw order alone.
+	void updateOrder()
+	{
+
+		// Bail if nothing's changed, unless erased 
+		// sprites have left more gaps than sprites
+		mStore.takeOrderChanges(mChanges);
+		if (mChanges.empty() && mDrawOrder.size() <= mDrawPositions.size() * 2)
+			return;
+
+		// Pull changed sprites out, skipping removed sprites, 
+		// those logged more than once and those whose key 
+		// is the same
+		if (mOrderKeys.size() < mSequences.size())
+		{
+			OrderKey mEmpty = { 0.0f, SpriteStore::NO_ID, 0, 0 };
+			mOrderKeys.resize(mSequences.size(), mEmpty);
+		}
+		mPending.clear();
+		for (vector<int32_t>::const_iterator mId = mChanges.begin(); mId != mChanges.end(); ++mId)
+		{
+			int32_t i = mStore.getIndex(* mId);
+			if (i < 0 || mDrawPositions[i] == PENDING)
+				continue;
+			OrderKey mKey = getKey(* mId);
+			OrderKey & mOld = mOrderKeys[(* mId) & SpriteStore::SLOT_MASK];
+			int32_t & mPosition = mDrawPositions[i];
+			if (mPosition >= 0 && !(mOld < mKey) && !(mKey < mOld))
+				continue;
+			if (mPosition >= 0)
+				mDrawOrder[mPosition] = -1;
+			mPosition = PENDING;
+			mOld = mKey;
+			mPending.push_back(i);
+		}
+
+		// Sort changed sprites and merge them into the rest
+		IndexLess mLess(mStore.getIds(), mOrderKeys);
+		sort(mPending.begin(), mPending.end(), mLess);
+		mDrawOrder.erase(remove(mDrawOrder.begin(), mDrawOrder.end(), -1), mDrawOrder.end());
+		mMerged.resize(mDrawOrder.size() + mPending.size());
+		merge(mDrawOrder.begin(), mDrawOrder.end(), mPending.begin(), mPending.end(), mMerged.begin(), mLess);
+		mDrawOrder.swap(mMerged);
+		for (size_t j = 0; j < mDrawOrder.size(); j++)
+			mDrawPositions[mDrawOrder[j]] = (int32_t)j;
+
+	}
+
+	// Files sprites logged as new or moved since last time 
+	// under their current cells, or every sprite if the log 
+	// overflowed. Sprites that haven't left their cells cost 
+	// a compare.
+	void updateGrid()
+	{
+		const vector<Vec2f> & mPositions = mStore.getPositions();
+		const vector<Vec2f> & mSizes = mStore.getSizes();
+		if (mStore.takeMoves(mMoves))
+		{
+			const vector<int32_t> & mIds = mStore.getIds();
+			for (size_t i = 0; i < mIds.size(); i++)
+				mGrid.update(mIds[i], Rectf(mPositions[i], mPositions[i] + mSizes[i]));
+			return;
+		}
+		for (vector<int32_t>::const_iterator mId = mMoves.begin(); mId != mMoves.end(); ++mId)
+		{
+			int32_t i = mStore.getIndex(* mId);
+			if (i >= 0)
+				mGrid.update(* mId, Rectf(mPositions[i], mPositions[i] + mSizes[i]));
+		}
+	}
+
+	// Culling
+	bool mCulling;
+	Rectf mCullRect;
+
+	// Spatial hash for picking, and sprites 
+	// to refile in it
+	SpriteGrid mGrid;
+	vector<int32_t> mMoves;
+
+	// Insertion order by slot, and next one to hand out
+	uint32_t mSequence;
+	vector<uint32_t> mSequences;
+
+	// Sprites, parallel to store
+	SpriteList mSprites;
+
+	// Store indices in draw order, with -1 where a sprite was 
+	// erased, each index's place there, and each slot's key as 
+	// filed. Keys are also sorted here when querying.
+	vector<int32_t> mChanges;
+	vector<int32_t> mDrawOrder;
+	vector<int32_t> mDrawPositions;
+	vector<OrderKey> mKeys;
+	vector<int32_t> mMerged;
+	vector<OrderKey> mOrderKeys;
+	vector<int32_t> mPending;
+
+	// Sprite properties
+	SpriteStore mStore;
+
+	// Batches sprites by texture
+	SpriteRenderer mRenderer;
 
 };
@@ -0,0 +1,274 @@
+/*
+* 
+* Copyright (c) 2011, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/Cinder.h"
+#include "cinder/CinderMath.h"
+#include "cinder/Rect.h"
+#include "SpriteStore.h"
+#include <vector>
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Spatial hash over sprite IDs. Space is divided into square 
+// cells, and each cell hashes to a bucket listing the sprites 
+// that overlap it. Cells are unbounded, so sprites can go 
+// anywhere; distant cells sharing a bucket only cost an extra
+// bounds test.
+class SpriteGrid
+{
+
+private:
+
+	// The object
+	class Obj
+	{
+
+	public:
+
+		// Con/de-structor
+		Obj(float cellSize, int32_t bucketCount) : mStamp(0)
+		{
+
+			// Round bucket count up to a power of two for masking
+			int32_t mCount = 1;
+			while (mCount < bucketCount)
+				mCount <<= 1;
+			mBuckets.resize((size_t)mCount);
+			mBucketMask = mCount - 1;
+			mCellSize = math<float>::max(cellSize, 1.0f);
+
+		}
+		~Obj() {}
+
+		// Removes all sprites
+		void clear()
+		{
+			for (vector<vector<int32_t> >::iterator mBucket = mBuckets.begin(); mBucket != mBuckets.end(); ++mBucket)
+				mBucket->clear();
+			mRanges.clear();
+		}
+
+		// Returns IDs in buckets covering rect. Each ID appears 
+		// once. Results may include sprites outside rect.
+		void gather(const Rectf & rect, vector<int32_t> & ids)
+		{
+
+			// New stamp for de-duplicating
+			mStamp++;
+			Range mRange = getRange(rect);
+
+			// Visit every bucket once if the rect covers more 
+			// cells than there are buckets
+			if ((int64_t)(mRange.x2 - mRange.x1 + 1) * (int64_t)(mRange.y2 - mRange.y1 + 1) >= (int64_t)mBuckets.size())
+			{
+				for (vector<vector<int32_t> >::iterator mBucket = mBuckets.begin(); mBucket != mBuckets.end(); ++mBucket)
+					collect(* mBucket, ids);
+				return;
+			}
+
+			// Visit covered cells
+			for (int32_t y = mRange.y1; y <= mRange.y2; y++)
+				for (int32_t x = mRange.x1; x <= mRange.x2; x++)
+					collect(mBuckets[getBucket(x, y)], ids);
+
+		}
+
+		// Returns IDs in the bucket holding point
+		const vector<int32_t> & gather(const Vec2f & point)
+		{
+			// DO IT!
+			return mBuckets[getBucket(toCell(point.x), toCell(point.y))];
+		}
+
+		// Removes sprite
+		void remove(int32_t id)
+		{
+			int32_t mSlot = id & SpriteStore::SLOT_MASK;
+			if (mSlot < (int32_t)mRanges.size() && mRanges[mSlot].mId == id)
+			{
+				forEachBucket(mRanges[mSlot], id, false);
+				mRanges[mSlot] = Range();
+			}
+		}
+
+		// Adds or moves sprite, touching buckets only if 
+		// its cells have changed
+		void update(int32_t id, const Rectf & rect)
+		{
+
+			// Grow slot table
+			int32_t mSlot = id & SpriteStore::SLOT_MASK;
+			if (mSlot >= (int32_t)mRanges.size())
+				mRanges.resize((size_t)mSlot + 1);
+
+			// Bail if cells are unchanged
+			Range mRange = getRange(rect);
+			Range & mCurrent = mRanges[mSlot];
+			if (mCurrent.mId == id && mCurrent == mRange)
+				return;
+
+			// Move sprite to new cells
+			if (mCurrent.mId == id)
+				forEachBucket(mCurrent, id, false);
+			forEachBucket(mRange, id, true);
+			mRange.mId = id;
+			mRange.mStamp = mCurrent.mStamp;
+			mCurrent = mRange;
+
+		}
+
+		// Getters
+		float getCellSize() { return mCellSize; }
+
+	private:
+
+		// Cells covered by a sprite
+		struct Range
+		{
+			Range() : mId(SpriteStore::NO_ID), mStamp(0), x1(0), y1(0), x2(-1), y2(-1) {}
+			bool operator==(const Range & rhs) const { return x1 == rhs.x1 && y1 == rhs.y1 && x2 == rhs.x2 && y2 == rhs.y2; }
+			int32_t mId;
+			uint32_t mStamp;
+			int32_t x1;
+			int32_t y1;
+			int32_t x2;
+			int32_t y2;
+		};
+
+		// Appends IDs not yet seen this stamp
+		void collect(const vector<int32_t> & bucket, vector<int32_t> & ids)
+		{
+			for (vector<int32_t>::const_iterator mId = bucket.begin(); mId != bucket.end(); ++mId)
+			{
+				Range & mSeen = mRanges[(* mId) & SpriteStore::SLOT_MASK];
+				if (mSeen.mStamp != mStamp)
+				{
+					mSeen.mStamp = mStamp;
+					ids.push_back(* mId);
+				}
+			}
+		}
+
+		// Adds ID to, or removes it from, buckets 
+		// covering range, visiting each bucket once
+		void forEachBucket(const Range & range, int32_t id, bool add)
+		{
+			mStamp++;
+			for (int32_t y = range.y1; y <= range.y2; y++)
+			{
+				for (int32_t x = range.x1; x <= range.x2; x++)
+				{
+					size_t mIndex = getBucket(x, y);
+					if (mVisited.size() < mBuckets.size())
+						mVisited.resize(mBuckets.size(), 0);
+					if (mVisited[mIndex] == mStamp)
+						continue;
+					mVisited[mIndex] = mStamp;
+					vector<int32_t> & mBucket = mBuckets[mIndex];
+					if (add)
+					{
+						mBucket.push_back(id);
+					}
+					else
+					{
+						for (size_t i = 0; i < mBucket.size(); i++)
+						{
+							if (mBucket[i] == id)
+							{
+								mBucket[i] = mBucket.back();
+								mBucket.pop_back();
+								break;
+							}
+						}
+					}
+				}
+			}
+		}
+
+		// Cell math
+		size_t getBucket(int32_t x, int32_t y) { return (size_t)(((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u)) & (size_t)mBucketMask; }
+		Range getRange(const Rectf & rect)
+		{
+			Range mRange;
+			mRange.x1 = toCell(math<float>::min(rect.x1, rect.x2));
+			mRange.y1 = toCell(math<float>::min(rect.y1, rect.y2));
+			mRange.x2 = toCell(math<float>::max(rect.x1, rect.x2));
+			mRange.y2 = toCell(math<float>::max(rect.y1, rect.y2));
+			return mRange;
+		}
+		int32_t toCell(float value) { return (int32_t)math<float>::floor(value / mCellSize); }
+
+		// Buckets of IDs
+		vector<vector<int32_t> > mBuckets;
+		int32_t mBucketMask;
+		float mCellSize;
+
+		// Cells covered by each slot's sprite
+		vector<Range> mRanges;
+
+		// Marks for de-duplicating
+		uint32_t mStamp;
+		vector<uint32_t> mVisited;
+
+	};
+
+	// Pointer to object
+	std::shared_ptr<Obj> mObj;
+
+public:
+
+	// Con/de-structor
+	SpriteGrid(float cellSize = 128.0f, int32_t bucketCount = 4096) : mObj(std::shared_ptr<Obj>(new Obj(cellSize, bucketCount))) {}
+	~SpriteGrid() { mObj.reset(); }
+
+	// Maintenance
+	void clear() { mObj->clear(); }
+	void remove(int32_t id) { mObj->remove(id); }
+	void update(int32_t id, const Rectf & rect) { mObj->update(id, rect); }
+
+	// Candidate IDs near a point or rect. Test bounds to be sure.
+	const vector<int32_t> & gather(const Vec2f & point) { return mObj->gather(point); }
+	void gather(const Rectf & rect, vector<int32_t> & ids) { mObj->gather(rect, ids); }
+
+	// Getters
+	float getCellSize() { return mObj->getCellSize(); }
+
+};
@@ -0,0 +1,443 @@
+/*
+* 
+* Copyright (c) 2011, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/app/App.h"
+#include "cinder/Cinder.h"
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Texture.h"
+#include "cinder/gl/Vbo.h"
+#include "cinder/ImageIo.h"
+#include "cinder/Surface.h"
+#include "cinder/Thread.h"
+#include "cinder/Timer.h"
+#include <cstring>
+#include <deque>
+#include <map>
+#include "Sprite.h"
+#include "SpriteStore.h"
+#include <string>
+#include <vector>
+
+// Imports
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Loads sprite textures in the background. Images are decoded on 
+// worker threads, then uploaded through a pixel buffer object a 
+// slice at a time in update(), which stops once its time budget 
+// is spent. Sprites show a placeholder texture until their image 
+// is ready. Each path is loaded once and shared.
+class SpriteLoader
+{
+
+private:
+
+	// Image states
+	enum
+	{
+		STATE_DECODING, 
+		STATE_UPLOADING, 
+		STATE_READY, 
+		STATE_FAILED
+	};
+
+	// Sprite waiting on an image. Either a Sprite 
+	// object, or an ID in a store.
+	struct Target
+	{
+		Target() : mId(SpriteStore::NO_ID) {}
+		int32_t mId;
+		Sprite mSprite;
+		SpriteStore mStore;
+	};
+
+	// Image and the sprites waiting on it
+	struct Entry
+	{
+		Entry() : mRow(0), mState(STATE_DECODING) {}
+		int32_t mRow;
+		int32_t mState;
+		Surface8u mSurface;
+		vector<Target> mTargets;
+		gl::Texture mTexture;
+	};
+
+	// Output of a worker
+	struct Decoded
+	{
+		string mPath;
+		Surface8u mSurface;
+	};
+
+	// The object
+	class Obj
+	{
+
+	public:
+
+		// Con/de-structor
+		Obj(int32_t threadCount) : mExit(false), mPendingCount(0), mSliceSize(262144)
+		{
+
+			// Leave a core for the main thread
+			if (threadCount <= 0)
+				threadCount = math<int32_t>::max((int32_t)thread::hardware_concurrency() - 1, 1);
+			for (int32_t i = 0; i < threadCount; i++)
+				mWorkers.push_back(std::shared_ptr<thread>(new thread(&SpriteLoader::Obj::decode, this)));
+
+		}
+		~Obj()
+		{
+
+			// Stop workers. Images being decoded are finished first.
+			{
+				lock_guard<mutex> mLock(mMutex);
+				mExit = true;
+			}
+			mWake.notify_all();
+			for (vector<std::shared_ptr<thread> >::iterator mWorker = mWorkers.begin(); mWorker != mWorkers.end(); ++mWorker)
+				(* mWorker)->join();
+
+		}
+
+		// Creates sprite showing placeholder until image loads
+		Sprite createSprite(const string & path, const Area & area, const ColorAf & color)
+		{
+			Sprite mSprite(getPlaceholder(), area, color);
+			load(path, mSprite);
+			return mSprite;
+		}
+
+		// Loads image into Sprite object
+		void load(const string & path, const Sprite & sprite)
+		{
+			Target mTarget;
+			mTarget.mSprite = sprite;
+			request(path, mTarget);
+		}
+
+		// Loads image into sprite in store
+		void load(const string & path, const SpriteStore & store, int32_t id)
+		{
+			Target mTarget;
+			mTarget.mId = id;
+			mTarget.mStore = store;
+			request(path, mTarget);
+		}
+
+		// Uploads decoded images until budget runs out
+		void update(double budget)
+		{
+
+			// Start clock
+			Timer mTimer;
+			mTimer.start();
+
+			// Collect decoded images
+			{
+				lock_guard<mutex> mLock(mMutex);
+				while (!mDecoded.empty())
+				{
+					Decoded & mDecodedImage = mDecoded.front();
+					map<string, Entry>::iterator mEntry = mEntries.find(mDecodedImage.mPath);
+					if (mEntry != mEntries.end())
+					{
+						if (mDecodedImage.mSurface)
+						{
+							mEntry->second.mSurface = mDecodedImage.mSurface;
+							mEntry->second.mState = STATE_UPLOADING;
+							mUploads.push_back(mDecodedImage.mPath);
+						}
+						else
+						{
+							finish(mEntry->second, STATE_FAILED);
+						}
+					}
+					mDecoded.pop_front();
+				}
+			}
+
+			// Upload slices. Always do one so loading can't stall.
+			bool mFirst = true;
+			while (!mUploads.empty() && (mFirst || mTimer.getSeconds() < budget))
+			{
+				Entry & mEntry = mEntries[mUploads.front()];
+				if (upload(mEntry))
+				{
+					finish(mEntry, STATE_READY);
+					mUploads.pop_front();
+				}
+				mFirst = false;
+			}
+
+		}
+
+		// Get/set
+		int32_t getPendingCount() { return mPendingCount; }
+		const gl::Texture & getPlaceholder()
+		{
+
+			// Make a clear pixel if none is set
+			if (!mPlaceholder)
+			{
+				Surface8u mSurface(1, 1, true, SurfaceChannelOrder::RGBA);
+				memset(mSurface.getData(), 0, 4);
+				mPlaceholder = gl::Texture(mSurface);
+			}
+			return mPlaceholder;
+
+		}
+		gl::Texture getTexture(const string & path)
+		{
+			map<string, Entry>::iterator mEntry = mEntries.find(path);
+			return mEntry != mEntries.end() && mEntry->second.mState == STATE_READY ? mEntry->second.mTexture : gl::Texture();
+		}
+		bool isLoaded(const string & path)
+		{
+			map<string, Entry>::iterator mEntry = mEntries.find(path);
+			return mEntry != mEntries.end() && mEntry->second.mState == STATE_READY;
+		}
+		void setPlaceholder(const gl::Texture & texture) { mPlaceholder = texture; }
+		void setSliceSize(int32_t bytes) { mSliceSize = math<int32_t>::max(bytes, 1); }
+
+	private:
+
+		// Gives target its texture
+		static void apply(const Target & target, const gl::Texture & texture)
+		{
+			Area mBounds = texture.getCleanBounds();
+			if (target.mStore)
+			{
+				SpriteStore mStore = target.mStore;
+				mStore.setTexture(target.mId, texture, mBounds, texture.getAreaTexCoords(mBounds));
+			}
+			else
+			{
+				target.mSprite.setTexture(texture, mBounds);
+			}
+		}
+
+		// Worker thread loop
+		void decode()
+		{
+			while (true)
+			{
+
+				// Wait for a path
+				string mPath;
+				{
+					unique_lock<mutex> mLock(mMutex);
+					while (!mExit && mQueue.empty())
+						mWake.wait(mLock);
+					if (mExit)
+						return;
+					mPath = mQueue.front();
+					mQueue.pop_front();
+				}
+
+				// Decode, converting to RGBA so uploads need no swizzle
+				Decoded mDecodedImage;
+				mDecodedImage.mPath = mPath;
+				try
+				{
+					Surface8u mSurface(loadImage(mPath));
+					if (!mSurface.hasAlpha() || mSurface.getChannelOrder().getCode() != SurfaceChannelOrder::RGBA)
+					{
+						Surface8u mRgba(mSurface.getWidth(), mSurface.getHeight(), true, SurfaceChannelOrder::RGBA);
+						mRgba.copyFrom(mSurface, mSurface.getBounds());
+						mSurface = mRgba;
+					}
+					mDecodedImage.mSurface = mSurface;
+				}
+				catch (...)
+				{
+					console() << "Unable to load image: " << mPath << "\n";
+				}
+
+				// Hand back to main thread
+				lock_guard<mutex> mLock(mMutex);
+				mDecoded.push_back(mDecodedImage);
+
+			}
+		}
+
+		// Applies result to waiting sprites
+		void finish(Entry & entry, int32_t state)
+		{
+			entry.mState = state;
+			entry.mSurface = Surface8u();
+			if (state == STATE_READY)
+				for (vector<Target>::const_iterator mTarget = entry.mTargets.begin(); mTarget != entry.mTargets.end(); ++mTarget)
+					apply(* mTarget, entry.mTexture);
+			entry.mTargets.clear();
+			mPendingCount--;
+		}
+
+		// Queues target for image
+		void request(const string & path, const Target & target)
+		{
+
+			// Start loading new paths
+			map<string, Entry>::iterator mEntry = mEntries.find(path);
+			if (mEntry == mEntries.end())
+			{
+				mEntry = mEntries.insert(make_pair(path, Entry())).first;
+				mPendingCount++;
+				{
+					lock_guard<mutex> mLock(mMutex);
+					mQueue.push_back(path);
+				}
+				mWake.notify_one();
+			}
+
+			// Apply now if ready, otherwise wait
+			if (mEntry->second.mState == STATE_READY)
+				apply(target, mEntry->second.mTexture);
+			else if (mEntry->second.mState != STATE_FAILED)
+				mEntry->second.mTargets.push_back(target);
+
+		}
+
+		// Uploads next slice of rows. Returns true when done.
+		bool upload(Entry & entry)
+		{
+
+			// Allocate texture on first slice
+			int32_t mWidth = entry.mSurface.getWidth();
+			int32_t mHeight = entry.mSurface.getHeight();
+			if (!entry.mTexture)
+			{
+				gl::Texture::Format mFormat;
+				mFormat.setInternalFormat(GL_RGBA);
+				entry.mTexture = gl::Texture(mWidth, mHeight, mFormat);
+				entry.mRow = 0;
+			}
+
+			// Size slice
+			int32_t mRowBytes = mWidth * 4;
+			int32_t mRows = math<int32_t>::min(math<int32_t>::max(mSliceSize / mRowBytes, 1), mHeight - entry.mRow);
+			size_t mSize = (size_t)mRows * (size_t)mRowBytes;
+
+			// Orphan and fill buffer, then copy from it into 
+			// the texture. Upload straight from the surface if 
+			// the buffer can't be mapped.
+			if (!mBuffer)
+				mBuffer = gl::Vbo(GL_PIXEL_UNPACK_BUFFER);
+			mBuffer.bind();
+			mBuffer.bufferData(mSize, 0, GL_STREAM_DRAW);
+			uint8_t * mData = mBuffer.map(GL_WRITE_ONLY);
+			entry.mTexture.bind();
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			if (mData != 0)
+			{
+				for (int32_t i = 0; i < mRows; i++)
+					memcpy(mData + i * mRowBytes, entry.mSurface.getData(Vec2i(0, entry.mRow + i)), (size_t)mRowBytes);
+				mBuffer.unmap();
+				glTexSubImage2D(entry.mTexture.getTarget(), 0, 0, entry.mRow, mWidth, mRows, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+				mBuffer.unbind();
+			}
+			else
+			{
+				mBuffer.unbind();
+				glPixelStorei(GL_UNPACK_ROW_LENGTH, entry.mSurface.getRowBytes() / 4);
+				glTexSubImage2D(entry.mTexture.getTarget(), 0, 0, entry.mRow, mWidth, mRows, GL_RGBA, GL_UNSIGNED_BYTE, entry.mSurface.getData(Vec2i(0, entry.mRow)));
+				glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+			}
+			entry.mTexture.unbind();
+			entry.mRow += mRows;
+			return entry.mRow >= mHeight;
+
+		}
+
+		// Images by path, and paths being uploaded
+		map<string, Entry> mEntries;
+		int32_t mPendingCount;
+		deque<string> mUploads;
+
+		// Upload settings
+		gl::Vbo mBuffer;
+		gl::Texture mPlaceholder;
+		int32_t mSliceSize;
+
+		// Workers and their queues
+		deque<Decoded> mDecoded;
+		bool mExit;
+		mutex mMutex;
+		deque<string> mQueue;
+		condition_variable mWake;
+		vector<std::shared_ptr<thread> > mWorkers;
+
+	};
+
+	// Pointer to object
+	std::shared_ptr<Obj> mObj;
+
+public:
+
+	// Con/de-structor. A thread count of zero uses 
+	// one decode thread per core, less one.
+	SpriteLoader(int32_t threadCount = 0) : mObj(std::shared_ptr<Obj>(new Obj(threadCount))) {}
+	~SpriteLoader() { mObj.reset(); }
+
+	// Creates a sprite that shows the placeholder until its image loads
+	Sprite createSprite(const string & path, const Area & area, const ColorAf & color = ColorAf::white()) { return mObj->createSprite(path, area, color); }
+
+	// Loads image into an existing sprite, or a sprite by ID. For 
+	// IDs, pass the batch's store. Sprites keep their current 
+	// texture until the image is ready, and their size after.
+	void load(const string & path, const Sprite & sprite) { mObj->load(path, sprite); }
+	void load(const string & path, const SpriteStore & store, int32_t id) { mObj->load(path, store, id); }
+
+	// Uploads decoded images. Call once per frame; budget is 
+	// roughly how many seconds may be spent. At least one 
+	// slice is uploaded per call.
+	void update(double budget = 0.004) { mObj->update(budget); }
+
+	// Getters
+	int32_t getPendingCount() { return mObj->getPendingCount(); }
+	const gl::Texture & getPlaceholder() { return mObj->getPlaceholder(); }
+	gl::Texture getTexture(const string & path) { return mObj->getTexture(path); }
+	bool isLoaded(const string & path) { return mObj->isLoaded(path); }
+
+	// Setters. Slice size is bytes uploaded per step.
+	void setPlaceholder(const gl::Texture & texture) { mObj->setPlaceholder(texture); }
+	void setSliceSize(int32_t bytes) { mObj->setSliceSize(bytes); }
+
+};
@@ -0,0 +1,321 @@
+/*
+* 
+* Copyright (c) 2011, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/Cinder.h"
+#include "cinder/Color.h"
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Texture.h"
+#include "cinder/gl/Vbo.h"
+#include "cinder/Rect.h"
+#include <cstddef>
+#include <vector>
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Draws textured quads in batches. Quads are streamed into one 
+// vertex buffer and drawn in the order they were added. A quad 
+// joins an earlier group with the same texture only if it 
+// overlaps nothing drawn since that group, so sprites sharing a 
+// texture cost a single bind and draw call without changing 
+// what ends up on top.
+class SpriteRenderer
+{
+
+public:
+
+	// Quad corner
+	struct Vertex
+	{
+		Vec2f position;
+		Vec2f texCoord;
+		ColorA8u color;
+	};
+
+private:
+
+	// The object
+	class Obj
+	{
+
+	public:
+
+		// Con/de-structor
+		Obj() : mLayerStart(0), mIndexCapacity(0), mVertexCapacity(0), mDrawCount(0) {}
+		~Obj() {}
+
+		// Clears quads
+		void begin()
+		{
+
+			// DO IT!
+			mGroups.clear();
+			mLayerStart = 0;
+			mQuadGroups.clear();
+			mVertices.clear();
+
+		}
+
+		// Starts a layer. Quads added later won't join 
+		// groups from earlier layers.
+		void nextLayer()
+		{
+			mLayerStart = (int32_t)mGroups.size();
+		}
+
+		// Adds a quad
+		void add(const gl::Texture & texture, const Rectf & destination, const Rectf & texCoords, const ColorAf & color)
+		{
+
+			// Bail if there's nothing to draw
+			if (!texture)
+				return;
+
+			// Walk back through recent groups for one with this 
+			// texture. Joining it draws the quad before every group 
+			// after it, so stop at the first of those it overlaps.
+			GLuint mTextureId = texture.getId();
+			Rectf mBounds = destination.canonicalized();
+			int32_t mGroupId = -1;
+			int32_t mFirst = math<int32_t>::max(mLayerStart, (int32_t)mGroups.size() - LOOK_BACK);
+			for (int32_t i = (int32_t)mGroups.size() - 1; i >= mFirst; i--)
+			{
+				if (mGroups[i].mTextureId == mTextureId)
+				{
+					mGroupId = i;
+					break;
+				}
+				if (mGroups[i].mBounds.intersects(mBounds))
+					break;
+			}
+
+			// Start a group if none fits
+			if (mGroupId < 0)
+			{
+				mGroupId = (int32_t)mGroups.size();
+				mGroups.push_back(Group(texture, mBounds));
+			}
+			else
+			{
+				mGroups[mGroupId].mBounds.include(mBounds);
+			}
+			mGroups[mGroupId].mCount++;
+			mQuadGroups.push_back(mGroupId);
+
+			// Add corners, clockwise from top left
+			ColorA8u mColor(toByte(color.r), toByte(color.g), toByte(color.b), toByte(color.a));
+			Vertex mVertex;
+			mVertex.color = mColor;
+			mVertex.position = Vec2f(destination.x1, destination.y1);
+			mVertex.texCoord = Vec2f(texCoords.x1, texCoords.y1);
+			mVertices.push_back(mVertex);
+			mVertex.position = Vec2f(destination.x2, destination.y1);
+			mVertex.texCoord = Vec2f(texCoords.x2, texCoords.y1);
+			mVertices.push_back(mVertex);
+			mVertex.position = Vec2f(destination.x2, destination.y2);
+			mVertex.texCoord = Vec2f(texCoords.x2, texCoords.y2);
+			mVertices.push_back(mVertex);
+			mVertex.position = Vec2f(destination.x1, destination.y2);
+			mVertex.texCoord = Vec2f(texCoords.x1, texCoords.y2);
+			mVertices.push_back(mVertex);
+
+		}
+
+		// Uploads quads and draws them
+		void draw()
+		{
+
+			// Bail if there's nothing to draw
+			mDrawCount = 0;
+			int32_t mQuadCount = (int32_t)mQuadGroups.size();
+			if (mQuadCount == 0)
+				return;
+
+			// Lay groups out one after another, in the order 
+			// they were started
+			int32_t mOffset = 0;
+			for (vector<Group>::iterator mGroup = mGroups.begin(); mGroup != mGroups.end(); ++mGroup)
+			{
+				mGroup->mOffset = mOffset;
+				mGroup->mCursor = mOffset;
+				mOffset += mGroup->mCount;
+			}
+
+			// Scatter quads into their groups. This is a 
+			// stable counting sort, so order within a group holds.
+			mSorted.resize(mVertices.size());
+			for (int32_t i = 0; i < mQuadCount; i++)
+			{
+				int32_t mTarget = mGroups[mQuadGroups[i]].mCursor++;
+				memcpy(&mSorted[mTarget * 4], &mVertices[i * 4], sizeof(Vertex) * 4);
+			}
+
+			// Grow buffers as needed
+			if (!mVertexBuffer)
+				mVertexBuffer = gl::Vbo(GL_ARRAY_BUFFER);
+			if (!mIndexBuffer)
+				mIndexBuffer = gl::Vbo(GL_ELEMENT_ARRAY_BUFFER);
+			if (mIndexCapacity < mQuadCount)
+			{
+				mIndexCapacity = math<int32_t>::max(mQuadCount, mIndexCapacity * 2);
+				vector<GLuint> mIndices((size_t)mIndexCapacity * 6);
+				for (int32_t i = 0; i < mIndexCapacity; i++)
+				{
+					GLuint mCorner = (GLuint)i * 4;
+					mIndices[i * 6 + 0] = mCorner;
+					mIndices[i * 6 + 1] = mCorner + 1;
+					mIndices[i * 6 + 2] = mCorner + 2;
+					mIndices[i * 6 + 3] = mCorner;
+					mIndices[i * 6 + 4] = mCorner + 2;
+					mIndices[i * 6 + 5] = mCorner + 3;
+				}
+				mIndexBuffer.bind();
+				mIndexBuffer.bufferData(mIndices.size() * sizeof(GLuint), &mIndices[0], GL_STATIC_DRAW);
+			}
+			if (mVertexCapacity < mQuadCount)
+				mVertexCapacity = math<int32_t>::max(mQuadCount, mVertexCapacity * 2);
+
+			// Orphan last frame's storage so the driver doesn't 
+			// stall on it, then stream this frame's vertices
+			size_t mSize = mSorted.size() * sizeof(Vertex);
+			mVertexBuffer.bind();
+			mVertexBuffer.bufferData((size_t)mVertexCapacity * 4 * sizeof(Vertex), 0, GL_STREAM_DRAW);
+			mVertexBuffer.bufferSubData(0, mSize, &mSorted[0]);
+
+			// Point fixed function arrays at buffer
+			mIndexBuffer.bind();
+			glEnableClientState(GL_VERTEX_ARRAY);
+			glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+			glEnableClientState(GL_COLOR_ARRAY);
+			glVertexPointer(2, GL_FLOAT, sizeof(Vertex), (const GLvoid *)offsetof(Vertex, position));
+			glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), (const GLvoid *)offsetof(Vertex, texCoord));
+			glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), (const GLvoid *)offsetof(Vertex, color));
+
+			// One draw per group
+			for (vector<Group>::iterator mGroup = mGroups.begin(); mGroup != mGroups.end(); ++mGroup)
+			{
+				mGroup->mTexture.enableAndBind();
+				glDrawElements(GL_TRIANGLES, mGroup->mCount * 6, GL_UNSIGNED_INT, (const GLvoid *)(mGroup->mOffset * 6 * sizeof(GLuint)));
+				mGroup->mTexture.unbind();
+				mGroup->mTexture.disable();
+				mDrawCount++;
+			}
+
+			// Restore state
+			glDisableClientState(GL_COLOR_ARRAY);
+			glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+			glDisableClientState(GL_VERTEX_ARRAY);
+			mIndexBuffer.unbind();
+			mVertexBuffer.unbind();
+
+		}
+
+		// Getters
+		int32_t getDrawCount() { return mDrawCount; }
+		int32_t getQuadCount() { return (int32_t)mQuadGroups.size(); }
+
+	private:
+
+		// Groups searched for a matching texture. Bounds 
+		// the cost of add() when many textures interleave.
+		static const int32_t LOOK_BACK = 8;
+
+		// Quads sharing a texture, and the area they cover
+		struct Group
+		{
+			Group(const gl::Texture & texture, const Rectf & bounds) : mBounds(bounds), mCount(0), mCursor(0), mOffset(0), mTexture(texture), mTextureId(texture.getId()) {}
+			Rectf mBounds;
+			int32_t mCount;
+			int32_t mCursor;
+			int32_t mOffset;
+			gl::Texture mTexture;
+			GLuint mTextureId;
+		};
+
+		// Converts color channel to byte
+		static uint8_t toByte(float value) { return (uint8_t)(math<float>::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f); }
+
+		// Groups, and the first one in the current layer
+		vector<Group> mGroups;
+		int32_t mLayerStart;
+
+		// Quads in the order they were added, and sorted by group
+		vector<int32_t> mQuadGroups;
+		vector<Vertex> mSorted;
+		vector<Vertex> mVertices;
+
+		// GL buffers and their sizes, in quads
+		gl::Vbo mIndexBuffer;
+		int32_t mIndexCapacity;
+		gl::Vbo mVertexBuffer;
+		int32_t mVertexCapacity;
+
+		// Draw calls made by last draw()
+		int32_t mDrawCount;
+
+	};
+
+	// Pointer to object
+	std::shared_ptr<Obj> mObj;
+
+public:
+
+	// Con/de-structor
+	SpriteRenderer() : mObj(std::shared_ptr<Obj>(new Obj())) {}
+	~SpriteRenderer() { mObj.reset(); }
+
+	// Clears quads for a new frame
+	void begin() { mObj->begin(); }
+
+	// Adds quad, in window coordinates
+	void add(const gl::Texture & texture, const Rectf & destination, const Rectf & texCoords, const ColorAf & color) { mObj->add(texture, destination, texCoords, color); }
+
+	// Keeps quads added after this out of earlier groups, 
+	// eg, where bounds don't tell the whole story
+	void nextLayer() { mObj->nextLayer(); }
+
+	// Draws quads added since begin()
+	void draw() { mObj->draw(); }
+
+	// Getters
+	int32_t getDrawCount() { return mObj->getDrawCount(); }
+	int32_t getQuadCount() { return mObj->getQuadCount(); }
+
+};
@@ -0,0 +1,496 @@
+/*
+* 
+* Copyright (c) 2011, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/Area.h"
+#include "cinder/Cinder.h"
+#include "cinder/Color.h"
+#include "cinder/gl/Texture.h"
+#include "cinder/Rect.h"
+#include <deque>
+#include <limits>
+#include <map>
+#include <vector>
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Dense sprite storage. Each property lives in its own array so 
+// update and draw loops walk contiguous memory. Sprites are 
+// addressed by IDs that stay valid while other sprites come and
+// go; removing a sprite moves the last one into its place. 
+// Adding and removing are O(1) and don't allocate once the 
+// arrays have grown (or been reserved).
+class SpriteStore
+{
+
+public:
+
+	// An ID packs a slot number with the slot's generation, 
+	// so IDs of removed sprites are never mistaken for new ones
+	static const int32_t SLOT_BITS = 20;
+	static const int32_t SLOT_MASK = (1 << SLOT_BITS) - 1;
+	static const int32_t GENERATION_MASK = (1 << (31 - SLOT_BITS)) - 1;
+
+	// ID of a sprite not in any store
+	static const int32_t NO_ID = -0x7fffffff;
+
+private:
+
+	// The object
+	class Obj
+	{
+
+	public:
+
+		// Con/de-structor
+		Obj() : mAllMoved(false) {}
+		~Obj() {}
+
+		// Adds sprite and returns its ID
+		int32_t insert(const gl::Texture & texture, const Area & source, const Rectf & texCoords, const Rectf & rect, const ColorAf & color, float alpha, bool visible, int32_t layer, float depth)
+		{
+
+			// Take the longest-free slot, or add one. Cycling through 
+			// free slots in order puts off generation wrap-around, 
+			// which could let a very old ID match a new sprite.
+			int32_t mSlot;
+			if (!mFreeSlots.empty())
+			{
+				mSlot = mFreeSlots.front();
+				mFreeSlots.pop_front();
+			}
+			else
+			{
+				if ((int32_t)mSlots.size() > SLOT_MASK)
+					return NO_ID;
+				mSlot = (int32_t)mSlots.size();
+				mSlots.push_back(-1);
+				mGenerations.push_back(0);
+			}
+			int32_t mId = (mGenerations[mSlot] << SLOT_BITS) | mSlot;
+
+			// Append properties
+			mSlots[mSlot] = (int32_t)mIds.size();
+			mAlphas.push_back(alpha);
+			mColors.push_back(color);
+			mDepths.push_back(depth);
+			mIds.push_back(mId);
+			mLayers.push_back(layer);
+			mPositions.push_back(Vec2f(rect.x1, rect.y1));
+			mSizes.push_back(Vec2f(rect.getWidth(), rect.getHeight()));
+			mSources.push_back(source);
+			mTexCoords.push_back(texCoords);
+			mTextureIds.push_back(addTexture(texture));
+			mVisible.push_back(visible ? 1 : 0);
+
+			// New sprites need a place in draw order and the grid
+			mOrderChanges.push_back(mId);
+			markMoved(mId);
+
+			// Return ID
+			return mId;
+
+		}
+
+		// Removes sprite, returning the index it held 
+		// (now holding the last sprite), or -1
+		int32_t erase(int32_t id)
+		{
+
+			// Bail if ID is stale
+			int32_t mIndex = getIndex(id);
+			if (mIndex < 0)
+				return -1;
+
+			// Release slot, bumping its generation
+			int32_t mSlot = id & SLOT_MASK;
+			mSlots[mSlot] = -1;
+			mGenerations[mSlot] = (mGenerations[mSlot] + 1) & GENERATION_MASK;
+			mFreeSlots.push_back(mSlot);
+			releaseTexture(mTextureIds[mIndex]);
+
+			// Move last sprite into the gap
+			int32_t mLast = (int32_t)mIds.size() - 1;
+			if (mIndex != mLast)
+			{
+				mAlphas[mIndex] = mAlphas[mLast];
+				mColors[mIndex] = mColors[mLast];
+				mDepths[mIndex] = mDepths[mLast];
+				mIds[mIndex] = mIds[mLast];
+				mLayers[mIndex] = mLayers[mLast];
+				mPositions[mIndex] = mPositions[mLast];
+				mSizes[mIndex] = mSizes[mLast];
+				mSources[mIndex] = mSources[mLast];
+				mTexCoords[mIndex] = mTexCoords[mLast];
+				mTextureIds[mIndex] = mTextureIds[mLast];
+				mVisible[mIndex] = mVisible[mLast];
+				mSlots[mIds[mIndex] & SLOT_MASK] = mIndex;
+			}
+
+			// Drop last element
+			mAlphas.pop_back();
+			mColors.pop_back();
+			mDepths.pop_back();
+			mIds.pop_back();
+			mLayers.pop_back();
+			mPositions.pop_back();
+			mSizes.pop_back();
+			mSources.pop_back();
+			mTexCoords.pop_back();
+			mTextureIds.pop_back();
+			mVisible.pop_back();
+			return mIndex;
+
+		}
+
+		// Removes all sprites
+		void clear()
+		{
+
+			// Invalidate every live ID
+			for (vector<int32_t>::iterator mId = mIds.begin(); mId != mIds.end(); ++mId)
+			{
+				int32_t mSlot = (* mId) & SLOT_MASK;
+				mSlots[mSlot] = -1;
+				mGenerations[mSlot] = (mGenerations[mSlot] + 1) & GENERATION_MASK;
+				mFreeSlots.push_back(mSlot);
+			}
+
+			// Clear arrays
+			mAlphas.clear();
+			mColors.clear();
+			mDepths.clear();
+			mIds.clear();
+			mLayers.clear();
+			mAllMoved = false;
+			mMoves.clear();
+			mOrderChanges.clear();
+			mPositions.clear();
+			mSizes.clear();
+			mSources.clear();
+			mTexCoords.clear();
+			mTextureIds.clear();
+			mVisible.clear();
+			mFreeTextures.clear();
+			mTextureIndex.clear();
+			mTextures.clear();
+			mTextureUses.clear();
+
+		}
+
+		// Grows arrays to hold count sprites
+		void reserve(int32_t count)
+		{
+			size_t mCount = (size_t)count;
+			mAlphas.reserve(mCount);
+			mColors.reserve(mCount);
+			mDepths.reserve(mCount);
+			mIds.reserve(mCount);
+			mLayers.reserve(mCount);
+			mPositions.reserve(mCount);
+			mSizes.reserve(mCount);
+			mSources.reserve(mCount);
+			mTexCoords.reserve(mCount);
+			mTextureIds.reserve(mCount);
+			mVisible.reserve(mCount);
+			mGenerations.reserve(mCount);
+			mSlots.reserve(mCount);
+		}
+
+		// Returns index of sprite in arrays, or -1 if ID is stale
+		int32_t getIndex(int32_t id) const
+		{
+			if (id < 0)
+				return -1;
+			int32_t mSlot = id & SLOT_MASK;
+			if (mSlot >= (int32_t)mSlots.size() || mGenerations[mSlot] != (id >> SLOT_BITS))
+				return -1;
+			return mSlots[mSlot];
+		}
+
+		// Swaps sprite's texture
+		void setTexture(int32_t id, const gl::Texture & texture, const Area & source, const Rectf & texCoords)
+		{
+			int32_t mIndex = getIndex(id);
+			if (mIndex < 0)
+				return;
+			int32_t mTextureId = addTexture(texture);
+			releaseTexture(mTextureIds[mIndex]);
+			mSources[mIndex] = source;
+			mTexCoords[mIndex] = texCoords;
+			mTextureIds[mIndex] = mTextureId;
+		}
+
+		// Logs sprite as moved or resized. Past one entry per 
+		// sprite, the log gives way to a flag that they all did.
+		void markMoved(int32_t id)
+		{
+			if (mAllMoved)
+				return;
+			if (mMoves.size() >= mIds.size())
+			{
+				markAllMoved();
+				return;
+			}
+			mMoves.push_back(id);
+		}
+		void markAllMoved()
+		{
+			mAllMoved = true;
+			mMoves.clear();
+		}
+
+		// Sets bounds, logging the move
+		void setRect(int32_t id, const Rectf & rect)
+		{
+			int32_t mIndex = getIndex(id);
+			if (mIndex < 0)
+				return;
+			mPositions[mIndex] = Vec2f(rect.x1, rect.y1);
+			mSizes[mIndex] = Vec2f(rect.getWidth(), rect.getHeight());
+			markMoved(id);
+		}
+
+		// Sets draw order keys, logging the change
+		void setDepth(int32_t id, float depth)
+		{
+			int32_t mIndex = getIndex(id);
+			if (mIndex >= 0 && mDepths[mIndex] != depth)
+			{
+				mDepths[mIndex] = depth;
+				mOrderChanges.push_back(id);
+			}
+		}
+		void setLayer(int32_t id, int32_t layer)
+		{
+			int32_t mIndex = getIndex(id);
+			if (mIndex >= 0 && mLayers[mIndex] != layer)
+			{
+				mLayers[mIndex] = layer;
+				mOrderChanges.push_back(id);
+			}
+		}
+
+		// Properties, by index
+		vector<float> mAlphas;
+		vector<ColorAf> mColors;
+		vector<float> mDepths;
+		vector<int32_t> mIds;
+		vector<int32_t> mLayers;
+		vector<Vec2f> mPositions;
+		vector<Vec2f> mSizes;
+		vector<Area> mSources;
+		vector<Rectf> mTexCoords;
+		vector<int32_t> mTextureIds;
+		vector<uint8_t> mVisible;
+
+		// Textures, by texture ID
+		vector<gl::Texture> mTextures;
+
+		// IDs inserted or re-layered since last taken. 
+		// May hold duplicates and stale IDs.
+		vector<int32_t> mOrderChanges;
+
+		// IDs inserted or moved since last taken, or a flag 
+		// saying any sprite may have. May hold duplicates 
+		// and stale IDs.
+		bool mAllMoved;
+		vector<int32_t> mMoves;
+
+	private:
+
+		// Adds use of texture, returning its ID
+		int32_t addTexture(const gl::Texture & texture)
+		{
+
+			// Sprites without a texture share ID -1
+			if (!texture)
+				return -1;
+
+			// Reuse ID if texture is known
+			GLuint mGlId = texture.getId();
+			map<GLuint, int32_t>::iterator mTexture = mTextureIndex.find(mGlId);
+			if (mTexture != mTextureIndex.end())
+			{
+				mTextureUses[mTexture->second]++;
+				return mTexture->second;
+			}
+
+			// Add texture
+			int32_t mTextureId;
+			if (!mFreeTextures.empty())
+			{
+				mTextureId = mFreeTextures.back();
+				mFreeTextures.pop_back();
+				mTextures[mTextureId] = texture;
+				mTextureUses[mTextureId] = 1;
+			}
+			else
+			{
+				mTextureId = (int32_t)mTextures.size();
+				mTextures.push_back(texture);
+				mTextureUses.push_back(1);
+			}
+			mTextureIndex.insert(make_pair(mGlId, mTextureId));
+			return mTextureId;
+
+		}
+
+		// Drops use of texture, releasing it when unused
+		void releaseTexture(int32_t textureId)
+		{
+			if (textureId < 0 || --mTextureUses[textureId] > 0)
+				return;
+			mTextureIndex.erase(mTextures[textureId].getId());
+			mTextures[textureId] = gl::Texture();
+			mFreeTextures.push_back(textureId);
+		}
+
+		// Slot table: index of each slot's sprite (-1 if free)
+		// and its generation
+		deque<int32_t> mFreeSlots;
+		vector<int32_t> mGenerations;
+		vector<int32_t> mSlots;
+
+		// Texture bookkeeping
+		vector<int32_t> mFreeTextures;
+		map<GLuint, int32_t> mTextureIndex;
+		vector<int32_t> mTextureUses;
+
+	};
+
+	// Pointer to object
+	std::shared_ptr<Obj> mObj;
+
+	// Adding, removing and reading the change logs is left to 
+	// the batch and its sprites, so its grid and draw order 
+	// stay in step with the store
+	friend class Sprite;
+	friend class SpriteBatch;
+
+	// Add and remove
+	int32_t insert(const gl::Texture & texture, const Area & source, const Rectf & texCoords, const Rectf & rect, const ColorAf & color, float alpha = 1.0f, bool visible = true, int32_t layer = 0, float depth = 0.0f) 
+	{ 
+		return mObj->insert(texture, source, texCoords, rect, color, alpha, visible, layer, depth); 
+	}
+	int32_t erase(int32_t id) { return mObj->erase(id); }
+	void clear() { mObj->clear(); }
+
+	// Moves IDs of sprites that may have moved into ids, 
+	// clearing the log. Returns true instead if any sprite 
+	// may have moved.
+	bool takeMoves(vector<int32_t> & ids) 
+	{ 
+		ids.clear(); 
+		ids.swap(mObj->mMoves); 
+		bool mAllMoved = mObj->mAllMoved;
+		mObj->mAllMoved = false;
+		return mAllMoved;
+	}
+
+	// Moves IDs of sprites whose draw order may have 
+	// changed into ids, clearing the log
+	void takeOrderChanges(vector<int32_t> & ids) { ids.clear(); ids.swap(mObj->mOrderChanges); }
+
+public:
+
+	// Con/de-structor
+	SpriteStore() {}
+	static SpriteStore create() { SpriteStore mStore; mStore.mObj = std::shared_ptr<Obj>(new Obj()); return mStore; }
+	~SpriteStore() { mObj.reset(); }
+
+	// True if store exists
+	operator bool() const { return mObj.get() != 0; }
+
+	// True if both refer to the same store
+	bool operator==(const SpriteStore & rhs) const { return mObj == rhs.mObj; }
+	bool operator!=(const SpriteStore & rhs) const { return mObj != rhs.mObj; }
+
+	// Grows arrays to hold count sprites
+	void reserve(int32_t count) { mObj->reserve(count); }
+
+	// Lookup
+	int32_t getIndex(int32_t id) const { return mObj->getIndex(id); }
+	bool contains(int32_t id) const { return mObj->getIndex(id) >= 0; }
+	int32_t size() const { return (int32_t)mObj->mIds.size(); }
+
+	// Property arrays, by index. Sizes match size(). After 
+	// writing positions or sizes here, call markMoved() so 
+	// picking and queries see it.
+	vector<float> & getAlphas() { return mObj->mAlphas; }
+	vector<ColorAf> & getColors() { return mObj->mColors; }
+	const vector<float> & getDepths() const { return mObj->mDepths; }
+	const vector<int32_t> & getIds() const { return mObj->mIds; }
+	const vector<int32_t> & getLayers() const { return mObj->mLayers; }
+	vector<Vec2f> & getPositions() { return mObj->mPositions; }
+	vector<Vec2f> & getSizes() { return mObj->mSizes; }
+	const vector<Area> & getSources() const { return mObj->mSources; }
+	const vector<Rectf> & getTexCoords() const { return mObj->mTexCoords; }
+	const vector<int32_t> & getTextureIds() const { return mObj->mTextureIds; }
+	vector<uint8_t> & getVisible() { return mObj->mVisible; }
+
+	// Sets sprite's bounds
+	void setRect(int32_t id, const Rectf & rect) { mObj->setRect(id, rect); }
+
+	// Logs sprites moved through the arrays. Use markAllMoved()
+	// after moving most of them; the next pick or query then 
+	// checks every sprite.
+	void markMoved(int32_t id) { mObj->markMoved(id); }
+	void markAllMoved() { mObj->markAllMoved(); }
+
+	// Swaps sprite's texture, eg, once it's loaded
+	void setTexture(int32_t id, const gl::Texture & texture, const Area & source, const Rectf & texCoords) { mObj->setTexture(id, texture, source, texCoords); }
+
+	// Draw order. Sprites draw by layer, then depth, then 
+	// insertion. Set these here so the change is logged.
+	void setDepth(int32_t id, float depth) { mObj->setDepth(id, depth); }
+	void setLayer(int32_t id, int32_t layer) { mObj->setLayer(id, layer); }
+
+	// Texture by texture ID
+	const gl::Texture & getTexture(int32_t textureId) const 
+	{ 
+		static const gl::Texture sEmpty;
+		return textureId < 0 ? sEmpty : mObj->mTextures[textureId]; 
+	}
+
+	// Color as drawn, with alpha applied
+	static ColorAf getDrawColor(const ColorAf & color, float alpha) { return alpha == 1.0f ? color : ColorAf(color.r, color.g, color.b, alpha); }
+
+};
@@ -0,0 +1,234 @@
+// Includes
+#include "cinder/app/AppBasic.h"
+#include "cinder/gl/Texture.h"
+#include "cinder/Rand.h"
+#include "cinder/Surface.h"
+#include "cinder/Timer.h"
+#include "cinder/Utilities.h"
+#include "SpriteBatch.h"
+
+// Imports
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Times moving and drawing 1k, 10k and 100k sprites,
+// with one texture and with several
+class SpriteBenchmarkApp : public AppBasic
+{
+
+public:
+
+	// Cinder callbacks
+	void draw();
+	void keyDown(KeyEvent event);
+	void setup();
+	void update();
+
+private:
+
+	// Frames averaged per run, after a few to warm up
+	static const int32_t kFrames = 120;
+	static const int32_t kWarmUpFrames = 10;
+
+	// A run: sprite count and textures used
+	struct Run
+	{
+		Run(int32_t spriteCount, int32_t textureCount) : mSpriteCount(spriteCount), mTextureCount(textureCount) {}
+		int32_t mSpriteCount;
+		int32_t mTextureCount;
+	};
+
+	// Fills batch for run
+	void fill(const Run & run);
+
+	// Starts the list of runs over
+	void start();
+
+	// Sprites
+	SpriteBatch mBatch;
+	vector<gl::Texture> mTextures;
+	vector<Vec2f> mVelocities;
+
+	// Runs, the current one and its timing
+	int32_t mDrawCalls;
+	double mDrawSeconds;
+	int32_t mFrame;
+	int32_t mRun;
+	vector<Run> mRuns;
+	double mUpdateSeconds;
+
+	// Results
+	vector<string> mResults;
+
+};
+
+// Render
+void SpriteBenchmarkApp::draw()
+{
+
+	// Clear screen
+	gl::clear(Color(0.0f, 0.0f, 0.0f));
+
+	// Draw sprites, timing frames past warm up
+	Timer mTimer(true);
+	mBatch.draw();
+	mTimer.stop();
+	if (mRun < (int32_t)mRuns.size() && mFrame >= kWarmUpFrames)
+	{
+		mDrawSeconds += mTimer.getSeconds();
+		mDrawCalls = mBatch.getDrawCount();
+	}
+
+	// Draw results
+	for (size_t i = 0; i < mResults.size(); i++)
+		gl::drawString(mResults[i], Vec2f(20.0f, 20.0f + (float)i * 20.0f));
+
+}
+
+// Fills batch for run
+void SpriteBenchmarkApp::fill(const Run & run)
+{
+
+	// Clear batch
+	mBatch.clear();
+	mBatch.reserve(run.mSpriteCount);
+	mVelocities.resize((size_t)run.mSpriteCount);
+
+	// Scatter small sprites over the window, cycling textures
+	Rand mRand(1);
+	float mWidth = (float)getWindowWidth();
+	float mHeight = (float)getWindowHeight();
+	for (int32_t i = 0; i < run.mSpriteCount; i++)
+	{
+		Vec2f mPosition(mRand.nextFloat(0.0f, mWidth - 8.0f), mRand.nextFloat(0.0f, mHeight - 8.0f));
+		const gl::Texture & mTexture = mTextures[i % run.mTextureCount];
+		mBatch.insert(mTexture, mTexture.getBounds(), Rectf(mPosition, mPosition + Vec2f(8.0f, 8.0f)));
+		mVelocities[i] = Vec2f(mRand.nextFloat(-2.0f, 2.0f), mRand.nextFloat(-2.0f, 2.0f));
+	}
+
+}
+
+// Handles key press
+void SpriteBenchmarkApp::keyDown(KeyEvent event)
+{
+
+	// Run again on space
+	if (event.getCode() == KeyEvent::KEY_SPACE)
+		start();
+
+}
+
+// Set up
+void SpriteBenchmarkApp::setup()
+{
+
+	// Set up window
+	setFrameRate(1000.0f);
+	setWindowSize(800, 600);
+
+	// Make a few solid textures
+	ColorA8u mColors[] = { ColorA8u(255, 100, 100, 255), ColorA8u(100, 255, 100, 255), ColorA8u(100, 100, 255, 255), ColorA8u(255, 255, 100, 255) };
+	for (int32_t i = 0; i < 4; i++)
+	{
+		Surface mSurface(8, 8, true);
+		for (int32_t y = 0; y < 8; y++)
+			for (int32_t x = 0; x < 8; x++)
+				mSurface.setPixel(Vec2i(x, y), mColors[i]);
+		mTextures.push_back(gl::Texture(mSurface));
+	}
+
+	// Sprite counts, each with one texture and four
+	int32_t mCounts[] = { 1000, 10000, 100000 };
+	for (int32_t i = 0; i < 3; i++)
+	{
+		mRuns.push_back(Run(mCounts[i], 1));
+		mRuns.push_back(Run(mCounts[i], 4));
+	}
+
+	// DO IT!
+	start();
+
+}
+
+// Starts the list of runs over
+void SpriteBenchmarkApp::start()
+{
+
+	// Reset timing
+	mDrawCalls = 0;
+	mDrawSeconds = 0.0;
+	mFrame = 0;
+	mRun = 0;
+	mUpdateSeconds = 0.0;
+	mResults.clear();
+	mResults.push_back("Running...");
+	fill(mRuns[0]);
+
+}
+
+// Runs first thing every frame
+void SpriteBenchmarkApp::update()
+{
+
+	// Bail if all runs are done
+	if (mRun >= (int32_t)mRuns.size())
+		return;
+
+	// Finish run after enough frames, reporting
+	// averages and moving on to the next
+	if (mFrame == kWarmUpFrames + kFrames)
+	{
+		const Run & mCurrent = mRuns[mRun];
+		string mLine = toString(mCurrent.mSpriteCount) + " sprites, " + toString(mCurrent.mTextureCount) +
+			(mCurrent.mTextureCount == 1 ? " texture: " : " textures: ") +
+			"update " + toString(mUpdateSeconds * 1000.0 / (double)kFrames) + "ms, " +
+			"draw " + toString(mDrawSeconds * 1000.0 / (double)kFrames) + "ms, " +
+			toString(mDrawCalls) + " draw calls";
+		console() << mLine << "\n";
+		if (mResults.size() == 1 && mResults[0] == "Running...")
+			mResults.clear();
+		mResults.push_back(mLine);
+		mDrawCalls = 0;
+		mDrawSeconds = 0.0;
+		mFrame = 0;
+		mUpdateSeconds = 0.0;
+		if (++mRun < (int32_t)mRuns.size())
+			fill(mRuns[mRun]);
+		else
+			mResults.push_back("Press space to run again");
+		return;
+	}
+
+	// Move sprites through the store arrays, bouncing off the 
+	// window edges. Nothing is erased, so indices hold.
+	Timer mTimer(true);
+	SpriteStore & mStore = mBatch.getStore();
+	vector<Vec2f> & mPositions = mStore.getPositions();
+	const vector<int32_t> & mIds = mStore.getIds();
+	float mWidth = (float)getWindowWidth() - 8.0f;
+	float mHeight = (float)getWindowHeight() - 8.0f;
+	for (size_t i = 0; i < mPositions.size(); i++)
+	{
+		Vec2f & mPosition = mPositions[i];
+		Vec2f & mVelocity = mVelocities[i];
+		mPosition += mVelocity;
+		if (mPosition.x < 0.0f || mPosition.x > mWidth)
+			mVelocity.x = -mVelocity.x;
+		if (mPosition.y < 0.0f || mPosition.y > mHeight)
+			mVelocity.y = -mVelocity.y;
+	}
+	mStore.markAllMoved();
+
+	// Restack a few sprites, as a game would
+	for (size_t i = 0; i < mIds.size(); i += 100)
+		mStore.setDepth(mIds[i], (float)(mFrame % 8));
+	mTimer.stop();
+	if (mFrame >= kWarmUpFrames)
+		mUpdateSeconds += mTimer.getSeconds();
+	mFrame++;
+
+}
+
+// Start application
+CINDER_APP_BASIC(SpriteBenchmarkApp, RendererGl)
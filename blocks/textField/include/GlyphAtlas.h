@@ -0,0 +1,168 @@
+/*
+ * 
+ * Copyright (c) 2011, Ban the Rewind
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or 
+ * without modification, are permitted provided that the following 
+ * conditions are met:
+ * 
+ * Redistributions of source code must retain the above copyright 
+ * notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright 
+ * notice, this list of conditions and the following disclaimer in 
+ * the documentation and/or other materials provided with the 
+ * distribution.
+ * 
+ * Neither the name of the Ban the Rewind nor the names of its 
+ * contributors may be used to endorse or promote products 
+ * derived from this software without specific prior written 
+ * permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+
+#pragma once
+
+// Includes
+#include <cinder/Font.h>
+#include <cinder/gl/Texture.h>
+#include <cinder/Surface.h>
+#include <cinder/Thread.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// Caches rasterized glyphs for one font in a few large textures. 
+// Each glyph is rendered once, on first use, packed into a page 
+// by rows and uploaded on its own. Atlases are shared by font 
+// name and size while any field holds them.
+class GlyphAtlas
+{
+
+public:
+
+	// Where a glyph lives in the atlas
+	struct Glyph
+	{
+		Glyph() : mAdvance(-1.0f), mPage(-1) {}
+		float mAdvance;
+		int32_t mPage;
+		ci::Vec2f mSize;
+		ci::Rectf mTexCoords;
+	};
+
+private:
+
+	// The object
+	class Obj
+	{
+
+	public:
+
+		// Con/de-structor
+		Obj(const ci::Font & font, int32_t pageSize);
+		~Obj();
+
+		// Get glyph, rasterizing and uploading it if needed
+		const Glyph & getGlyph(uint32_t code, const std::string & text);
+
+		// Get page texture
+		ci::gl::Texture getTexture(int32_t page);
+
+		// Getters
+		const ci::Font & getFont();
+		float getLineHeight();
+		int32_t getPageCount();
+
+	private:
+
+		// Packs glyph surface into a page and uploads it
+		void pack(Glyph & glyph, const ci::Surface8u & surface);
+
+		// Renders text to a surface
+		ci::Surface8u render(const std::string & text);
+
+		// Font and glyph height
+		ci::Font mFont;
+		float mLineHeight;
+
+		// Glyphs, with a table for the first 256 code points
+		std::map<uint32_t, Glyph> mGlyphs;
+		std::vector<Glyph> mLatin;
+
+		// Pages
+		int32_t mPageSize;
+		std::vector<ci::gl::Texture> mTextures;
+
+		// Packing cursor on the last page
+		int32_t mRowHeight;
+		int32_t mX;
+		int32_t mY;
+
+	};
+
+	//	The object
+	std::shared_ptr<Obj> mObj;
+
+	// Constructor
+	GlyphAtlas(const ci::Font & font, int32_t pageSize) 
+	{ 
+		mObj = std::shared_ptr<Obj>(new Obj(font, pageSize)); 
+	};
+
+public:
+
+	// Constructor
+	GlyphAtlas() {};
+	~GlyphAtlas() { reset(); }
+
+	// Returns the atlas for font, creating it if no one holds it
+	static GlyphAtlas create(const ci::Font & font, int32_t pageSize = 1024);
+
+	// Reads UTF-8 code point at position and moves position past it
+	static uint32_t decode(const std::string & text, size_t & position);
+
+	// Lock to hold while rendering with TextLayout or TextBox. 
+	// Cinder's text rendering isn't thread safe on Windows (one 
+	// shared font DC, GDI+), so render threads and the main 
+	// thread take turns.
+	static std::mutex & getTextMutex();
+
+	// Reset
+	void reset() 
+	{ 
+		if (mObj)
+			mObj.reset(); 
+	}
+
+	// Glyph for code point, given the code point as a UTF-8 string. 
+	// New glyphs are uploaded right away, so call on the GL thread.
+	const Glyph & getGlyph(uint32_t code, const std::string & text) { return mObj->getGlyph(code, text); }
+
+	// Texture for a page. Call on the GL thread.
+	ci::gl::Texture getTexture(int32_t page) { return mObj->getTexture(page); }
+
+	// Getters
+	const ci::Font & getFont() { return mObj->getFont(); }
+	float getLineHeight() { return mObj->getLineHeight(); }
+	int32_t getPageCount() { return mObj->getPageCount(); }
+
+	// Validity
+	operator bool() const { return mObj.get() != 0; }
+	bool operator ==(const GlyphAtlas & rhs) const { return mObj == rhs.mObj; }
+	bool operator !=(const GlyphAtlas & rhs) const { return mObj != rhs.mObj; }
+
+};
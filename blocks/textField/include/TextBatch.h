@@ -0,0 +1,209 @@
+/*
+ * 
+ * Copyright (c) 2011, Ban the Rewind
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or 
+ * without modification, are permitted provided that the following 
+ * conditions are met:
+ * 
+ * Redistributions of source code must retain the above copyright 
+ * notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright 
+ * notice, this list of conditions and the following disclaimer in 
+ * the documentation and/or other materials provided with the 
+ * distribution.
+ * 
+ * Neither the name of the Ban the Rewind nor the names of its 
+ * contributors may be used to endorse or promote products 
+ * derived from this software without specific prior written 
+ * permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+
+#pragma once
+
+// Includes
+#include <cinder/Color.h>
+#include <cinder/gl/Vbo.h>
+#include <cinder/MatrixAffine2.h>
+#include <GlyphAtlas.h>
+#include <TextField.h>
+#include <vector>
+
+// Draws many glyph atlas TextFields in one pass. Every field's 
+// quads live in one vertex buffer per atlas page, so a batch 
+// on a single page atlas is one draw call. Each field keeps 
+// its own stretch of the buffer; only fields whose text, 
+// position, color or transform changed are rewritten and 
+// uploaded.
+class TextBatch
+{
+
+private:
+
+	// The object
+	class Obj
+	{
+
+	public:
+
+		// Con/de-structor
+		Obj(const GlyphAtlas & atlas);
+		~Obj();
+
+		// Add/remove fields
+		void clear();
+		void erase(int32_t id);
+		int32_t insert(const TextField & field, const ci::ColorAf & color);
+
+		// Draw all fields
+		void draw();
+
+		// Field settings
+		void setColor(int32_t id, const ci::ColorAf & color);
+		void setTransform(int32_t id, const ci::MatrixAffine2f & transform);
+		void setVisible(int32_t id, bool visible);
+
+		// Getters
+		GlyphAtlas getAtlas();
+		int32_t getDrawCount();
+		int32_t getUploadCount();
+		int32_t size();
+
+	private:
+
+		// Stretch of a page's vertices
+		struct Region
+		{
+			Region() : mCapacity(0), mOffset(0) {}
+			int32_t mCapacity;
+			int32_t mOffset;
+		};
+
+		// Field and its settings
+		struct Entry
+		{
+			Entry() : mActive(false), mDirty(true), mRevision(0), mVisible(true) {}
+			bool mActive;
+			ci::ColorA8u mColor;
+			bool mDirty;
+			TextField mField;
+			std::vector<Region> mRegions;
+			uint32_t mRevision;
+			ci::MatrixAffine2f mTransform;
+			bool mVisible;
+		};
+
+		// Vertex as uploaded
+		struct Vertex
+		{
+			ci::Vec2f mPosition;
+			ci::Vec2f mTexCoord;
+			ci::ColorA8u mColor;
+		};
+
+		// Vertices waiting for upload
+		struct Range
+		{
+			Range(int32_t begin, int32_t end) : mBegin(begin), mEnd(end) {}
+			static bool endsBefore(const Range & range, int32_t position) { return range.mEnd < position; }
+			int32_t mBegin;
+			int32_t mEnd;
+		};
+
+		// Vertices for one atlas page, and the ranges to 
+		// upload, sorted and apart
+		struct Page
+		{
+			Page() : mCapacity(0), mGarbage(0) {}
+			ci::gl::Vbo mBuffer;
+			int32_t mCapacity;
+			std::vector<Range> mDirty;
+			int32_t mGarbage;
+			std::vector<Vertex> mVertices;
+		};
+
+		// Moves live regions together when a page is mostly garbage
+		void compact(int32_t page);
+
+		// Marks vertices for upload
+		void markDirty(Page & page, int32_t begin, int32_t end);
+
+		// Clears region, leaving degenerate triangles
+		void release(int32_t page, Region & region);
+
+		// Writes field's vertices into its regions
+		void write(Entry & entry);
+
+		// Atlas and pages
+		GlyphAtlas mAtlas;
+		std::vector<Page> mPages;
+
+		// Fields, by ID
+		std::vector<Entry> mEntries;
+		std::vector<int32_t> mFreeIds;
+
+		// Stats for last draw
+		int32_t mDrawCount;
+		int32_t mUploadCount;
+
+	};
+
+	//	The object
+	std::shared_ptr<Obj> mObj;
+
+public:
+
+	// Constructor. Fields must use atlas.
+	TextBatch() {};
+	TextBatch(const GlyphAtlas & atlas) 
+	{ 
+		mObj = std::shared_ptr<Obj>(new Obj(atlas)); 
+	};
+	~TextBatch() { reset(); }
+
+	// Reset
+	void reset() 
+	{ 
+		if (mObj)
+			mObj.reset(); 
+	}
+
+	// Adds field, returning its ID, or -1 if it doesn't use the 
+	// batch's atlas. Text is tinted by color.
+	int32_t insert(const TextField & field, const ci::ColorAf & color = ci::ColorAf::white()) { return mObj->insert(field, color); }
+
+	// Removes fields
+	void clear() { mObj->clear(); }
+	void erase(int32_t id) { mObj->erase(id); }
+
+	// Uploads changed fields and draws them all
+	void draw() { mObj->draw(); }
+
+	// Field settings, by ID. The transform is applied 
+	// after the field's own position.
+	void setColor(int32_t id, const ci::ColorAf & color) { mObj->setColor(id, color); }
+	void setTransform(int32_t id, const ci::MatrixAffine2f & transform) { mObj->setTransform(id, transform); }
+	void setVisible(int32_t id, bool visible) { mObj->setVisible(id, visible); }
+
+	// Getters. Upload count is fields rewritten by last draw().
+	GlyphAtlas getAtlas() { return mObj->getAtlas(); }
+	int32_t getDrawCount() { return mObj->getDrawCount(); }
+	int32_t getUploadCount() { return mObj->getUploadCount(); }
+	int32_t size() { return mObj->size(); }
+
+};
@@ -41,12 +41,28 @@
 #include <cinder/Area.h>
 #include <cinder/app/App.h>
 #include <cinder/Text.h>
+#include <cinder/Thread.h>
 #include <cinder/gl/Texture.h>
+#include <GlyphAtlas.h>
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
 
 // Text input class
 class TextField
 {
 
+public:
+
+	// Glyph quad corner, relative to field
+	struct Vertex
+	{
+		ci::Vec2f mPosition;
+		ci::Vec2f mTexCoord;
+	};
+
 private:
 
 	// The object
@@ -59,6 +75,14 @@ private:
 		Obj(const ci::Area & area, const ci::Font & font, bool wrap, bool centered = false);
 		~Obj();
 
+		// Draws text at its position
+		void draw();
+
+		// Glyph atlas vertices for a page, and a count 
+		// bumped whenever they or the bounds change
+		uint32_t getRevision();
+		const std::vector<Vertex> & getVertices(int32_t page);
+
 		// Get rendered texture and area
 		ci::Area getBounds();
 		ci::Area getBounds() const;
@@ -79,13 +103,31 @@ private:
 		std::string str() const;
 
 		// Change text display settings
+		GlyphAtlas getAtlas();
+		bool getLineCache();
+		bool isAsync();
+		void setAsync(bool async);
+		void setAtlas(const GlyphAtlas & atlas);
 		void setFlipped(bool flip);
 		void setFont(const ci::Font & font);
 		void setLeading(float leading);
+		void setLineCache(bool lineCache);
 
-		// Updates texture
+		// Marks text as changed from the character at position 
+		// on, except for the last tail characters. Glyph atlas 
+		// fields keep lines that end before the change, and 
+		// those inside the tail once wrapping lines up again.
+		void invalidate(size_t position = 0, size_t tail = 0);
+
+		// Applies pending changes now
 		void update();
 
+		// Applies pending changes to fields until budget runs out
+		static void updateAll(double budget);
+
+		// Stops render thread
+		static void stopWorkers();
+
 		// Move 
 		void setX(int32_t value);
 		void setY(int32_t value);
@@ -97,15 +139,167 @@ private:
 
 	private:
 
+		// Glyph quad, relative to its line
+		struct Quad
+		{
+			int32_t mPage;
+			ci::Rectf mRect;
+			ci::Rectf mTexCoords;
+		};
+
+		// Laid out line of text, with its texture when 
+		// caching lines and its vertex count on each page
+		struct Line
+		{
+
+			// Swaps lines without copying quads
+			void swap(Line & rhs)
+			{
+				std::swap(mEnd, rhs.mEnd);
+				mQuads.swap(rhs.mQuads);
+				std::swap(mStart, rhs.mStart);
+				std::swap(mTexture, rhs.mTexture);
+				mVertexCounts.swap(rhs.mVertexCounts);
+				std::swap(mWidth, rhs.mWidth);
+			}
+
+			size_t mEnd;
+			std::vector<Quad> mQuads;
+			size_t mStart;
+			ci::gl::Texture mTexture;
+			std::vector<uint32_t> mVertexCounts;
+			float mWidth;
+
+		};
+
+		// Text to render, copied from the field so workers 
+		// never touch it
+		struct Job
+		{
+			bool mCanceled;
+			bool mCentered;
+			bool mDone;
+			bool mStarted;
+			ci::Font mFont;
+			float mLeading;
+			ci::Surface8u mSurface;
+			std::string mValue;
+			int32_t mWidth;
+			bool mWrap;
+		};
+
+		// Render thread shared by async fields
+		class Workers
+		{
+
+		public:
+
+			Workers();
+			~Workers();
+
+			// Queues job, starting thread on first use
+			void push(const std::shared_ptr<Job> & job);
+
+			// Drops queued jobs and waits for the thread to finish
+			void stop();
+
+			// Guards job flags and surfaces
+			std::mutex mMutex;
+
+		private:
+
+			// Thread loop
+			void run();
+
+			std::deque<std::shared_ptr<Job> > mJobs;
+			bool mExit;
+			std::shared_ptr<std::thread> mThread;
+			std::condition_variable mWake;
+
+		};
+		static Workers sWorkers;
+
+		// Builds vertices for lines that have changed
+		void buildVertices();
+
+		// Marks vertices stale from line on, except for the 
+		// last tail lines, which at most move
+		void dirtyVertices(size_t line, size_t tail);
+
+		// Drops render job in progress and any follow-up
+		void cancel();
+
+		// Copies settings into a render job
+		std::shared_ptr<Job> createJob();
+
+		// Renders text from the character at position on, 
+		// up to the last tail characters
+		void refresh(size_t position, size_t tail);
+
+		// Renders text to a surface for the texture
+		static ci::Surface8u render(const Job & job);
+
+		// Measures code point for cached lines
+		float getAdvance(uint32_t code, const std::string & text);
+
+		// Height of a line, without leading
+		float getLineHeight();
+
+		// Renders line to its own texture
+		ci::gl::Texture renderLine(size_t start, size_t end);
+
+		// Moves rendered surface to texture
+		void upload(const ci::Surface8u & surface);
+
+		// Lays out lines from the one holding position on, 
+		// keeping old lines once they line up inside the 
+		// last tail characters
+		void layout(size_t position, size_t tail);
+
+		// Sets bounds from texture or lines
+		void updateBounds();
+
+		// Earliest changed character, or npos if up to 
+		// date, characters at the end unchanged since, and 
+		// the fields with pending changes
+		size_t mDirtyFrom;
+		size_t mDirtyTail;
+		static std::set<Obj *> sDirty;
+
+		// Render on workers, the job in progress, and whether 
+		// the text has changed since it started
+		bool mAsync;
+		std::shared_ptr<Job> mJob;
+		bool mPending;
+
+		// Glyph atlas layout, the text length it was made 
+		// for, and lines being wrapped. Cached lines are laid 
+		// out with advances measured by TextLayout, the same 
+		// engine that renders them.
+		std::map<uint32_t, float> mAdvances;
+		GlyphAtlas mAtlas;
+		size_t mLaidOutLength;
+		bool mLineCache;
+		std::vector<Line> mLines;
+		std::vector<Line> mWrapped;
+
+		// Vertices by page, the line count and size they 
+		// were built for, and the lines to rebuild
+		std::vector<std::vector<Vertex> > mKeptVertices;
+		size_t mBuiltLines;
+		ci::Vec2i mBuiltSize;
+		uint32_t mRevision;
+		std::vector<std::vector<Vertex> > mVertices;
+		size_t mVertexFrom;
+		size_t mVertexTail;
+
 		// Text
 		ci::Area mBounds;
 		bool mCentered;
 		float mLeading;
 		bool mFlipped;
 		ci::Font mFont;
-		ci::TextBox mTextBox;
 		ci::gl::Texture mTexture;
-		ci::TextLayout mTextLayout;
 		std::string mValue;
 		bool mWrap;
 
@@ -139,6 +333,24 @@ public:
 			mObj.reset(); 
 	}
 
+	// Draw text
+	void draw() { mObj->draw(); }
+
+	// Changes to text, fonts and size are applied when the field 
+	// is next drawn or measured. Call update() to apply them now, 
+	// or updateAll() once a frame to spread the work out.
+	void update() { mObj->update(); }
+	static void updateAll(double budget = 0.004) { Obj::updateAll(budget); }
+
+	// Stops the render thread used by async fields, dropping renders 
+	// that haven't started. Call from your app's shutdown(). If you 
+	// don't, it's stopped when statics are destroyed.
+	static void stopWorkers() { Obj::stopWorkers(); }
+
+	// Glyph atlas vertices, for batching
+	uint32_t getRevision() { return mObj->getRevision(); }
+	const std::vector<Vertex> & getVertices(int32_t page) { return mObj->getVertices(page); }
+
 	// Texture methods
 	ci::gl::Texture getTexture() { return mObj->getTexture(); }
 	ci::gl::Texture getTexture() const { return mObj->getTexture(); }
@@ -158,7 +370,19 @@ public:
 	std::string str() { return mObj->str(); }
 	std::string str() const { return mObj->str(); }
 
-	// Font methods
+	// Font methods. Setting a glyph atlas draws text as quads 
+	// from shared glyph textures instead of rendering a texture
+	// per field; only changed lines are laid out again. Async 
+	// fields render their texture on a worker thread and keep 
+	// drawing the old one until the new one is ready. Line 
+	// caching gives each line its own texture, so an edit only 
+	// renders the lines from the one it touches on.
+	GlyphAtlas getAtlas() { return mObj->getAtlas(); }
+	bool getLineCache() { return mObj->getLineCache(); }
+	bool isAsync() { return mObj->isAsync(); }
+	void setAsync(bool async = true) { mObj->setAsync(async); }
+	void setLineCache(bool lineCache = true) { mObj->setLineCache(lineCache); }
+	void setAtlas(const GlyphAtlas & atlas) { mObj->setAtlas(atlas); }
 	void setFlipped(bool flip = true) { mObj->setFlipped(true); }
 	void setFont(const ci::Font & font) { mObj->setFont(font); }
 	void setLeading(float leading) { mObj->setLeading(leading); }
@@ -179,22 +403,22 @@ public:
 	void setX1(int32_t value) 
 	{ 
 		mObj->setX1(value); 
-		mObj->update();
+		mObj->invalidate();
 	}
 	void setX2(int32_t value) 
 	{ 
 		mObj->setX2(value);
-		mObj->update();
+		mObj->invalidate();
 	}
 	void setY1(int32_t value) 
 	{ 
 		mObj->setY1(value);
-		mObj->update();
+		mObj->invalidate();
 	}
 	void setY2(int32_t value) 
 	{ 
 		mObj->setY2(value);
-		mObj->update();
+		mObj->invalidate();
 	}
 
 };
@@ -0,0 +1,268 @@
+/*
+ * 
+ * Copyright (c) 2011, Ban the Rewind
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or 
+ * without modification, are permitted provided that the following 
+ * conditions are met:
+ * 
+ * Redistributions of source code must retain the above copyright 
+ * notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright 
+ * notice, this list of conditions and the following disclaimer in 
+ * the documentation and/or other materials provided with the 
+ * distribution.
+ * 
+ * Neither the name of the Ban the Rewind nor the names of its 
+ * contributors may be used to endorse or promote products 
+ * derived from this software without specific prior written 
+ * permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+
+// Include header
+#include <GlyphAtlas.h>
+#include <cinder/gl/gl.h>
+#include <cinder/Text.h>
+#include <cstring>
+#include <sstream>
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Constructor
+GlyphAtlas::Obj::Obj(const Font & font, int32_t pageSize) 
+	: mFont(font), mPageSize(pageSize), mRowHeight(0), mX(0), mY(0)
+{
+
+	// Glyphs are rendered a line high
+	mLatin.resize(256);
+	mLineHeight = mFont.getAscent() + mFont.getDescent();
+
+}
+
+// Destructor
+GlyphAtlas::Obj::~Obj()
+{
+
+	// Clean up
+	mGlyphs.clear();
+	mLatin.clear();
+	mTextures.clear();
+
+}
+
+// Get font
+const Font & GlyphAtlas::Obj::getFont()
+{
+	return mFont;
+}
+
+// Get glyph, rasterizing it on first use
+const GlyphAtlas::Glyph & GlyphAtlas::Obj::getGlyph(uint32_t code, const string & text)
+{
+
+	// Look up glyph
+	Glyph & mGlyph = code < 256 ? mLatin[code] : mGlyphs[code];
+	if (mGlyph.mAdvance >= 0.0f)
+		return mGlyph;
+
+	// Text layouts may drop trailing space, so measure 
+	// whitespace as the gap it makes between two bars
+	if (code == ' ' || code == '\t')
+	{
+		mGlyph.mAdvance = (float)(render("|" + text + "|").getWidth() - render("||").getWidth());
+		return mGlyph;
+	}
+
+	// Render glyph and pack it
+	Surface8u mSurface = render(text);
+	mGlyph.mAdvance = (float)mSurface.getWidth();
+	pack(mGlyph, mSurface);
+	return mGlyph;
+
+}
+
+// Get glyph height
+float GlyphAtlas::Obj::getLineHeight()
+{
+	return mLineHeight;
+}
+
+// Get page count
+int32_t GlyphAtlas::Obj::getPageCount()
+{
+	return (int32_t)mTextures.size();
+}
+
+// Get page texture
+gl::Texture GlyphAtlas::Obj::getTexture(int32_t page)
+{
+
+	// Bail if page doesn't exist
+	if (page < 0 || page >= (int32_t)mTextures.size())
+		return gl::Texture();
+	return mTextures[page];
+
+}
+
+// Packs glyph surface into a page and uploads it
+void GlyphAtlas::Obj::pack(Glyph & glyph, const Surface8u & surface)
+{
+
+	// Bail if glyph is empty or too big
+	int32_t mWidth = surface.getWidth();
+	int32_t mHeight = surface.getHeight();
+	if (mWidth <= 0 || mHeight <= 0 || mWidth + 1 > mPageSize || mHeight + 1 > mPageSize)
+		return;
+
+	// Move to next row, or next page, if full. Leave a 
+	// clear pixel between glyphs so filtering doesn't bleed.
+	if (mX + mWidth + 1 > mPageSize)
+	{
+		mX = 0;
+		mY += mRowHeight;
+		mRowHeight = 0;
+	}
+	if (mTextures.empty() || mY + mHeight + 1 > mPageSize)
+	{
+
+		// Start the page from a clear surface. Only the 
+		// texture is kept; glyphs go straight into it.
+		Surface8u mClear(mPageSize, mPageSize, true, SurfaceChannelOrder::RGBA);
+		for (int32_t y = 0; y < mPageSize; y++)
+			memset(mClear.getData(Vec2i(0, y)), 0, (size_t)mPageSize * mClear.getPixelInc());
+		mTextures.push_back(gl::Texture(mClear));
+		mX = 0;
+		mY = 0;
+		mRowHeight = 0;
+
+	}
+
+	// Convert glyph to RGBA and upload just its rect
+	int32_t mPage = (int32_t)mTextures.size() - 1;
+	Surface8u mPixels(mWidth, mHeight, true, SurfaceChannelOrder::RGBA);
+	mPixels.copyFrom(surface, surface.getBounds());
+	gl::Texture & mTexture = mTextures[mPage];
+	mTexture.bind();
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, mPixels.getRowBytes() / mPixels.getPixelInc());
+	glTexSubImage2D(mTexture.getTarget(), 0, mX, mY, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, mPixels.getData());
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	mTexture.unbind();
+
+	// Record location
+	float mSize = (float)mPageSize;
+	glyph.mPage = mPage;
+	glyph.mSize = Vec2f((float)mWidth, (float)mHeight);
+	glyph.mTexCoords = Rectf((float)mX / mSize, (float)mY / mSize, (float)(mX + mWidth) / mSize, (float)(mY + mHeight) / mSize);
+
+	// Advance cursor
+	mX += mWidth + 1;
+	mRowHeight = math<int32_t>::max(mRowHeight, mHeight + 1);
+
+}
+
+// Renders text to a surface
+Surface8u GlyphAtlas::Obj::render(const string & text)
+{
+
+	// White on clear, so color can be applied when drawing
+	lock_guard<mutex> mLock(GlyphAtlas::getTextMutex());
+	TextLayout mLayout;
+	mLayout.clear(ColorA(0.0f, 0.0f, 0.0f, 0.0f));
+	mLayout.setColor(Color::white());
+	mLayout.setFont(mFont);
+	mLayout.addLine(text);
+	return mLayout.render(true, false);
+
+}
+
+// Returns shared atlas for font
+GlyphAtlas GlyphAtlas::create(const Font & font, int32_t pageSize)
+{
+
+	// Key atlases by font name, size and page size. The registry 
+	// doesn't own them, so an atlas and its textures go with the 
+	// last field using it.
+	static map<string, weak_ptr<Obj> > sAtlases;
+	stringstream mKey;
+	mKey << font.getName() << ":" << font.getSize() << ":" << pageSize;
+
+	// Forget atlases no one holds
+	for (map<string, weak_ptr<Obj> >::iterator mEntry = sAtlases.begin(); mEntry != sAtlases.end(); )
+	{
+		if (mEntry->second.expired())
+			sAtlases.erase(mEntry++);
+		else
+			++mEntry;
+	}
+
+	// Share live atlas, or create one
+	GlyphAtlas mAtlas;
+	weak_ptr<Obj> & mEntry = sAtlases[mKey.str()];
+	mAtlas.mObj = mEntry.lock();
+	if (!mAtlas.mObj)
+	{
+		mAtlas = GlyphAtlas(font, pageSize);
+		mEntry = mAtlas.mObj;
+	}
+	return mAtlas;
+
+}
+
+// Returns text rendering lock. It's made on first call, so 
+// statics that use it while shutting down can call this in 
+// their constructor to outlive it.
+mutex & GlyphAtlas::getTextMutex()
+{
+	static mutex sMutex;
+	return sMutex;
+}
+
+// Reads UTF-8 code point
+uint32_t GlyphAtlas::decode(const string & text, size_t & position)
+{
+
+	// Read lead byte
+	uint8_t mByte = (uint8_t)text[position++];
+	int32_t mCount = 0;
+	uint32_t mCode = mByte;
+	if (mByte >= 0xf0)
+	{
+		mCode = mByte & 0x07;
+		mCount = 3;
+	}
+	else if (mByte >= 0xe0)
+	{
+		mCode = mByte & 0x0f;
+		mCount = 2;
+	}
+	else if (mByte >= 0xc0)
+	{
+		mCode = mByte & 0x1f;
+		mCount = 1;
+	}
+
+	// Read continuation bytes, stopping at anything malformed
+	for (int32_t i = 0; i < mCount && position < text.length() && ((uint8_t)text[position] & 0xc0) == 0x80; i++)
+		mCode = (mCode << 6) | ((uint8_t)text[position++] & 0x3f);
+	return mCode;
+
+}
@@ -0,0 +1,391 @@
+/*
+ * 
+ * Copyright (c) 2011, Ban the Rewind
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or 
+ * without modification, are permitted provided that the following 
+ * conditions are met:
+ * 
+ * Redistributions of source code must retain the above copyright 
+ * notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright 
+ * notice, this list of conditions and the following disclaimer in 
+ * the documentation and/or other materials provided with the 
+ * distribution.
+ * 
+ * Neither the name of the Ban the Rewind nor the names of its 
+ * contributors may be used to endorse or promote products 
+ * derived from this software without specific prior written 
+ * permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+
+// Include header
+#include <TextBatch.h>
+#include <algorithm>
+#include <cinder/app/App.h>
+#include <cstddef>
+
+// Imports
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Constructor
+TextBatch::Obj::Obj(const GlyphAtlas & atlas) 
+	: mAtlas(atlas), mDrawCount(0), mUploadCount(0)
+{
+}
+
+// Destructor
+TextBatch::Obj::~Obj()
+{
+
+	// Clean up
+	mEntries.clear();
+	mFreeIds.clear();
+	mPages.clear();
+
+}
+
+// Remove all fields
+void TextBatch::Obj::clear()
+{
+
+	// DO IT!
+	mEntries.clear();
+	mFreeIds.clear();
+	mPages.clear();
+
+}
+
+// Move live regions together
+void TextBatch::Obj::compact(int32_t page)
+{
+
+	// Copy each field's region into a fresh array
+	Page & mPage = mPages[page];
+	vector<Vertex> mVertices;
+	mVertices.reserve(mPage.mVertices.size() - (size_t)mPage.mGarbage);
+	for (vector<Entry>::iterator mEntry = mEntries.begin(); mEntry != mEntries.end(); ++mEntry)
+	{
+		if (!mEntry->mActive || page >= (int32_t)mEntry->mRegions.size())
+			continue;
+		Region & mRegion = mEntry->mRegions[page];
+		if (mRegion.mCapacity == 0)
+			continue;
+		int32_t mOffset = (int32_t)mVertices.size();
+		mVertices.insert(mVertices.end(), mPage.mVertices.begin() + mRegion.mOffset, mPage.mVertices.begin() + mRegion.mOffset + mRegion.mCapacity);
+		mRegion.mOffset = mOffset;
+	}
+
+	// Swap in and upload everything. Ranges queued 
+	// before this point at old offsets.
+	mPage.mVertices.swap(mVertices);
+	mPage.mGarbage = 0;
+	mPage.mDirty.clear();
+	markDirty(mPage, 0, (int32_t)mPage.mVertices.size());
+
+}
+
+// Draw all fields
+void TextBatch::Obj::draw()
+{
+
+	// Rewrite changed fields
+	mDrawCount = 0;
+	mUploadCount = 0;
+	for (vector<Entry>::iterator mEntry = mEntries.begin(); mEntry != mEntries.end(); ++mEntry)
+	{
+		if (mEntry->mActive && (mEntry->mDirty || mEntry->mField.getRevision() != mEntry->mRevision))
+		{
+			write(* mEntry);
+			mUploadCount++;
+		}
+	}
+
+	// Point fixed function arrays at each page's buffer
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	for (int32_t i = 0; i < (int32_t)mPages.size(); i++)
+	{
+
+		// Skip empty pages, and compact mostly empty ones
+		Page & mPage = mPages[i];
+		int32_t mSize = (int32_t)mPage.mVertices.size();
+		if (mSize == 0)
+			continue;
+		if (mPage.mGarbage > mSize / 2)
+		{
+			compact(i);
+			mSize = (int32_t)mPage.mVertices.size();
+			if (mSize == 0)
+				continue;
+		}
+
+		// Upload changes, growing buffer as needed
+		if (!mPage.mBuffer)
+			mPage.mBuffer = gl::Vbo(GL_ARRAY_BUFFER);
+		mPage.mBuffer.bind();
+		if (mPage.mCapacity < mSize)
+		{
+			mPage.mCapacity = math<int32_t>::max(mSize, mPage.mCapacity * 2);
+			mPage.mBuffer.bufferData((size_t)mPage.mCapacity * sizeof(Vertex), 0, GL_DYNAMIC_DRAW);
+			markDirty(mPage, 0, mSize);
+		}
+		for (vector<Range>::const_iterator mRange = mPage.mDirty.begin(); mRange != mPage.mDirty.end(); ++mRange)
+			mPage.mBuffer.bufferSubData((ptrdiff_t)mRange->mBegin * sizeof(Vertex), (size_t)(mRange->mEnd - mRange->mBegin) * sizeof(Vertex), &mPage.mVertices[mRange->mBegin]);
+		mPage.mDirty.clear();
+
+		// Draw page
+		gl::Texture mTexture = mAtlas.getTexture(i);
+		mTexture.enableAndBind();
+		glVertexPointer(2, GL_FLOAT, sizeof(Vertex), (const GLvoid *)offsetof(Vertex, mPosition));
+		glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), (const GLvoid *)offsetof(Vertex, mTexCoord));
+		glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), (const GLvoid *)offsetof(Vertex, mColor));
+		glDrawArrays(GL_TRIANGLES, 0, mSize);
+		mTexture.unbind();
+		mTexture.disable();
+		mPage.mBuffer.unbind();
+		mDrawCount++;
+
+	}
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+}
+
+// Remove field
+void TextBatch::Obj::erase(int32_t id)
+{
+
+	// Bail if ID is unused
+	if (id < 0 || id >= (int32_t)mEntries.size() || !mEntries[id].mActive)
+		return;
+
+	// Free regions and ID
+	Entry & mEntry = mEntries[id];
+	for (int32_t i = 0; i < (int32_t)mEntry.mRegions.size(); i++)
+		release(i, mEntry.mRegions[i]);
+	mEntry = Entry();
+	mFreeIds.push_back(id);
+
+}
+
+// Get atlas
+GlyphAtlas TextBatch::Obj::getAtlas()
+{
+	return mAtlas;
+}
+
+// Get draw calls made by last draw
+int32_t TextBatch::Obj::getDrawCount()
+{
+	return mDrawCount;
+}
+
+// Get fields rewritten by last draw
+int32_t TextBatch::Obj::getUploadCount()
+{
+	return mUploadCount;
+}
+
+// Add field
+int32_t TextBatch::Obj::insert(const TextField & field, const ColorAf & color)
+{
+
+	// Bail if field uses another atlas
+	TextField mField = field;
+	if (mField.getAtlas() != mAtlas)
+	{
+		console() << "TextBatch: field does not use this batch's glyph atlas\n";
+		return -1;
+	}
+
+	// Reuse a free ID or add one
+	int32_t mId;
+	if (!mFreeIds.empty())
+	{
+		mId = mFreeIds.back();
+		mFreeIds.pop_back();
+	}
+	else
+	{
+		mId = (int32_t)mEntries.size();
+		mEntries.push_back(Entry());
+	}
+
+	// Set up entry
+	Entry & mEntry = mEntries[mId];
+	mEntry.mActive = true;
+	mEntry.mField = mField;
+	mEntry.mTransform = MatrixAffine2f::identity();
+	setColor(mId, color);
+	return mId;
+
+}
+
+// Mark vertices for upload
+void TextBatch::Obj::markDirty(Page & page, int32_t begin, int32_t end)
+{
+
+	// Bail if empty
+	if (end <= begin)
+		return;
+
+	// Find ranges this touches, merging them into one, so 
+	// fields far apart upload separately, not everything 
+	// between them
+	vector<Range> & mDirty = page.mDirty;
+	vector<Range>::iterator mFirst = lower_bound(mDirty.begin(), mDirty.end(), begin, Range::endsBefore);
+	vector<Range>::iterator mLast = mFirst;
+	while (mLast != mDirty.end() && mLast->mBegin <= end)
+	{
+		begin = math<int32_t>::min(begin, mLast->mBegin);
+		end = math<int32_t>::max(end, mLast->mEnd);
+		++mLast;
+	}
+	if (mFirst == mLast)
+	{
+		mDirty.insert(mFirst, Range(begin, end));
+	}
+	else
+	{
+		mFirst->mBegin = begin;
+		mFirst->mEnd = end;
+		mDirty.erase(mFirst + 1, mLast);
+	}
+
+}
+
+// Clear region
+void TextBatch::Obj::release(int32_t page, Region & region)
+{
+
+	// Zeroed vertices make degenerate triangles
+	if (region.mCapacity == 0)
+		return;
+	Page & mPage = mPages[page];
+	fill(mPage.mVertices.begin() + region.mOffset, mPage.mVertices.begin() + region.mOffset + region.mCapacity, Vertex());
+	markDirty(mPage, region.mOffset, region.mOffset + region.mCapacity);
+	mPage.mGarbage += region.mCapacity;
+	region = Region();
+
+}
+
+// Set field color
+void TextBatch::Obj::setColor(int32_t id, const ColorAf & color)
+{
+
+	// Bail if ID is unused
+	if (id < 0 || id >= (int32_t)mEntries.size() || !mEntries[id].mActive)
+		return;
+
+	// Convert to bytes
+	Entry & mEntry = mEntries[id];
+	mEntry.mColor = ColorA8u(
+		(uint8_t)(math<float>::clamp(color.r, 0.0f, 1.0f) * 255.0f + 0.5f), 
+		(uint8_t)(math<float>::clamp(color.g, 0.0f, 1.0f) * 255.0f + 0.5f), 
+		(uint8_t)(math<float>::clamp(color.b, 0.0f, 1.0f) * 255.0f + 0.5f), 
+		(uint8_t)(math<float>::clamp(color.a, 0.0f, 1.0f) * 255.0f + 0.5f));
+	mEntry.mDirty = true;
+
+}
+
+// Set field transform
+void TextBatch::Obj::setTransform(int32_t id, const MatrixAffine2f & transform)
+{
+
+	// DO IT!
+	if (id >= 0 && id < (int32_t)mEntries.size() && mEntries[id].mActive)
+	{
+		mEntries[id].mTransform = transform;
+		mEntries[id].mDirty = true;
+	}
+
+}
+
+// Show/hide field
+void TextBatch::Obj::setVisible(int32_t id, bool visible)
+{
+
+	// DO IT!
+	if (id >= 0 && id < (int32_t)mEntries.size() && mEntries[id].mActive && mEntries[id].mVisible != visible)
+	{
+		mEntries[id].mVisible = visible;
+		mEntries[id].mDirty = true;
+	}
+
+}
+
+// Get field count
+int32_t TextBatch::Obj::size()
+{
+	return (int32_t)(mEntries.size() - mFreeIds.size());
+}
+
+// Write field's vertices
+void TextBatch::Obj::write(Entry & entry)
+{
+
+	// Match pages to atlas
+	int32_t mPageCount = mAtlas.getPageCount();
+	if ((int32_t)mPages.size() < mPageCount)
+		mPages.resize((size_t)mPageCount);
+	entry.mRegions.resize((size_t)mPageCount);
+
+	// Fields moved to another atlas draw nothing
+	bool mShow = entry.mVisible && entry.mField.getAtlas() == mAtlas;
+	Area mBounds = entry.mField.getBounds();
+	Vec2f mPosition((float)mBounds.getX1(), (float)mBounds.getY1());
+	static const vector<TextField::Vertex> sEmpty;
+	for (int32_t i = 0; i < mPageCount; i++)
+	{
+
+		// Move to end of page if field has outgrown its region.
+		// Leave room to grow so typing doesn't move it every time.
+		Page & mPage = mPages[i];
+		Region & mRegion = entry.mRegions[i];
+		const vector<TextField::Vertex> & mSource = mShow ? entry.mField.getVertices(i) : sEmpty;
+		int32_t mCount = (int32_t)mSource.size();
+		if (mCount > mRegion.mCapacity)
+		{
+			release(i, mRegion);
+			mRegion.mCapacity = mCount + (mCount / 12) * 6;
+			mRegion.mOffset = (int32_t)mPage.mVertices.size();
+			mPage.mVertices.resize(mPage.mVertices.size() + (size_t)mRegion.mCapacity);
+		}
+
+		// Transform vertices into region, zeroing what's left
+		Vertex * mVertex = mRegion.mCapacity > 0 ? &mPage.mVertices[mRegion.mOffset] : 0;
+		for (int32_t j = 0; j < mCount; j++, mVertex++)
+		{
+			mVertex->mPosition = entry.mTransform.transformPoint(mSource[j].mPosition + mPosition);
+			mVertex->mTexCoord = mSource[j].mTexCoord;
+			mVertex->mColor = entry.mColor;
+		}
+		if (mRegion.mCapacity > mCount)
+			fill(mVertex, mVertex + (mRegion.mCapacity - mCount), Vertex());
+		markDirty(mPage, mRegion.mOffset, mRegion.mOffset + mRegion.mCapacity);
+
+	}
+	entry.mDirty = false;
+	entry.mRevision = entry.mField.getRevision();
+
+}
@@ -36,6 +36,8 @@
 
 // Include header
 #include <TextField.h>
+#include <cinder/Timer.h>
+#include <limits>
 
 // Imports
 using namespace ci;
@@ -43,9 +45,107 @@ using namespace ci::app;
 using namespace gl;
 using namespace std;
 
+// Fields with pending changes, and render thread
+set<TextField::Obj *> TextField::Obj::sDirty;
+TextField::Obj::Workers TextField::Obj::sWorkers;
+
+// Render thread starts on first job
+TextField::Obj::Workers::Workers()
+	: mExit(false)
+{
+
+	// Make the text lock now, so it's destroyed after 
+	// this joins the thread that may be holding it
+	GlyphAtlas::getTextMutex();
+
+}
+
+// Stop render thread, if the app hasn't
+TextField::Obj::Workers::~Workers()
+{
+
+	// DO IT!
+	stop();
+
+}
+
+// Stop render thread
+void TextField::Obj::Workers::stop()
+{
+
+	// Wake thread and wait for it to finish
+	{
+		lock_guard<mutex> mLock(mMutex);
+		mExit = true;
+		mJobs.clear();
+	}
+	mWake.notify_all();
+	if (mThread)
+	{
+		mThread->join();
+		mThread.reset();
+	}
+
+}
+
+// Queue render job
+void TextField::Obj::Workers::push(const std::shared_ptr<Job> & job)
+{
+
+	// Start thread. Text rendering is serialized by the 
+	// atlas's text lock, so more threads wouldn't help.
+	{
+		lock_guard<mutex> mLock(mMutex);
+		if (!mThread)
+		{
+			mExit = false;
+			mThread = std::shared_ptr<thread>(new thread(&TextField::Obj::Workers::run, this));
+		}
+		mJobs.push_back(job);
+	}
+	mWake.notify_one();
+
+}
+
+// Render thread loop
+void TextField::Obj::Workers::run()
+{
+
+	while (true)
+	{
+
+		// Wait for a job that's still wanted
+		std::shared_ptr<Job> mJob;
+		{
+			unique_lock<mutex> mLock(mMutex);
+			while (!mExit && (mJobs.empty() || mJobs.front()->mCanceled))
+			{
+				if (!mJobs.empty())
+					mJobs.pop_front();
+				else
+					mWake.wait(mLock);
+			}
+			if (mExit)
+				return;
+			mJob = mJobs.front();
+			mJob->mStarted = true;
+			mJobs.pop_front();
+		}
+
+		// Render and hand back
+		Surface8u mSurface = render(* mJob);
+		lock_guard<mutex> mLock(mMutex);
+		mJob->mSurface = mSurface;
+		mJob->mDone = true;
+
+	}
+
+}
+
 // Constructor
 TextField::Obj::Obj(const Area & area, const Font & font, bool wrap, bool centered) 
-	: mCentered(centered), mFlipped(false), mFont(font), mLeading(font.getLeading()), mWrap(wrap)
+	: mCentered(centered), mFlipped(false), mDirtyFrom(string::npos), mDirtyTail(0), mAsync(false), mPending(false), mFont(font), mLaidOutLength(0), mLeading(font.getLeading()), 
+	mLineCache(false), mBuiltLines(0), mRevision(0), mVertexFrom(string::npos), mVertexTail(0), mWrap(wrap)
 {
 
 	// Set timing properties
@@ -62,11 +162,15 @@ TextField::Obj::~Obj()
 {
 
 	// Clean up
+	cancel();
+	sDirty.erase(this);
 	if (mFont)
 		mFont.reset();
 	if (mTexture)
 		mTexture.reset();
+	mLines.clear();
 	mValue.clear();
+	mVertices.clear();
 
 }
 
@@ -86,8 +190,8 @@ void TextField::Obj::operator +=(const string & value)
 	// Add character
 	if (value.length() > 0)
 	{
+		invalidate(mValue.length());
 		mValue += value;
-		update();
 	}
 
 }
@@ -96,11 +200,14 @@ void TextField::Obj::operator +=(const string & value)
 void TextField::Obj::operator --()
 {
 
-	// DO IT!
+	// Remove last character in place, with its UTF-8 continuation bytes
 	if (mValue.length() > 0) 
 	{
-		mValue = mValue.substr(0, mValue.length() - 1);
-		update();
+		size_t mLength = mValue.length() - 1;
+		while (mLength > 0 && ((uint8_t)mValue[mLength] & 0xc0) == 0x80)
+			mLength--;
+		mValue.erase(mLength);
+		invalidate(mLength);
 	}
 
 }
@@ -123,24 +230,555 @@ bool TextField::Obj::operator !=(const string & value)
 
 }
 
+// Draw text
+void TextField::Obj::draw()
+{
+
+	// Apply pending changes
+	update();
+
+	// Draw lines top down, or bottom up if flipped
+	if (!mAtlas && mLineCache)
+	{
+		float mStep = getLineHeight() + mLeading;
+		for (size_t i = 0; i < mLines.size(); i++)
+		{
+			const Line & mLine = mLines[i];
+			if (!mLine.mTexture)
+				continue;
+			float mY = mFlipped ? (float)mBounds.getHeight() - (float)(i + 1) * mStep : (float)i * mStep;
+			float mX = mCentered ? ((float)mBounds.getWidth() - (float)mLine.mTexture.getWidth()) * 0.5f : 0.0f;
+			gl::draw(mLine.mTexture, Vec2f((float)x1 + mX, (float)y1 + mY));
+		}
+		return;
+	}
+
+	// Draw texture
+	if (!mAtlas)
+	{
+		if (mTexture)
+			gl::draw(mTexture, mBounds);
+		return;
+	}
+
+	// Build vertices if layout has changed
+	buildVertices();
+
+	// Draw each page at field position
+	gl::pushModelView();
+	gl::translate(Vec2f((float)x1, (float)y1));
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	for (size_t i = 0; i < mVertices.size(); i++)
+	{
+		if (mVertices[i].empty())
+			continue;
+		gl::Texture mPage = mAtlas.getTexture((int32_t)i);
+		mPage.enableAndBind();
+		glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &mVertices[i][0].mPosition);
+		glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &mVertices[i][0].mTexCoord);
+		glDrawArrays(GL_TRIANGLES, 0, (GLsizei)mVertices[i].size());
+		mPage.unbind();
+		mPage.disable();
+	}
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	gl::popModelView();
+
+}
+
+// Build vertices for changed lines
+void TextField::Obj::buildVertices()
+{
+
+	// Bail if layout hasn't changed
+	if (!mAtlas || mVertexFrom == string::npos)
+		return;
+
+	// Rebuild from the first changed line up to the lines kept 
+	// at the end, which move if the line count has changed
+	size_t mCount = mLines.size();
+	size_t mFrom = math<size_t>::min(mVertexFrom, mCount);
+	size_t mTail = math<size_t>::min(mVertexTail, mCount - mFrom);
+	float mStep = mAtlas.getLineHeight() + mLeading;
+
+	// Start over if lines are placed from a side that has moved
+	if ((mCentered && mBounds.getWidth() != mBuiltSize.x) || (mFlipped && mBounds.getHeight() != mBuiltSize.y))
+	{
+		mFrom = 0;
+		mTail = 0;
+	}
+
+	// Kept lines move down by the lines added above them. 
+	// Flipped, they're measured from the bottom instead.
+	float mShift = ((float)mCount - (float)mBuiltLines) * mStep;
+	if (mFlipped)
+		mShift = (float)(mBounds.getHeight() - mBuiltSize.y) - mShift;
+
+	// Cut each page back to the lines before the change, 
+	// setting aside those kept at the end
+	size_t mPageCount = (size_t)mAtlas.getPageCount();
+	mVertices.resize(mPageCount);
+	mKeptVertices.resize(mPageCount);
+	for (size_t i = 0; i < mPageCount; i++)
+	{
+		size_t mBegin = 0;
+		size_t mKept = 0;
+		for (size_t j = 0; j < mFrom; j++)
+			if (i < mLines[j].mVertexCounts.size())
+				mBegin += mLines[j].mVertexCounts[i];
+		for (size_t j = mCount - mTail; j < mCount; j++)
+			if (i < mLines[j].mVertexCounts.size())
+				mKept += mLines[j].mVertexCounts[i];
+		vector<Vertex> & mPage = mVertices[i];
+		mKept = math<size_t>::min(mKept, mPage.size() - math<size_t>::min(mBegin, mPage.size()));
+		mKeptVertices[i].assign(mPage.end() - mKept, mPage.end());
+		mPage.resize(math<size_t>::min(mBegin, mPage.size()));
+	}
+
+	// Two triangles per glyph, offset by line
+	float mHeight = (float)mBounds.getHeight();
+	for (size_t i = mFrom; i < mCount - mTail; i++)
+	{
+		Line & mLine = mLines[i];
+		mLine.mVertexCounts.assign(mPageCount, 0);
+		Vec2f mOffset(mCentered ? ((float)mBounds.getWidth() - mLine.mWidth) * 0.5f : 0.0f, (float)i * mStep);
+		for (vector<Quad>::const_iterator mQuad = mLine.mQuads.begin(); mQuad != mLine.mQuads.end(); ++mQuad)
+		{
+
+			// Find corners, mirroring vertically if flipped
+			Rectf mRect = mQuad->mRect.getOffset(mOffset);
+			Rectf mCoords = mQuad->mTexCoords;
+			if (mFlipped)
+			{
+				mRect = Rectf(mRect.x1, mHeight - mRect.y2, mRect.x2, mHeight - mRect.y1);
+				mCoords = Rectf(mCoords.x1, mCoords.y2, mCoords.x2, mCoords.y1);
+			}
+			Vertex mCorners[4];
+			mCorners[0].mPosition = Vec2f(mRect.x1, mRect.y1);
+			mCorners[0].mTexCoord = Vec2f(mCoords.x1, mCoords.y1);
+			mCorners[1].mPosition = Vec2f(mRect.x2, mRect.y1);
+			mCorners[1].mTexCoord = Vec2f(mCoords.x2, mCoords.y1);
+			mCorners[2].mPosition = Vec2f(mRect.x2, mRect.y2);
+			mCorners[2].mTexCoord = Vec2f(mCoords.x2, mCoords.y2);
+			mCorners[3].mPosition = Vec2f(mRect.x1, mRect.y2);
+			mCorners[3].mTexCoord = Vec2f(mCoords.x1, mCoords.y2);
+
+			// Add triangles
+			vector<Vertex> & mPage = mVertices[mQuad->mPage];
+			mPage.push_back(mCorners[0]);
+			mPage.push_back(mCorners[1]);
+			mPage.push_back(mCorners[2]);
+			mPage.push_back(mCorners[0]);
+			mPage.push_back(mCorners[2]);
+			mPage.push_back(mCorners[3]);
+			mLine.mVertexCounts[mQuad->mPage] += 6;
+
+		}
+	}
+
+	// Put kept lines back, moved to their new rows
+	for (size_t i = 0; i < mPageCount; i++)
+	{
+		vector<Vertex> & mKept = mKeptVertices[i];
+		if (mShift != 0.0f)
+			for (vector<Vertex>::iterator mVertex = mKept.begin(); mVertex != mKept.end(); ++mVertex)
+				mVertex->mPosition.y += mShift;
+		mVertices[i].insert(mVertices[i].end(), mKept.begin(), mKept.end());
+	}
+
+	// Vertices are up to date
+	mBuiltLines = mCount;
+	mBuiltSize = mBounds.getSize();
+	mVertexFrom = string::npos;
+
+}
+
+// Drop render job in progress
+void TextField::Obj::cancel()
+{
+
+	// Workers skip canceled jobs
+	if (mJob)
+	{
+		lock_guard<mutex> mLock(sWorkers.mMutex);
+		mJob->mCanceled = true;
+	}
+	mJob.reset();
+	mPending = false;
+
+}
+
+// Mark vertices stale
+void TextField::Obj::dirtyVertices(size_t line, size_t tail)
+{
+
+	// Keep earliest line and shortest tail
+	if (mVertexFrom == string::npos)
+		mVertexTail = tail;
+	mVertexFrom = math<size_t>::min(mVertexFrom, line);
+	mVertexTail = math<size_t>::min(mVertexTail, tail);
+
+}
+
+// Copy settings into render job
+std::shared_ptr<TextField::Obj::Job> TextField::Obj::createJob()
+{
+
+	// DO IT!
+	std::shared_ptr<Job> mJob(new Job());
+	mJob->mCanceled = false;
+	mJob->mCentered = mCentered;
+	mJob->mDone = false;
+	mJob->mStarted = false;
+	mJob->mFont = mFont;
+	mJob->mLeading = mLeading;
+	mJob->mValue = mValue;
+	mJob->mWidth = getWidth();
+	mJob->mWrap = mWrap;
+	return mJob;
+
+}
+
+// Measure code point with TextLayout, between bars 
+// so spaces count
+float TextField::Obj::getAdvance(uint32_t code, const string & text)
+{
+
+	// Look up, or measure on first use
+	map<uint32_t, float>::iterator mAdvance = mAdvances.find(code);
+	if (mAdvance != mAdvances.end())
+		return mAdvance->second;
+	lock_guard<mutex> mLock(GlyphAtlas::getTextMutex());
+	TextLayout mBars;
+	mBars.setFont(mFont);
+	mBars.addLine("||");
+	TextLayout mLayout;
+	mLayout.setFont(mFont);
+	mLayout.addLine("|" + text + "|");
+	float mWidth = (float)(mLayout.render(true, false).getWidth() - mBars.render(true, false).getWidth());
+	mAdvances[code] = mWidth;
+	return mWidth;
+
+}
+
+// Get glyph atlas
+GlyphAtlas TextField::Obj::getAtlas()
+{
+	return mAtlas;
+}
+
 // Get actual render area (width/height excludes transparent pixels)
 Area TextField::Obj::getBounds()
 {
+	update();
 	return mBounds;
 }
 Area TextField::Obj::getBounds() const
 {
+
+	// Layout is a cache, so bringing it up to date is logically const
+	const_cast<Obj *>(this)->update();
 	return mBounds;
+
+}
+
+// Get height of a line, without leading
+float TextField::Obj::getLineHeight()
+{
+	return mAtlas ? mAtlas.getLineHeight() : mFont.getAscent() + mFont.getDescent();
+}
+
+// Get revision
+uint32_t TextField::Obj::getRevision()
+{
+	update();
+	return mRevision;
+}
+
+// Get vertices for page
+const vector<TextField::Vertex> & TextField::Obj::getVertices(int32_t page)
+{
+
+	// Build vertices, returning none for missing pages
+	static const vector<Vertex> sEmpty;
+	update();
+	buildVertices();
+	return page >= 0 && page < (int32_t)mVertices.size() ? mVertices[page] : sEmpty;
+
 }
 
 // Get texture
 gl::Texture TextField::Obj::getTexture()
 {
+	update();
 	return mTexture;
 }
 gl::Texture TextField::Obj::getTexture() const
 {
+	const_cast<Obj *>(this)->update();
+	return mTexture;
+}
+
+// Check if caching lines
+bool TextField::Obj::getLineCache()
+{
+	return mLineCache;
+}
+
+// Check if rendering on workers
+bool TextField::Obj::isAsync()
+{
+	return mAsync;
+}
+
+// Mark text as changed
+void TextField::Obj::invalidate(size_t position, size_t tail)
+{
+
+	// Keep earliest change and shortest unchanged 
+	// tail, and list field for updateAll()
+	if (mDirtyFrom == string::npos)
+	{
+		sDirty.insert(this);
+		mDirtyTail = tail;
+	}
+	mDirtyFrom = math<size_t>::min(mDirtyFrom, position);
+	mDirtyTail = math<size_t>::min(mDirtyTail, tail);
+
+}
+
+// Lay out lines with glyph atlas
+void TextField::Obj::layout(size_t position, size_t tail)
+{
+
+	// Find line holding position. Start a line early, since 
+	// a shorter first word may now fit on the line above.
+	size_t mLineIndex = 0;
+	while (mLineIndex + 1 < mLines.size() && mLines[mLineIndex + 1].mStart <= position)
+		mLineIndex++;
+	if (mLineIndex > 0)
+		mLineIndex--;
+	size_t mPosition = mLineIndex < mLines.size() ? mLines[mLineIndex].mStart : 0;
+
+	// Keep texture of line above edit in case it wraps the same
+	bool mKeepAbove = mLineIndex < mLines.size() && mLines[mLineIndex].mEnd <= position;
+
+	// Old lines starting in the unchanged tail are where they 
+	// were, moved by the change in length. Once a new line starts 
+	// at one of them, the rest wrap the same and are kept.
+	size_t mLength = mValue.length();
+	int64_t mDelta = (int64_t)mLength - (int64_t)mLaidOutLength;
+	size_t mTailStart = mLength - math<size_t>::min(tail, mLength);
+	size_t mOld = mLineIndex;
+	bool mSpliced = false;
+	mWrapped.clear();
+
+	// Wrap at field width, or not at all
+	float mLimit = mWrap ? (float)getWidth() : numeric_limits<float>::max();
+	while (mPosition < mLength)
+	{
+
+		// Stop when back in step with old lines
+		if (mPosition >= mTailStart)
+		{
+			while (mOld < mLines.size() && (int64_t)mLines[mOld].mStart + mDelta < (int64_t)mPosition)
+				mOld++;
+			if (mOld < mLines.size() && (int64_t)mLines[mOld].mStart + mDelta == (int64_t)mPosition)
+			{
+				mSpliced = true;
+				break;
+			}
+		}
+
+		// Start line
+		Line mLine;
+		mLine.mStart = mPosition;
+		mLine.mWidth = 0.0f;
+		float mX = 0.0f;
+
+		// Last place to break, after a space
+		size_t mBreak = string::npos;
+		size_t mBreakQuads = 0;
+		float mBreakWidth = 0.0f;
+
+		// Add glyphs until line is full
+		while (mPosition < mLength)
+		{
+
+			// Break on new lines
+			size_t mNext = mPosition;
+			uint32_t mCode = GlyphAtlas::decode(mValue, mNext);
+			if (mCode == '\n')
+			{
+				mPosition = mNext;
+				break;
+			}
+
+			// Measure with field's atlas, or TextLayout for cached lines
+			string mText = mValue.substr(mPosition, mNext - mPosition);
+			const GlyphAtlas::Glyph * mGlyph = mAtlas ? &mAtlas.getGlyph(mCode, mText) : 0;
+			float mAdvance = mGlyph ? mGlyph->mAdvance : getAdvance(mCode, mText);
+
+			// Wrap at last space, or mid-word if there isn't one
+			if (mX + mAdvance > mLimit && mX > 0.0f && mCode != ' ')
+			{
+				if (mBreak != string::npos)
+				{
+					mLine.mQuads.resize(mBreakQuads);
+					mX = mBreakWidth;
+					mPosition = mBreak;
+				}
+				break;
+			}
+
+			// Add glyph
+			if (mGlyph && mGlyph->mPage >= 0)
+			{
+				Quad mQuad;
+				mQuad.mPage = mGlyph->mPage;
+				mQuad.mRect = Rectf(mX, 0.0f, mX + mGlyph->mSize.x, mGlyph->mSize.y);
+				mQuad.mTexCoords = mGlyph->mTexCoords;
+				mLine.mQuads.push_back(mQuad);
+			}
+			if (mCode == ' ')
+			{
+				mBreak = mNext;
+				mBreakQuads = mLine.mQuads.size();
+				mBreakWidth = mX;
+			}
+			mX += mAdvance;
+			mPosition = mNext;
+
+		}
+
+		// Add line
+		mLine.mEnd = mPosition;
+		mLine.mWidth = mX;
+		if (mKeepAbove && mWrapped.empty() && mLines[mLineIndex].mStart == mLine.mStart && mLines[mLineIndex].mEnd == mLine.mEnd)
+			mLine.mTexture = mLines[mLineIndex].mTexture;
+
+		// Render cached lines now. Kerning can make a line wider 
+		// than its glyphs add up to, so move words down until 
+		// the rendered line fits.
+		if (!mAtlas && !mLine.mTexture)
+		{
+			mLine.mTexture = renderLine(mLine.mStart, mLine.mEnd);
+			while (mLine.mTexture && (float)mLine.mTexture.getWidth() > mLimit)
+			{
+				size_t mLast = mValue.find_last_not_of(" \n", mLine.mEnd - 1);
+				size_t mSpace = mLast == string::npos || mLast <= mLine.mStart ? string::npos : mValue.rfind(' ', mLast);
+				if (mSpace == string::npos || mSpace <= mLine.mStart)
+					break;
+				mLine.mEnd = mSpace + 1;
+				mLine.mTexture = renderLine(mLine.mStart, mLine.mEnd);
+			}
+			mPosition = mLine.mEnd;
+		}
+		if (!mAtlas)
+			mLine.mWidth = mLine.mTexture ? (float)mLine.mTexture.getWidth() : 0.0f;
+		mWrapped.push_back(Line());
+		mWrapped.back().swap(mLine);
+
+	}
+
+	// Move kept lines into place, walking away from 
+	// the side they move toward so none are overwritten
+	size_t mTail = mSpliced ? mLines.size() - mOld : 0;
+	size_t mFirstTail = mLineIndex + mWrapped.size();
+	size_t mCount = mFirstTail + mTail;
+	if (mCount > mLines.size())
+		mLines.resize(mCount);
+	if (mFirstTail > mOld)
+	{
+		for (size_t i = mTail; i > 0; i--)
+			mLines[mFirstTail + i - 1].swap(mLines[mOld + i - 1]);
+	}
+	else if (mFirstTail < mOld)
+	{
+		for (size_t i = 0; i < mTail; i++)
+			mLines[mFirstTail + i].swap(mLines[mOld + i]);
+	}
+	for (size_t i = mFirstTail; i < mCount; i++)
+	{
+		mLines[i].mEnd = (size_t)((int64_t)mLines[i].mEnd + mDelta);
+		mLines[i].mStart = (size_t)((int64_t)mLines[i].mStart + mDelta);
+	}
+
+	// Put new lines in
+	for (size_t i = 0; i < mWrapped.size(); i++)
+		mLines[mLineIndex + i].swap(mWrapped[i]);
+	mLines.resize(mCount);
+	mWrapped.clear();
+
+	// A trailing new line starts an empty line, which 
+	// kept lines already have
+	if (!mSpliced && mLength > 0 && mValue[mLength - 1] == '\n')
+	{
+		Line mLine;
+		mLine.mEnd = mLength;
+		mLine.mStart = mLength;
+		mLine.mWidth = 0.0f;
+		mLines.push_back(mLine);
+	}
+
+	// Rebuild vertices for new lines
+	mLaidOutLength = mLength;
+	dirtyVertices(mLineIndex, mTail);
+
+}
+
+// Render line to its own texture
+gl::Texture TextField::Obj::renderLine(size_t start, size_t end)
+{
+
+	// Render line on its own, without the break
+	string mText = mValue.substr(start, end - start);
+	boost::trim_right(mText);
+	if (mText.empty())
+		return gl::Texture();
+	Surface8u mSurface;
+	{
+		lock_guard<mutex> mLock(GlyphAtlas::getTextMutex());
+		TextLayout mTextLayout;
+		mTextLayout.setColor(Color::white());
+		mTextLayout.setFont(mFont);
+		mTextLayout.addLine(mText);
+		mSurface = mTextLayout.render(true, false);
+	}
+	gl::Texture mTexture(mSurface);
+	mTexture.setFlipped(mFlipped);
 	return mTexture;
+
+}
+
+// Use glyph atlas
+void TextField::Obj::setAtlas(const GlyphAtlas & atlas)
+{
+
+	// Switch modes and update
+	mAtlas = atlas;
+	mLines.clear();
+	mTexture.reset();
+	if (mAtlas)
+		mFont = mAtlas.getFont();
+	invalidate();
+
+}
+
+// Render on workers
+void TextField::Obj::setAsync(bool async)
+{
+
+	// Drop job in progress when turning off, and 
+	// render its text now instead
+	if (!async && mJob)
+	{
+		cancel();
+		invalidate();
+	}
+	mAsync = async;
+
 }
 
 // Flip texture
@@ -149,7 +787,7 @@ void TextField::Obj::setFlipped(bool flip)
 
 	// Change font and update
 	mFlipped = flip;
-	update();
+	invalidate();
 
 }
 
@@ -160,7 +798,23 @@ void TextField::Obj::setFont(const Font & font)
 	// Change font and update
 	mFont = font;
 	mLeading = mFont.getLeading();
-	update();
+	if (mAtlas)
+		mAtlas = GlyphAtlas::create(mFont);
+	mAdvances.clear();
+	mLines.clear();
+	invalidate();
+
+}
+
+// Give lines their own textures
+void TextField::Obj::setLineCache(bool lineCache)
+{
+
+	// Switch modes and update
+	mLineCache = lineCache;
+	mLines.clear();
+	mTexture.reset();
+	invalidate();
 
 }
 
@@ -168,9 +822,10 @@ void TextField::Obj::setFont(const Font & font)
 void TextField::Obj::setLeading(float leading)
 {
 
-	// DO IT!
+	// Lines keep their glyphs, but every line moves
 	mLeading = leading;
-	update();
+	dirtyVertices(0, 0);
+	invalidate(mValue.length());
 
 }
 
@@ -182,7 +837,7 @@ void TextField::Obj::setX(int32_t value)
 	int32_t diff = value - x1; 
 	x1 += diff;
 	x2 += diff;
-	update();
+	updateBounds();
 
 }
 
@@ -194,7 +849,7 @@ void TextField::Obj::setY(int32_t value)
 	int32_t diff = value - y1; 
 	y1 += diff;
 	y2 += diff;
-	update();
+	updateBounds();
 
 }
 
@@ -213,8 +868,7 @@ void TextField::Obj::str(const int_fast8_t * value)
 {
 
 	// Update text
-	mValue = string(value);
-	update();
+	str(string(value));
 
 }
 
@@ -222,65 +876,216 @@ void TextField::Obj::str(const int_fast8_t * value)
 void TextField::Obj::str(const string & value)
 {
 
-	// Update text
-	mValue = value;
-	update();
+	// Keep layout up to where strings differ
+	size_t mSame = 0;
+	size_t mLength = math<size_t>::min(mValue.length(), value.length());
+	while (mSame < mLength && mValue[mSame] == value[mSame])
+		mSame++;
+	if (mSame < mValue.length() || mSame < value.length())
+	{
+
+		// Keep lines at the end, too, up to the changed part
+		size_t mTail = 0;
+		mLength -= mSame;
+		while (mTail < mLength && mValue[mValue.length() - mTail - 1] == value[value.length() - mTail - 1])
+			mTail++;
+		mValue = value;
+		invalidate(mSame, mTail);
+
+	}
 
 }
 
-// Update texture
-void TextField::Obj::update()
+// Render text from position on
+void TextField::Obj::refresh(size_t position, size_t tail)
 {
 
-	// Reset texture
-	mTexture.reset();
+	// Lay out glyphs
+	if (mAtlas)
+	{
+		cancel();
+		layout(position, tail);
+		updateBounds();
+		return;
+	}
 
-	// Check length
-	if (mValue.length() > 0) 
+	// Wrap and render changed lines
+	if (mLineCache)
 	{
+		cancel();
+		layout(position, tail);
+		updateBounds();
+		return;
+	}
 
-		// Word wrapping is on
-		if (mWrap)
+	// Hand off to workers. A queued job takes the new text. 
+	// One that's started is left to finish, so typing can't 
+	// starve the texture, and a follow-up goes out once it's in.
+	if (mAsync)
+	{
+		std::shared_ptr<Job> mNext = createJob();
+		if (mJob)
 		{
+			lock_guard<mutex> mLock(sWorkers.mMutex);
+			if (!mJob->mStarted)
+				* mJob = * mNext;
+			else
+				mPending = true;
+			return;
+		}
+		mJob = mNext;
+		sWorkers.push(mJob);
+		return;
+	}
 
-			// Create multiline text
-			mTextBox = TextBox().alignment(mCentered ? TextBox::CENTER : TextBox::LEFT).font(mFont).size(Vec2i(this->getWidth(), TextBox::GROW)).text(mValue);
-			mTextBox.setColor(ColorAf::white());
-			mTextBox.setBackgroundColor(ColorAf(0.5F, 0.0f, 0.0f, 0.0f));
-			mTexture = gl::Texture(mTextBox.render());
+	// Render now
+	upload(render(* createJob()));
 
-		}
-		else
-		{
+}
 
-			// Create single line text
-			mTextLayout = TextLayout();
-			mTextLayout.setColor(Color::white());
-			mTextLayout.setFont(mFont);
-			mTextLayout.setLeadingOffset(mLeading);
-			if (mCentered)
-				mTextLayout.addCenteredLine(mValue);
-			else
-				mTextLayout.addLine(mValue);
-			mTexture = gl::Texture(mTextLayout.render(true, false));
+// Render text to surface
+Surface8u TextField::Obj::render(const Job & job)
+{
 
-		}
+	// Create minimal surface if string is empty
+	if (job.mValue.length() == 0)
+		return Surface8u(8, 8, true, SurfaceChannelOrder::RGBA);
 
-		// Flip, if needed
-		mTexture.setFlipped(mFlipped);
+	// Take turns with other text rendering
+	lock_guard<mutex> mLock(GlyphAtlas::getTextMutex());
+
+	// Word wrapping is on
+	if (job.mWrap)
+	{
+
+		// Create multiline text
+		TextBox mTextBox = TextBox().alignment(job.mCentered ? TextBox::CENTER : TextBox::LEFT).font(job.mFont).size(Vec2i(job.mWidth, TextBox::GROW)).text(job.mValue);
+		mTextBox.setColor(ColorAf::white());
+		mTextBox.setBackgroundColor(ColorAf(0.5F, 0.0f, 0.0f, 0.0f));
+		return mTextBox.render();
 
 	}
+
+	// Create single line text
+	TextLayout mTextLayout;
+	mTextLayout.setColor(Color::white());
+	mTextLayout.setFont(job.mFont);
+	mTextLayout.setLeadingOffset(job.mLeading);
+	if (job.mCentered)
+		mTextLayout.addCenteredLine(job.mValue);
 	else
+		mTextLayout.addLine(job.mValue);
+	return mTextLayout.render(true, false);
+
+}
+
+// Apply pending changes
+void TextField::Obj::update()
+{
+
+	// Swap in finished render from workers
+	if (mJob)
 	{
+		Surface8u mSurface;
+		{
+			lock_guard<mutex> mLock(sWorkers.mMutex);
+			if (mJob->mDone)
+				mSurface = mJob->mSurface;
+		}
+		if (mSurface)
+		{
+			mJob.reset();
+			upload(mSurface);
+			if (mPending)
+			{
+				mPending = false;
+				mJob = createJob();
+				sWorkers.push(mJob);
+			}
+		}
+	}
 
-		// Create minimal texture if string is empty
-		mTexture.reset();
-		mTexture = gl::Texture(Surface8u(8, 8, true, SurfaceChannelOrder::RGBA));
+	// Render once for all changes since last update
+	if (mDirtyFrom != string::npos)
+	{
+		size_t mPosition = mDirtyFrom;
+		mDirtyFrom = string::npos;
+		refresh(mPosition, mDirtyTail);
+	}
+
+	// Stay listed while a render is in progress
+	if (!mJob)
+		sDirty.erase(this);
+
+}
+
+// Stop render thread
+void TextField::Obj::stopWorkers()
+{
+
+	// DO IT!
+	sWorkers.stop();
+
+}
 
+// Apply pending changes across fields
+void TextField::Obj::updateAll(double budget)
+{
+
+	// Update fields until time runs out, doing at least one. 
+	// Work from a copy, as async fields stay listed.
+	vector<Obj *> mFields(sDirty.begin(), sDirty.end());
+	Timer mTimer;
+	mTimer.start();
+	for (vector<Obj *>::iterator mField = mFields.begin(); mField != mFields.end(); ++mField)
+	{
+		(* mField)->update();
+		if (mTimer.getSeconds() >= budget)
+			break;
 	}
 
+}
+
+// Move surface to texture
+void TextField::Obj::upload(const Surface8u & surface)
+{
+
+	// Write into the old texture if it's the same size
+	if (mTexture && mTexture.getWidth() == surface.getWidth() && mTexture.getHeight() == surface.getHeight())
+		mTexture.update(surface);
+	else
+		mTexture = gl::Texture(surface);
+
+	// Flip, if needed
+	mTexture.setFlipped(mFlipped);
+
 	// Update bounds
-	mBounds = mTexture.getBounds();
-	mBounds.set(mBounds.getX1() + x1, mBounds.getY1() + y1, mBounds.getX2() + x1, mBounds.getY2() + y1);
+	updateBounds();
+
+}
+
+// Update bounds
+void TextField::Obj::updateBounds()
+{
+
+	// Size to lines when using atlas or caching lines
+	if (mAtlas || mLineCache)
+	{
+		float mWidth = mWrap ? (float)getWidth() : 0.0f;
+		if (!mWrap)
+			for (vector<Line>::const_iterator mLine = mLines.begin(); mLine != mLines.end(); ++mLine)
+				mWidth = math<float>::max(mWidth, mLine->mWidth);
+		float mHeight = (float)mLines.size() * (getLineHeight() + mLeading);
+		mBounds.set(x1, y1, x1 + (int32_t)math<float>::ceil(mWidth), y1 + (int32_t)math<float>::ceil(mHeight));
+		mRevision++;
+		return;
+	}
+
+	// Size to texture
+	if (mTexture)
+	{
+		mBounds = mTexture.getBounds();
+		mBounds.set(mBounds.getX1() + x1, mBounds.getY1() + y1, mBounds.getX2() + x1, mBounds.getY2() + y1);
+	}
 
 }
@@ -0,0 +1,174 @@
+/*
+* 
+* Copyright (c) 2011, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/Cinder.h"
+#include "cinder/CinderMath.h"
+#include "cinder/Thread.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Multi-resolution min/max summary of a long recording
+class WaveformCache
+{
+
+private:
+
+	// The object
+	class Obj
+	{
+
+	public:
+
+		// Con/de-structor
+		Obj(int32_t sampleRate, int32_t channelCount, int32_t framesPerBucket);
+		~Obj();
+
+		// Adds interleaved samples to the end of the summary
+		void append(const float * data, int32_t size);
+
+		// Reads a WAV file in chunks and summarizes it
+		bool build(const string & path);
+
+		// Writes or reads sidecar file. Given the source file, load 
+		// fails if it has changed since the summary was built.
+		bool load(const string & path, const string & sourcePath);
+		bool save(const string & path);
+
+		// Fills one min/max pair per pixel for a range of frames
+		void getPeaks(int32_t channel, uint64_t startFrame, uint64_t endFrame, int32_t pixelCount, vector<float> & minimums, vector<float> & maximums);
+
+		// Getters
+		int32_t getChannelCount();
+		uint64_t getFrameCount();
+		int32_t getFramesPerBucket();
+		int32_t getLevelCount();
+		int32_t getSampleRate();
+
+		// Clears summary
+		void clear();
+
+	private:
+
+		// Merges min/max of a run inside one base bucket into every level
+		void addRun(uint64_t startFrame, const int8_t * minMax);
+
+		// Size and modification time of the file last built from, 
+		// or zero if the summary wasn't built from a file
+		int64_t mSourceSize;
+		int64_t mSourceTime;
+
+		// Format
+		int32_t mChannelCount;
+		int32_t mFramesPerBucket;
+		int32_t mSampleRate;
+
+		// Levels, each with half as many buckets as the one below. A 
+		// bucket holds a min/max pair per channel, quantized to 8 bits.
+		// The last bucket of each level may be partial.
+		vector<vector<int8_t> > mLevels;
+		uint64_t mFrameCount;
+
+		// Scratch for current run
+		vector<float> mRunMin;
+		vector<float> mRunMax;
+		vector<int8_t> mRun;
+
+		// Guards format and levels between writer and reader
+		mutex mMutex;
+
+	};
+
+	// Pointer to object
+	std::shared_ptr<Obj> mObj;
+
+public:
+
+	// Constructors
+	WaveformCache() {}
+	WaveformCache(int32_t sampleRate, int32_t channelCount, int32_t framesPerBucket = 256) 
+		: mObj(std::shared_ptr<Obj>(new Obj(sampleRate, channelCount, framesPerBucket))) {}
+	~WaveformCache() { mObj.reset(); }
+
+	// Adds interleaved samples. Signature matches AudioInput callbacks 
+	// so the summary can be built while recording.
+	void append(float * data, int32_t size) { mObj->append(data, size); }
+	void append(const float * data, int32_t size) { mObj->append(data, size); }
+
+	// Summarizes a WAV file without loading it into memory
+	bool build(const string & path) { return mObj->build(path); }
+
+	// Sidecar file
+	bool load(const string & path, const string & sourcePath = "") { return mObj->load(path, sourcePath); }
+	bool save(const string & path) { return mObj->save(path); }
+	static string getSidecarPath(const string & path) { return path + ".peaks"; }
+
+	// Loads sidecar for file, or builds and saves it if there is none 
+	// or the file has changed since
+	bool open(const string & path)
+	{
+		if (mObj->load(getSidecarPath(path), path))
+			return true;
+		if (!mObj->build(path))
+			return false;
+		mObj->save(getSidecarPath(path));
+		return true;
+	}
+
+	// Fills one min/max pair (-1 to 1) per pixel for a range of frames
+	void getPeaks(int32_t channel, uint64_t startFrame, uint64_t endFrame, int32_t pixelCount, vector<float> & minimums, vector<float> & maximums) 
+	{ 
+		mObj->getPeaks(channel, startFrame, endFrame, pixelCount, minimums, maximums); 
+	}
+
+	// Getters
+	int32_t getChannelCount() { return mObj->getChannelCount(); }
+	uint64_t getFrameCount() { return mObj->getFrameCount(); }
+	int32_t getFramesPerBucket() { return mObj->getFramesPerBucket(); }
+	int32_t getLevelCount() { return mObj->getLevelCount(); }
+	int32_t getSampleRate() { return mObj->getSampleRate(); }
+
+	// Clears summary
+	void clear() { mObj->clear(); }
+
+};
@@ -0,0 +1,545 @@
+/*
+ * 
+ * Copyright (c) 2011, Ban the Rewind
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or 
+ * without modification, are permitted provided that the following 
+ * conditions are met:
+ * 
+ * Redistributions of source code must retain the above copyright 
+ * notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright 
+ * notice, this list of conditions and the following disclaimer in 
+ * the documentation and/or other materials provided with the 
+ * distribution.
+ * 
+ * Neither the name of the Ban the Rewind nor the names of its 
+ * contributors may be used to endorse or promote products 
+ * derived from this software without specific prior written 
+ * permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+
+// Include header
+#include "WaveformCache.h"
+#include "boost/filesystem.hpp"
+#include <limits>
+
+// Sidecar file format version
+static const uint32_t SIDECAR_VERSION = 2;
+
+// Reads size and modification time of a file
+static bool getFileStamp(const string & path, int64_t & size, int64_t & time)
+{
+	boost::system::error_code mError;
+	boost::filesystem::path mPath(path);
+	size = (int64_t)boost::filesystem::file_size(mPath, mError);
+	if (mError)
+		return false;
+	time = (int64_t)boost::filesystem::last_write_time(mPath, mError);
+	return !mError;
+}
+
+// Merges pairs of buckets from one level into the next
+static void reduce(const vector<int8_t> & source, vector<int8_t> & destination, int32_t channelCount)
+{
+
+	// Iterate through pairs
+	size_t mStride = channelCount * 2;
+	size_t mCount = source.size() / mStride;
+	destination.resize(((mCount + 1) / 2) * mStride);
+	for (size_t i = 0; i < mCount; i += 2)
+	{
+		const int8_t * mA = &source[i * mStride];
+		const int8_t * mB = i + 1 < mCount ? &source[(i + 1) * mStride] : mA;
+		int8_t * mOut = &destination[(i / 2) * mStride];
+		for (int32_t mChannel = 0; mChannel < channelCount; mChannel++)
+		{
+			mOut[mChannel * 2] = math<int8_t>::min(mA[mChannel * 2], mB[mChannel * 2]);
+			mOut[mChannel * 2 + 1] = math<int8_t>::max(mA[mChannel * 2 + 1], mB[mChannel * 2 + 1]);
+		}
+	}
+
+}
+
+// Constructor
+WaveformCache::Obj::Obj(int32_t sampleRate, int32_t channelCount, int32_t framesPerBucket)
+{
+
+	// Set format
+	mChannelCount = math<int32_t>::max(channelCount, 1);
+	mFramesPerBucket = math<int32_t>::max(framesPerBucket, 1);
+	mSampleRate = sampleRate;
+
+	// Initialize
+	mFrameCount = 0;
+	mSourceSize = 0;
+	mSourceTime = 0;
+	mRunMin.resize(mChannelCount);
+	mRunMax.resize(mChannelCount);
+	mRun.resize(mChannelCount * 2);
+
+}
+
+// Destructor
+WaveformCache::Obj::~Obj()
+{
+
+	// Clean up
+	mLevels.clear();
+
+}
+
+// Merge run into every level
+void WaveformCache::Obj::addRun(uint64_t startFrame, const int8_t * minMax)
+{
+
+	// Start finest level
+	if (mLevels.empty())
+		mLevels.push_back(vector<int8_t>());
+
+	// Walk up levels until one holds a single bucket
+	size_t mStride = mChannelCount * 2;
+	uint64_t mBucket = startFrame / (uint64_t)mFramesPerBucket;
+	for (size_t mLevel = 0; ; mLevel++)
+	{
+
+		// A new top level is reduced from the one below it, which 
+		// already includes this run
+		if (mLevel == mLevels.size())
+		{
+			mLevels.push_back(vector<int8_t>());
+			reduce(mLevels[mLevel - 1], mLevels[mLevel], mChannelCount);
+		}
+		else
+		{
+
+			// Start a bucket or merge into the partial one
+			vector<int8_t> & mData = mLevels[mLevel];
+			size_t mIndex = (size_t)(mBucket >> mLevel) * mStride;
+			if (mIndex >= mData.size())
+			{
+				mData.insert(mData.end(), minMax, minMax + mStride);
+			}
+			else
+			{
+				for (int32_t mChannel = 0; mChannel < mChannelCount; mChannel++)
+				{
+					mData[mIndex + mChannel * 2] = math<int8_t>::min(mData[mIndex + mChannel * 2], minMax[mChannel * 2]);
+					mData[mIndex + mChannel * 2 + 1] = math<int8_t>::max(mData[mIndex + mChannel * 2 + 1], minMax[mChannel * 2 + 1]);
+				}
+			}
+
+		}
+
+		// Stop at the top
+		if (mLevels[mLevel].size() <= mStride)
+			break;
+
+	}
+
+}
+
+// Add interleaved samples
+void WaveformCache::Obj::append(const float * data, int32_t size)
+{
+
+	// Bail if no data
+	if (data == 0 || size <= 0)
+		return;
+
+	// Split data into runs which end on base bucket boundaries
+	lock_guard<mutex> mLock(mMutex);
+	int32_t mFrameTotal = size / mChannelCount;
+	int32_t mFrame = 0;
+	while (mFrame < mFrameTotal)
+	{
+
+		// Find extent of run
+		int32_t mOffset = (int32_t)(mFrameCount % (uint64_t)mFramesPerBucket);
+		int32_t mRunFrames = math<int32_t>::min(mFrameTotal - mFrame, mFramesPerBucket - mOffset);
+
+		// Find min and max of run
+		fill(mRunMin.begin(), mRunMin.end(), numeric_limits<float>::max());
+		fill(mRunMax.begin(), mRunMax.end(), -numeric_limits<float>::max());
+		const float * mSample = data + mFrame * mChannelCount;
+		for (int32_t i = 0; i < mRunFrames; i++)
+		{
+			for (int32_t mChannel = 0; mChannel < mChannelCount; mChannel++, mSample++)
+			{
+				mRunMin[mChannel] = math<float>::min(mRunMin[mChannel], * mSample);
+				mRunMax[mChannel] = math<float>::max(mRunMax[mChannel], * mSample);
+			}
+		}
+
+		// Quantize outward so peaks are never clipped
+		for (int32_t mChannel = 0; mChannel < mChannelCount; mChannel++)
+		{
+			mRun[mChannel * 2] = (int8_t)math<float>::clamp(math<float>::floor(mRunMin[mChannel] * 127.0f), -127.0f, 127.0f);
+			mRun[mChannel * 2 + 1] = (int8_t)math<float>::clamp(math<float>::ceil(mRunMax[mChannel] * 127.0f), -127.0f, 127.0f);
+		}
+
+		// Add to levels
+		addRun(mFrameCount, &mRun[0]);
+		mFrameCount += mRunFrames;
+		mFrame += mRunFrames;
+
+	}
+
+}
+
+// Summarize WAV file
+bool WaveformCache::Obj::build(const string & path)
+{
+
+	// Stamp file before reading, so a file still being written 
+	// won't match once it has grown
+	int64_t mStampSize = 0;
+	int64_t mStampTime = 0;
+	if (!getFileStamp(path, mStampSize, mStampTime))
+		return false;
+
+	// Open file
+	ifstream mFile(path.c_str(), ios::binary);
+	if (!mFile.is_open())
+		return false;
+
+	// Check RIFF header
+	char mId[4];
+	uint32_t mSize = 0;
+	mFile.read(mId, 4);
+	mFile.read(reinterpret_cast<char *>(&mSize), 4);
+	if (!mFile.good() || memcmp(mId, "RIFF", 4) != 0)
+		return false;
+	mFile.read(mId, 4);
+	if (!mFile.good() || memcmp(mId, "WAVE", 4) != 0)
+		return false;
+
+	// Find format and data chunks
+	uint16_t mFormat = 0;
+	uint16_t mChannels = 0;
+	uint32_t mRate = 0;
+	uint16_t mBits = 0;
+	uint32_t mDataSize = 0;
+	bool mHasData = false;
+	while (!mHasData && mFile.good())
+	{
+		mFile.read(mId, 4);
+		mFile.read(reinterpret_cast<char *>(&mSize), 4);
+		if (!mFile.good())
+			break;
+		if (memcmp(mId, "fmt ", 4) == 0)
+		{
+			uint32_t mByteRate = 0;
+			uint16_t mBlockAlign = 0;
+			mFile.read(reinterpret_cast<char *>(&mFormat), 2);
+			mFile.read(reinterpret_cast<char *>(&mChannels), 2);
+			mFile.read(reinterpret_cast<char *>(&mRate), 4);
+			mFile.read(reinterpret_cast<char *>(&mByteRate), 4);
+			mFile.read(reinterpret_cast<char *>(&mBlockAlign), 2);
+			mFile.read(reinterpret_cast<char *>(&mBits), 2);
+			mFile.seekg(mSize - 16 + (mSize & 1), ios::cur);
+		}
+		else if (memcmp(mId, "data", 4) == 0)
+		{
+			mDataSize = mSize;
+			mHasData = true;
+		}
+		else
+		{
+			mFile.seekg(mSize + (mSize & 1), ios::cur);
+		}
+	}
+
+	// Support 8, 16 and 32-bit PCM and 32-bit float
+	bool mFloat = mFormat == 3;
+	if (!mHasData || mChannels == 0 || (mFormat != 1 && mFormat != 3 && mFormat != 0xFFFE) || 
+		(mBits != 8 && mBits != 16 && mBits != 32) || (mFloat && mBits != 32))
+		return false;
+
+	// Reset for new format
+	{
+		lock_guard<mutex> mLock(mMutex);
+		mChannelCount = mChannels;
+		mSampleRate = mRate;
+		mFrameCount = 0;
+		mLevels.clear();
+		mSourceSize = mStampSize;
+		mSourceTime = mStampTime;
+		mRunMin.resize(mChannelCount);
+		mRunMax.resize(mChannelCount);
+		mRun.resize(mChannelCount * 2);
+	}
+
+	// A file still being recorded may have no length yet, so read 
+	// until end of file when the size is missing
+	uint64_t mRemaining = mDataSize > 0 ? mDataSize : numeric_limits<uint64_t>::max();
+
+	// Read and summarize in chunks
+	int32_t mBytesPerSample = mBits / 8;
+	int32_t mChunkSamples = 16384 * mChannelCount;
+	vector<char> mBytes(mChunkSamples * mBytesPerSample);
+	vector<float> mSamples(mChunkSamples);
+	while (mRemaining > 0 && mFile.good())
+	{
+
+		// Read whole frames
+		size_t mRequest = (size_t)math<uint64_t>::min((uint64_t)mBytes.size(), mRemaining);
+		mFile.read(&mBytes[0], mRequest);
+		int32_t mCount = (int32_t)(mFile.gcount() / (mBytesPerSample * mChannelCount)) * mChannelCount;
+		if (mCount <= 0)
+			break;
+		mRemaining -= math<uint64_t>::min((uint64_t)mFile.gcount(), mRemaining);
+
+		// Normalize
+		switch (mBits)
+		{
+		case 8:
+			for (int32_t i = 0; i < mCount; i++)
+				mSamples[i] = (float)((uint8_t)mBytes[i] - 0x80) / (float)0x80;
+			break;
+		case 16:
+			for (int32_t i = 0; i < mCount; i++)
+				mSamples[i] = (float)(reinterpret_cast<int16_t *>(&mBytes[0])[i]) / (float)0x8000;
+			break;
+		case 32:
+			if (mFloat)
+				memcpy(&mSamples[0], &mBytes[0], mCount * sizeof(float));
+			else
+				for (int32_t i = 0; i < mCount; i++)
+					mSamples[i] = (float)((double)(reinterpret_cast<int32_t *>(&mBytes[0])[i]) / (8.0 * 0x10000000));
+			break;
+		}
+
+		// Add to summary
+		append(&mSamples[0], mCount);
+
+	}
+
+	// Return success
+	return true;
+
+}
+
+// Clear summary
+void WaveformCache::Obj::clear()
+{
+
+	// DO IT!
+	lock_guard<mutex> mLock(mMutex);
+	mLevels.clear();
+	mFrameCount = 0;
+	mSourceSize = 0;
+	mSourceTime = 0;
+
+}
+
+// Returns channel count
+int32_t WaveformCache::Obj::getChannelCount()
+{
+	lock_guard<mutex> mLock(mMutex);
+	return mChannelCount;
+}
+
+// Returns number of frames summarized
+uint64_t WaveformCache::Obj::getFrameCount()
+{
+	lock_guard<mutex> mLock(mMutex);
+	return mFrameCount;
+}
+
+// Returns frames per bucket on finest level
+int32_t WaveformCache::Obj::getFramesPerBucket()
+{
+	lock_guard<mutex> mLock(mMutex);
+	return mFramesPerBucket;
+}
+
+// Returns number of levels
+int32_t WaveformCache::Obj::getLevelCount()
+{
+	lock_guard<mutex> mLock(mMutex);
+	return (int32_t)mLevels.size();
+}
+
+// Fill min/max pairs for range
+void WaveformCache::Obj::getPeaks(int32_t channel, uint64_t startFrame, uint64_t endFrame, int32_t pixelCount, vector<float> & minimums, vector<float> & maximums)
+{
+
+	// Clear output
+	pixelCount = math<int32_t>::max(pixelCount, 0);
+	minimums.assign(pixelCount, 0.0f);
+	maximums.assign(pixelCount, 0.0f);
+
+	// Bail if nothing to show
+	lock_guard<mutex> mLock(mMutex);
+	if (mLevels.empty() || pixelCount == 0 || endFrame <= startFrame || channel < 0 || channel >= mChannelCount)
+		return;
+
+	// Use the coarsest level whose buckets are no wider than a pixel, 
+	// so each pixel reads at most a few buckets
+	double mFramesPerPixel = (double)(endFrame - startFrame) / (double)pixelCount;
+	size_t mLevel = 0;
+	while (mLevel + 1 < mLevels.size() && (double)((uint64_t)mFramesPerBucket << (mLevel + 1)) <= mFramesPerPixel)
+		mLevel++;
+	uint64_t mBucketFrames = (uint64_t)mFramesPerBucket << mLevel;
+	const vector<int8_t> & mData = mLevels[mLevel];
+	size_t mStride = mChannelCount * 2;
+	uint64_t mBucketCount = mData.size() / mStride;
+
+	// Iterate through pixels
+	for (int32_t i = 0; i < pixelCount; i++)
+	{
+
+		// Find buckets under pixel
+		uint64_t mStart = startFrame + (uint64_t)(mFramesPerPixel * (double)i);
+		uint64_t mEnd = math<uint64_t>::max(startFrame + (uint64_t)(mFramesPerPixel * (double)(i + 1)), mStart + 1);
+		uint64_t mFirst = mStart / mBucketFrames;
+		uint64_t mLast = math<uint64_t>::min((mEnd - 1) / mBucketFrames, mBucketCount - 1);
+		if (mFirst >= mBucketCount)
+			break;
+
+		// Combine them
+		int8_t mMin = 127;
+		int8_t mMax = -127;
+		for (uint64_t j = mFirst; j <= mLast; j++)
+		{
+			mMin = math<int8_t>::min(mMin, mData[(size_t)j * mStride + channel * 2]);
+			mMax = math<int8_t>::max(mMax, mData[(size_t)j * mStride + channel * 2 + 1]);
+		}
+		minimums[i] = (float)mMin / 127.0f;
+		maximums[i] = (float)mMax / 127.0f;
+
+	}
+
+}
+
+// Returns sample rate
+int32_t WaveformCache::Obj::getSampleRate()
+{
+	lock_guard<mutex> mLock(mMutex);
+	return mSampleRate;
+}
+
+// Read sidecar file
+bool WaveformCache::Obj::load(const string & path, const string & sourcePath)
+{
+
+	// Find what the source looks like now
+	int64_t mStampSize = 0;
+	int64_t mStampTime = 0;
+	if (!sourcePath.empty() && !getFileStamp(sourcePath, mStampSize, mStampTime))
+		return false;
+
+	// Open file
+	ifstream mFile(path.c_str(), ios::binary);
+	if (!mFile.is_open())
+		return false;
+
+	// Read header
+	char mMagic[4];
+	uint32_t mVersion = 0;
+	uint32_t mChannels = 0;
+	uint32_t mRate = 0;
+	uint32_t mBucketFrames = 0;
+	int64_t mSourceBytes = 0;
+	int64_t mSourceModified = 0;
+	uint64_t mFrames = 0;
+	uint64_t mSize = 0;
+	mFile.read(mMagic, 4);
+	mFile.read(reinterpret_cast<char *>(&mVersion), 4);
+	mFile.read(reinterpret_cast<char *>(&mChannels), 4);
+	mFile.read(reinterpret_cast<char *>(&mRate), 4);
+	mFile.read(reinterpret_cast<char *>(&mBucketFrames), 4);
+	mFile.read(reinterpret_cast<char *>(&mSourceBytes), 8);
+	mFile.read(reinterpret_cast<char *>(&mSourceModified), 8);
+	mFile.read(reinterpret_cast<char *>(&mFrames), 8);
+	mFile.read(reinterpret_cast<char *>(&mSize), 8);
+	if (!mFile.good() || memcmp(mMagic, "BTRW", 4) != 0 || mVersion != SIDECAR_VERSION || mChannels == 0 || mBucketFrames == 0 || 
+		mSize != ((mFrames + mBucketFrames - 1) / mBucketFrames) * mChannels * 2)
+		return false;
+
+	// A summary of another version of the source is stale. One not 
+	// built from a file can't be checked, so it's stale too.
+	if (!sourcePath.empty() && (mSourceModified == 0 || mSourceBytes != mStampSize || mSourceModified != mStampTime))
+		return false;
+
+	// Read finest level
+	vector<int8_t> mBase((size_t)mSize);
+	if (mSize > 0)
+		mFile.read(reinterpret_cast<char *>(&mBase[0]), (streamsize)mSize);
+	if ((uint64_t)mFile.gcount() != mSize)
+		return false;
+
+	// Rebuild coarser levels, which is cheap next to reading the audio
+	lock_guard<mutex> mLock(mMutex);
+	mChannelCount = mChannels;
+	mSampleRate = mRate;
+	mFramesPerBucket = mBucketFrames;
+	mFrameCount = mFrames;
+	mSourceSize = mSourceBytes;
+	mSourceTime = mSourceModified;
+	mRunMin.resize(mChannelCount);
+	mRunMax.resize(mChannelCount);
+	mRun.resize(mChannelCount * 2);
+	mLevels.clear();
+	if (mSize > 0)
+	{
+		mLevels.push_back(mBase);
+		while (mLevels.back().size() > (size_t)mChannelCount * 2)
+		{
+			mLevels.push_back(vector<int8_t>());
+			reduce(mLevels[mLevels.size() - 2], mLevels.back(), mChannelCount);
+		}
+	}
+
+	// Return success
+	return true;
+
+}
+
+// Write sidecar file
+bool WaveformCache::Obj::save(const string & path)
+{
+
+	// Open file
+	ofstream mFile(path.c_str(), ios::binary | ios::trunc);
+	if (!mFile.is_open())
+		return false;
+
+	// Only the finest level is written. The rest are rebuilt on load.
+	lock_guard<mutex> mLock(mMutex);
+	uint32_t mChannels = mChannelCount;
+	uint32_t mRate = mSampleRate;
+	uint32_t mBucketFrames = mFramesPerBucket;
+	uint64_t mSize = mLevels.empty() ? 0 : mLevels[0].size();
+	mFile.write("BTRW", 4);
+	mFile.write(reinterpret_cast<const char *>(&SIDECAR_VERSION), 4);
+	mFile.write(reinterpret_cast<const char *>(&mChannels), 4);
+	mFile.write(reinterpret_cast<const char *>(&mRate), 4);
+	mFile.write(reinterpret_cast<const char *>(&mBucketFrames), 4);
+	mFile.write(reinterpret_cast<const char *>(&mSourceSize), 8);
+	mFile.write(reinterpret_cast<const char *>(&mSourceTime), 8);
+	mFile.write(reinterpret_cast<const char *>(&mFrameCount), 8);
+	mFile.write(reinterpret_cast<const char *>(&mSize), 8);
+	if (mSize > 0)
+		mFile.write(reinterpret_cast<const char *>(&mLevels[0][0]), (streamsize)mSize);
+
+	// Return success
+	return mFile.good();
+
+}